@@ -0,0 +1,94 @@
+#include "AllocationTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    thread_local AllocationTracker::Subsystem currentSubsystem = AllocationTracker::Subsystem::ENGINE;
+    thread_local AllocationTracker::Counters frameCounters[AllocationTracker::NUM_SUBSYSTEMS];
+
+    std::atomic<size_t> totalAllocations[AllocationTracker::NUM_SUBSYSTEMS];
+    std::atomic<size_t> totalBytes[AllocationTracker::NUM_SUBSYSTEMS];
+
+    const char* SUBSYSTEM_NAMES[AllocationTracker::NUM_SUBSYSTEMS] = {
+        "engine", "input", "track", "scene", "render", "capture"
+    };
+
+    void* trackedAllocate(const size_t size) {
+        const int subsystem = static_cast<int>(currentSubsystem);
+        frameCounters[subsystem].allocations++;
+        frameCounters[subsystem].bytes += size;
+        totalAllocations[subsystem].fetch_add(1, std::memory_order_relaxed);
+        totalBytes[subsystem].fetch_add(size, std::memory_order_relaxed);
+        // malloc(0) may return null, operator new must not
+        return malloc(size > 0 ? size : 1);
+    }
+}
+
+//*************************************************************************************
+//
+// Global allocation functions, the array and sized forms forward to these
+
+void* operator new(size_t size)
+{
+    void* pMemory = trackedAllocate(size);
+    if (!pMemory) throw std::bad_alloc();
+    return pMemory;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return trackedAllocate(size);
+}
+
+void operator delete(void* pMemory) noexcept { free(pMemory); }
+void operator delete(void* pMemory, size_t) noexcept { free(pMemory); }
+void operator delete(void* pMemory, const std::nothrow_t&) noexcept { free(pMemory); }
+
+//*************************************************************************************
+
+const char* AllocationTracker::getName(const Subsystem subsystem)
+{
+    return SUBSYSTEM_NAMES[static_cast<int>(subsystem)];
+}
+
+AllocationTracker::Scope::Scope(const Subsystem subsystem)
+    : _previous(currentSubsystem)
+{
+    currentSubsystem = subsystem;
+}
+
+AllocationTracker::Scope::~Scope()
+{
+    currentSubsystem = _previous;
+}
+
+void AllocationTracker::beginFrame()
+{
+    for (Counters& counters : frameCounters) {
+        counters = Counters();
+    }
+}
+
+AllocationTracker::Counters AllocationTracker::getFrameCounters(const Subsystem subsystem)
+{
+    return frameCounters[static_cast<int>(subsystem)];
+}
+
+size_t AllocationTracker::getFrameAllocations()
+{
+    size_t allocations = 0;
+    for (const Counters& counters : frameCounters) {
+        allocations += counters.allocations;
+    }
+    return allocations;
+}
+
+AllocationTracker::Counters AllocationTracker::getTotalCounters(const Subsystem subsystem)
+{
+    Counters counters;
+    counters.allocations = totalAllocations[static_cast<int>(subsystem)].load(std::memory_order_relaxed);
+    counters.bytes = totalBytes[static_cast<int>(subsystem)].load(std::memory_order_relaxed);
+    return counters;
+}
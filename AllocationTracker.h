@@ -0,0 +1,61 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstddef>
+
+/// \desc Counts every heap allocation made through operator new.  Allocations are charged to
+/// the subsystem of the innermost Scope on the allocating thread, and counted both in process
+/// wide totals per subsystem and in per thread frame counters, which the render thread reads
+/// to check that a frame in steady state never touches the heap.  Linking AllocationTracker.cpp
+/// replaces the global operator new and delete, so only the engine executable includes it
+namespace AllocationTracker {
+    /// \desc parts of the engine allocations are charged to
+    enum class Subsystem {
+        /// \desc anything outside a more specific scope
+        ENGINE = 0,
+        /// \desc polling, recording and replaying input
+        INPUT = 1,
+        /// \desc loading, watching and rebuilding the track
+        TRACK = 2,
+        /// \desc simulation and scene updates
+        SCENE = 3,
+        /// \desc drawing and post-processing
+        RENDER = 4,
+        /// \desc reading back and writing captured frames
+        CAPTURE = 5
+    };
+    constexpr int NUM_SUBSYSTEMS = 6;
+
+    /// \desc printable name of a subsystem
+    const char* getName(Subsystem subsystem);
+
+    /// \desc charges allocations on this thread to a subsystem while in scope
+    class Scope {
+    public:
+        explicit Scope(Subsystem subsystem);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Subsystem _previous;
+    };
+
+    /// \desc allocations and bytes requested
+    struct Counters {
+        size_t allocations = 0;
+        size_t bytes = 0;
+    };
+
+    /// \desc zeroes this thread's frame counters
+    void beginFrame();
+    /// \desc what this thread allocated since beginFrame(), for one subsystem
+    Counters getFrameCounters(Subsystem subsystem);
+    /// \desc allocations this thread made since beginFrame(), across every subsystem
+    size_t getFrameAllocations();
+    /// \desc everything every thread allocated since the process started, for one subsystem
+    Counters getTotalCounters(Subsystem subsystem);
+}
+
+#endif // ALLOCATION_TRACKER_H
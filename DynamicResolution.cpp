@@ -0,0 +1,191 @@
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+DynamicResolution::DynamicResolution()
+    : _budget(1000.0f / 60.0f),
+      _scale(1.0f),
+      _gpuMilliseconds(0.0f),
+      _framebuffer(0),
+      _colorTexture(0),
+      _depthRenderbuffer(0),
+      _targetWidth(0),
+      _targetHeight(0),
+      _renderWidth(0),
+      _renderHeight(0),
+      _generation(0),
+      _activeQuery(NUM_QUERIES),
+      _nextQuery(0),
+      _upscaleProgram(nullptr),
+      _sceneTextureLocation(-1),
+      _texelSizeLocation(-1),
+      _renderedSizeLocation(-1),
+      _sharpnessLocation(-1),
+      _vao(0)
+{
+    for (GLuint i = 0; i < NUM_QUERIES; i++) {
+        _queries[i] = 0;
+        _queryPending[i] = false;
+        _queryGeneration[i] = 0;
+    }
+}
+
+DynamicResolution::~DynamicResolution()
+{
+    glDeleteFramebuffers(1, &_framebuffer);
+    glDeleteTextures(1, &_colorTexture);
+    glDeleteRenderbuffers(1, &_depthRenderbuffer);
+    glDeleteQueries(NUM_QUERIES, _queries);
+    glDeleteVertexArrays(1, &_vao);
+    delete _upscaleProgram;
+}
+
+bool DynamicResolution::setup()
+{
+    _upscaleProgram = new CSCI441::ShaderProgram("shaders/fp-fullscreen.v.glsl", "shaders/fp-upscale.f.glsl");
+    _sceneTextureLocation = _upscaleProgram->getUniformLocation("sceneTexture");
+    _texelSizeLocation = _upscaleProgram->getUniformLocation("texelSize");
+    _renderedSizeLocation = _upscaleProgram->getUniformLocation("renderedSize");
+    _sharpnessLocation = _upscaleProgram->getUniformLocation("sharpness");
+    if (_sceneTextureLocation < 0 || _renderedSizeLocation < 0) {
+        fprintf(stderr, "[ERROR]: Could not build the upscale shader program\n");
+        return false;
+    }
+
+    glGenQueries(NUM_QUERIES, _queries);
+    glGenVertexArrays(1, &_vao);
+    glGenFramebuffers(1, &_framebuffer);
+    glGenTextures(1, &_colorTexture);
+    glGenRenderbuffers(1, &_depthRenderbuffer);
+    return true;
+}
+
+void DynamicResolution::beginFrame(const GLint windowWidth, const GLint windowHeight, GLint& renderWidth, GLint& renderHeight)
+{
+    _readTimers();
+
+    // a minimized window reports a zero sized framebuffer
+    const GLint width = std::max(1, windowWidth);
+    const GLint height = std::max(1, windowHeight);
+    if (width != _targetWidth || height != _targetHeight) {
+        _resizeTarget(width, height);
+    }
+    _renderWidth = std::max(1, static_cast<GLint>(lroundf(width * _scale)));
+    _renderHeight = std::max(1, static_cast<GLint>(lroundf(height * _scale)));
+    renderWidth = _renderWidth;
+    renderHeight = _renderHeight;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+
+    // skip timing this frame rather than wait on a query the GPU has not reached yet
+    _activeQuery = NUM_QUERIES;
+    if (!_queryPending[_nextQuery]) {
+        _activeQuery = _nextQuery;
+        _nextQuery = (_nextQuery + 1) % NUM_QUERIES;
+        glBeginQuery(GL_TIME_ELAPSED, _queries[_activeQuery]);
+    }
+}
+
+void DynamicResolution::endFrame()
+{
+    if (_activeQuery < NUM_QUERIES) {
+        glEndQuery(GL_TIME_ELAPSED);
+        _queryPending[_activeQuery] = true;
+        _queryGeneration[_activeQuery] = _generation;
+    }
+
+    if (_renderWidth == _targetWidth && _renderHeight == _targetHeight) {
+        // nothing to upscale, a straight copy is cheapest
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, _framebuffer);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, _renderWidth, _renderHeight, 0, 0, _targetWidth, _targetHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, _targetWidth, _targetHeight);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    _upscaleProgram->useProgram();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _colorTexture);
+    _upscaleProgram->setProgramUniform(_sceneTextureLocation, 0);
+    _upscaleProgram->setProgramUniform(_texelSizeLocation, glm::vec2(1.0f / _targetWidth, 1.0f / _targetHeight));
+    _upscaleProgram->setProgramUniform(_renderedSizeLocation,
+                                       glm::vec2(static_cast<GLfloat>(_renderWidth) / _targetWidth,
+                                                 static_cast<GLfloat>(_renderHeight) / _targetHeight));
+    _upscaleProgram->setProgramUniform(_sharpnessLocation, SHARPNESS);
+    glBindVertexArray(_vao);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glEnable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void DynamicResolution::_resizeTarget(const GLint width, const GLint height)
+{
+    _targetWidth = width;
+    _targetHeight = height;
+
+    glBindTexture(GL_TEXTURE_2D, _colorTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, _depthRenderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _colorTexture, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, _depthRenderbuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "[ERROR]: Dynamic resolution target %dx%d is incomplete\n", width, height);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::_readTimers()
+{
+    // oldest first, so the smoothed time follows the order frames were drawn in
+    for (GLuint n = 0; n < NUM_QUERIES; n++) {
+        const GLuint query = (_nextQuery + n) % NUM_QUERIES;
+        if (!_queryPending[query]) continue;
+
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(_queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) break;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(_queries[query], GL_QUERY_RESULT, &nanoseconds);
+        _queryPending[query] = false;
+        if (_queryGeneration[query] == _generation) {
+            _updateScale(static_cast<GLfloat>(nanoseconds * 1e-6));
+        }
+    }
+}
+
+void DynamicResolution::_updateScale(const GLfloat milliseconds)
+{
+    _gpuMilliseconds = _gpuMilliseconds > 0.0f ? _gpuMilliseconds + SMOOTHING * (milliseconds - _gpuMilliseconds) : milliseconds;
+
+    // hold the scale while the scene time sits inside the band below the budget
+    if (_gpuMilliseconds <= _budget && _gpuMilliseconds >= _budget * HEADROOM_FRACTION) return;
+    if (_gpuMilliseconds > _budget && _scale <= MIN_SCALE) return;
+    if (_gpuMilliseconds < _budget && _scale >= 1.0f) return;
+
+    // fragment cost follows the pixel count, the square of the per axis scale
+    GLfloat scale = _scale * sqrtf(_budget * TARGET_FRACTION / _gpuMilliseconds);
+    scale = std::clamp(scale, _scale * MAX_STEP_DOWN, _scale * MAX_STEP_UP);
+    scale = std::clamp(scale, MIN_SCALE, 1.0f);
+    if (fabsf(scale - _scale) < 0.01f) return;
+
+    _scale = scale;
+    _gpuMilliseconds = 0.0f;
+    _generation++;
+}
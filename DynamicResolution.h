@@ -0,0 +1,108 @@
+#ifndef DYNAMIC_RESOLUTION_H
+#define DYNAMIC_RESOLUTION_H
+
+#include <CSCI441/ShaderProgram.hpp>
+
+#include <glad/gl.h>
+
+/// \class DynamicResolution
+/// \desc Renders the scene into an offscreen target whose resolution follows a GPU frame time
+/// budget, then upscales it into the window.  The scene pass is timed with GL_TIME_ELAPSED
+/// queries kept in a small ring, so results are read a few frames late without stalling the
+/// pipeline.  When the scene runs over budget the render scale drops; once it has headroom the
+/// scale creeps back up.  The upscale pass smooths along edges rather than across them and
+/// restores local contrast, clamped to the neighbourhood so it cannot ring
+class DynamicResolution {
+public:
+    /// \desc creates the controller, call setup() once a context is current
+    DynamicResolution();
+    /// \desc releases the offscreen target, timer queries and upscale program
+    ~DynamicResolution();
+
+    DynamicResolution(const DynamicResolution&) = delete;
+    DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+    /// \desc compiles the upscale program and creates the timer queries
+    /// \returns false if the GL objects could not be created
+    bool setup();
+
+    /// \desc sets the GPU time the scene pass should fit in
+    /// \param milliseconds frame time budget, e.g. 16.7 for 60Hz
+    void setFrameBudget(GLfloat milliseconds) { _budget = milliseconds; }
+
+    /// \desc binds the offscreen target and starts timing the scene pass.  The target follows
+    /// the window size; the scene is drawn into its lower left renderWidth x renderHeight pixels
+    /// \param windowWidth framebuffer width of the window
+    /// \param windowHeight framebuffer height of the window
+    /// \param [out] renderWidth width to render the scene at this frame
+    /// \param [out] renderHeight height to render the scene at this frame
+    void beginFrame(GLint windowWidth, GLint windowHeight, GLint& renderWidth, GLint& renderHeight);
+    /// \desc stops timing and upscales the scene into the window's back buffer, which is left bound
+    void endFrame();
+
+    /// \desc fraction of the window resolution the scene is rendered at, per axis
+    [[nodiscard]] GLfloat getScale() const { return _scale; }
+    /// \desc smoothed GPU time of the scene pass at the current scale, 0 until measured
+    [[nodiscard]] GLfloat getGPUMilliseconds() const { return _gpuMilliseconds; }
+
+    /// \desc lowest render scale, per axis
+    static constexpr GLfloat MIN_SCALE = 0.5f;
+
+private:
+    /// \desc (re)allocates the offscreen target at the window size
+    void _resizeTarget(GLint width, GLint height);
+    /// \desc collects every finished timer query and feeds it to the controller
+    void _readTimers();
+    /// \desc moves the render scale towards the budget given a measured scene time
+    void _updateScale(GLfloat milliseconds);
+
+    /// \desc queries in flight, enough that a result is ready before its query is reused
+    static constexpr GLuint NUM_QUERIES = 4;
+    /// \desc the scale aims for this fraction of the budget, leaving room for spikes
+    static constexpr GLfloat TARGET_FRACTION = 0.85f;
+    /// \desc the scale is only raised when the scene takes less than this fraction of the budget
+    static constexpr GLfloat HEADROOM_FRACTION = 0.65f;
+    /// \desc largest relative change of the scale per adjustment, down and up.  Dropping is
+    /// faster than recovering so a spike is answered quickly without oscillating afterwards
+    static constexpr GLfloat MAX_STEP_DOWN = 0.75f;
+    static constexpr GLfloat MAX_STEP_UP = 1.1f;
+    /// \desc weight of the newest measurement in the smoothed scene time
+    static constexpr GLfloat SMOOTHING = 0.3f;
+    /// \desc contrast restored by the upscale pass, 0 to 1
+    static constexpr GLfloat SHARPNESS = 0.4f;
+
+    GLfloat _budget;
+    GLfloat _scale;
+    GLfloat _gpuMilliseconds;
+
+    GLuint _framebuffer;
+    GLuint _colorTexture;
+    GLuint _depthRenderbuffer;
+    /// \desc allocated size of the offscreen target, the window size
+    GLint _targetWidth;
+    GLint _targetHeight;
+    /// \desc size the scene is rendered at this frame
+    GLint _renderWidth;
+    GLint _renderHeight;
+
+    GLuint _queries[NUM_QUERIES];
+    /// \desc true while a query's result has not been read back
+    bool _queryPending[NUM_QUERIES];
+    /// \desc scale generation a query was issued under, results from before the last scale
+    /// change describe a different resolution and are dropped
+    GLuint _queryGeneration[NUM_QUERIES];
+    GLuint _generation;
+    /// \desc query timing the current frame, NUM_QUERIES if every query is still in flight
+    GLuint _activeQuery;
+    GLuint _nextQuery;
+
+    CSCI441::ShaderProgram* _upscaleProgram;
+    GLint _sceneTextureLocation;
+    GLint _texelSizeLocation;
+    GLint _renderedSizeLocation;
+    GLint _sharpnessLocation;
+    /// \desc empty VAO for the bufferless fullscreen triangle
+    GLuint _vao;
+};
+
+#endif // DYNAMIC_RESOLUTION_H
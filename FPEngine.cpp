@@ -4,6 +4,7 @@
 
 #include <glm/gtc/type_ptr.hpp>  // for glm::value_ptr()
 
+#include <algorithm>
 #include <ctime>
 #include <iostream>
 #include <stb_image.h>
@@ -17,6 +18,9 @@
 #define M_PI 3.14159265f
 #endif
 
+/// \desc track loaded when no other is chosen
+const char* DEFAULT_TRACK_FILE = "data/rollercoaster.csv";
+
 /// \desc Simple helper function to return a random number between 0.0f and 1.0f.
 GLfloat getRand()
 {
@@ -44,14 +48,133 @@ FPEngine::FPEngine()
         _ibos[i] = 0;
         _numVAOPoints[i] = 0;
     }
+
+    _dirtyControlPointBegin = 0;
+    _dirtyControlPointEnd = 0;
+
+    _pTrackWatcher = nullptr;
+    _frameBudget = 0.0f;
+    _pDynamicResolution = nullptr;
+    _glitchActive = false;
+    _glitchScale = 0.5f;
+    _pGlitchEffect = nullptr;
+    _pFrameCapture = nullptr;
+    _offline = false;
+    _offlineSucceeded = false;
+    currBezierIndex = 0;
+    _selectedControlPoint = -1;
+    _frameNumber = 0;
+    _heroSteps = 0;
+    _frameStep = REPLAY_TIMESTEP;
+    _simulationTime = 0.0f;
+    _trackFilename = DEFAULT_TRACK_FILE;
+    _cartJumped = false;
+    _pTerrain = nullptr;
+    _occlusionCulling = true;
+    _pGeometryPool = nullptr;
+    _multiDrawIndirect = true;
+    _gpuTrackBuilder = false;
+    _pTrackBuilder = nullptr;
+    _pBeamBatch = nullptr;
+    _pControlPointBatch = nullptr;
+    _entityMVPMatrices = nullptr;
+    _entityModelViewMatrices = nullptr;
+    _entityUniformsFirst = 0;
+    _renderOrigin = glm::dvec3(0.0);
+    _checkAllocations = false;
+    _steadyStateFrame = ALLOCATION_WARMUP_FRAMES;
+    _numAllocatingFrames = 0;
+    _defaultLightColor = glm::vec3(1.0f, 1.0f, 1.0f);
+    _riderCameraIndex = -1;
 }
 
 FPEngine::~FPEngine()
 {
-    delete _pArcballCam;
+    // the cameras and anything else still in _objectPool are destroyed with it
+    free(_bezierCurve.controlPoints);
 }
 
 void FPEngine::handleKeyEvent(GLint key, GLint action)
+{
+    if (_inputRecorder.getMode() == InputRecorder::Mode::REPLAY)
+    {
+        // live input is ignored while replaying, other than quitting early
+        if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) setWindowShouldClose();
+        return;
+    }
+    _inputRecorder.recordInput(_frameNumber, InputRecorder::KEY_EVENT, key, action);
+    _processKeyEvent(key, action);
+}
+
+void FPEngine::handleMouseButtonEvent(GLint button, GLint action)
+{
+    if (_inputRecorder.getMode() == InputRecorder::Mode::REPLAY) return;
+    _inputRecorder.recordInput(_frameNumber, InputRecorder::MOUSE_BUTTON_EVENT, button, action);
+    _processMouseButtonEvent(button, action);
+}
+
+void FPEngine::handleCursorPositionEvent(glm::vec2 currMousePosition)
+{
+    if (_inputRecorder.getMode() == InputRecorder::Mode::REPLAY) return;
+    _inputRecorder.recordCursor(_frameNumber, currMousePosition.x, currMousePosition.y);
+    _processCursorPositionEvent(currMousePosition);
+}
+
+void FPEngine::setTrackFile(const char* FILENAME)
+{
+    _trackFilename = FILENAME;
+}
+
+GLuint FPEngine::getLapFrames(const char* FILENAME, const GLuint framesPerSecond)
+{
+    std::vector<glm::vec3> controlPoints;
+    if (!TrackGeometry::loadControlPoints(FILENAME ? FILENAME : DEFAULT_TRACK_FILE, controlPoints)) return 0;
+    return _lapFrames((controlPoints.size() - 1) / 3, framesPerSecond);
+}
+
+GLuint FPEngine::_lapFrames(const GLuint numCurves, const GLuint framesPerSecond)
+{
+    return static_cast<GLuint>(ceil(numCurves * SAMPLES_PER_CURVE * static_cast<double>(REPLAY_TIMESTEP) * framesPerSecond));
+}
+
+bool FPEngine::recordInput(const char* FILENAME)
+{
+    return _inputRecorder.startRecording(FILENAME);
+}
+
+bool FPEngine::replayInput(const char* FILENAME)
+{
+    return _inputRecorder.startReplay(FILENAME);
+}
+
+bool FPEngine::logFrameTimes(const char* FILENAME)
+{
+    return _inputRecorder.startFrameTimeLog(FILENAME);
+}
+
+void FPEngine::_dispatchInputEvent(const InputRecorder::InputEvent& event)
+{
+    switch (event.type)
+    {
+    case InputRecorder::KEY_EVENT:
+        _processKeyEvent(event.input[0], event.input[1]);
+        break;
+    case InputRecorder::MOUSE_BUTTON_EVENT:
+        _processMouseButtonEvent(event.input[0], event.input[1]);
+        break;
+    case InputRecorder::CURSOR_POSITION_EVENT:
+        _processCursorPositionEvent(glm::vec2(event.position[0], event.position[1]));
+        break;
+    case InputRecorder::FRAME_EVENT:
+        // the recording's clock, so everything timed by it moves as it did live
+        _simulationTime = event.timing[0];
+        _frameStep = event.timing[1];
+        break;
+    default: break;
+    }
+}
+
+void FPEngine::_processKeyEvent(GLint key, GLint action)
 {
     if (key != GLFW_KEY_UNKNOWN)
         if (key == GLFW_KEY_COMMA || key == GLFW_KEY_PERIOD || key == GLFW_KEY_SPACE || key == GLFW_KEY_F)
@@ -78,17 +201,42 @@ void FPEngine::handleKeyEvent(GLint key, GLint action)
     }
 }
 
-void FPEngine::handleMouseButtonEvent(GLint button, GLint action)
+void FPEngine::_processMouseButtonEvent(GLint button, GLint action)
 {
     // if the event is for the left mouse button
     if (button == GLFW_MOUSE_BUTTON_LEFT)
     {
         // update the left mouse button's state
         _leftMouseButtonState = action;
+
+        if (action == GLFW_PRESS && _mousePosition.x != MOUSE_UNINITIALIZED)
+        {
+            glm::vec3 rayOrigin, rayDirection;
+            _computeMouseRay(_mousePosition, rayOrigin, rayDirection);
+
+            TrackBVH::Hit hit;
+            if (controlPoints && _controlPointBVH.intersectRay(rayOrigin, rayDirection, hit))
+            {
+                // grab the control point and drag it across the plane facing the camera
+                _selectedControlPoint = hit.primitive;
+                _dragPlanePoint = _bezierCurve.controlPoints[hit.primitive];
+                _dragPlaneNormal = -rayDirection;
+            }
+            else if (_keys[GLFW_KEY_LEFT_CONTROL] && !animate && _trackBVH.intersectRay(rayOrigin, rayDirection, hit))
+            {
+                // snap the cart to the clicked spot on the track
+                currBezierIndex = hit.segmentT < 0.5f ? hit.primitive : hit.primitive + 1;
+                _cartJumped = true;
+            }
+        }
+        else if (action == GLFW_RELEASE)
+        {
+            _selectedControlPoint = -1;
+        }
     }
 }
 
-void FPEngine::handleCursorPositionEvent(glm::vec2 currMousePosition)
+void FPEngine::_processCursorPositionEvent(glm::vec2 currMousePosition)
 {
     // if mouse hasn't moved in the window, prevent camera from flipping out
     if (_mousePosition.x == MOUSE_UNINITIALIZED)
@@ -96,7 +244,23 @@ void FPEngine::handleCursorPositionEvent(glm::vec2 currMousePosition)
         _mousePosition = currMousePosition;
     }
 
-    if (_leftMouseButtonState == GLFW_PRESS)
+    if (_leftMouseButtonState == GLFW_PRESS && _selectedControlPoint >= 0)
+    {
+        // move the selected control point to where the cursor ray meets its drag plane
+        glm::vec3 rayOrigin, rayDirection;
+        _computeMouseRay(currMousePosition, rayOrigin, rayDirection);
+
+        GLfloat denominator = glm::dot(rayDirection, _dragPlaneNormal);
+        if (fabs(denominator) > 1e-6f)
+        {
+            GLfloat t = glm::dot(_dragPlanePoint - rayOrigin, _dragPlaneNormal) / denominator;
+            if (t > 0.0f)
+            {
+                setControlPoint(_selectedControlPoint, rayOrigin + t * rayDirection);
+            }
+        }
+    }
+    else if (_leftMouseButtonState == GLFW_PRESS)
     {
         if (cameraIndex == 0)
         {
@@ -139,18 +303,242 @@ void FPEngine::handleCursorPositionEvent(glm::vec2 currMousePosition)
     _mousePosition = currMousePosition;
 }
 
+//*************************************************************************************
+//
+// Track Editing
+
+void FPEngine::setControlPoint(GLuint index, glm::vec3 position)
+{
+    if (index >= _bezierCurve.numControlPoints) return;
+
+    _bezierCurve.controlPoints[index] = position;
+    if (index < _controlPointEntities.count) {
+        _scene.setTranslation(_controlPointEntities.first + index, position);
+        _pControlPointBatch->markDirty(index);
+    }
+
+    if (_dirtyControlPointBegin >= _dirtyControlPointEnd) {
+        _dirtyControlPointBegin = index;
+        _dirtyControlPointEnd = index + 1;
+    } else {
+        _dirtyControlPointBegin = std::min(_dirtyControlPointBegin, index);
+        _dirtyControlPointEnd = std::max(_dirtyControlPointEnd, index + 1);
+    }
+
+    // curve i uses control points 3i .. 3i + 3, so a shared end point dirties both neighbours
+    GLuint firstCurve = index >= 3 ? (index - 1) / 3 : 0;
+    GLuint lastCurve = std::min(index / 3, _bezierCurve.numCurves - 1);
+    for (GLuint i = firstCurve; i <= lastCurve; i++) {
+        _dirtyCurves[i] = true;
+    }
+}
+
+glm::vec3 FPEngine::getControlPoint(GLuint index) const
+{
+    return _bezierCurve.controlPoints[index];
+}
+
+void FPEngine::_applyTrackEdits()
+{
+    if (_dirtyControlPointBegin >= _dirtyControlPointEnd) return;
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::TRACK);
+
+    // control points feed the cage and the tessellated monorail directly
+    glBindBuffer(GL_ARRAY_BUFFER, _vbos[VAO_ID::BEZIER_CAGE]);
+    glBufferSubData(GL_ARRAY_BUFFER,
+                    _dirtyControlPointBegin * sizeof(glm::vec3),
+                    (_dirtyControlPointEnd - _dirtyControlPointBegin) * sizeof(glm::vec3),
+                    &_bezierCurve.controlPoints[_dirtyControlPointBegin]);
+    _controlPointBVH.refit(_bezierCurve.controlPoints, _dirtyControlPointBegin, _dirtyControlPointEnd - 1);
+    _dirtyControlPointBegin = 0;
+    _dirtyControlPointEnd = 0;
+
+    // resample only the dirty curves
+    GLuint firstSample = _bezierCurve.curvePoints.size();
+    GLuint lastSample = 0;
+    glBindBuffer(GL_ARRAY_BUFFER, _vbos[VAO_ID::BEZIER_CURVE]);
+    for (GLuint i = 0; i < _bezierCurve.numCurves; i++) {
+        if (!_dirtyCurves[i]) continue;
+        _dirtyCurves[i] = false;
+
+        GLuint curveStart = i * SAMPLES_PER_CURVE;
+        TrackGeometry::sampleCurve(_bezierCurve.controlPoints, i, CURVE_RESOLUTION, &_bezierCurve.curvePoints[curveStart]);
+        if (!_pTrackBuilder) {
+            glBufferSubData(GL_ARRAY_BUFFER, curveStart * sizeof(glm::vec3), SAMPLES_PER_CURVE * sizeof(glm::vec3),
+                            &_bezierCurve.curvePoints[curveStart]);
+        }
+
+        firstSample = std::min(firstSample, curveStart);
+        lastSample = std::max(lastSample, curveStart + SAMPLES_PER_CURVE - 1);
+    }
+    if (firstSample > lastSample) return;
+
+    // the GPU resamples its copy from the control points just uploaded, clean curves in between included
+    const GLuint firstCurve = firstSample / SAMPLES_PER_CURVE;
+    const GLuint lastCurve = lastSample / SAMPLES_PER_CURVE;
+    if (_pTrackBuilder) {
+        _pTrackBuilder->sampleCurves(_vbos[VAO_ID::BEZIER_CAGE], _vbos[VAO_ID::BEZIER_CURVE],
+                                     firstCurve, lastCurve + 1 - firstCurve);
+    }
+
+    // turn the ring frames at the changed curves' end points onto their new tangents
+    TrackGeometry::updateKnotNormals(_bezierCurve.curvePoints.data(), _bezierCurve.numCurves, CURVE_RESOLUTION,
+                                     firstCurve, lastCurve, _knotNormals.data());
+    glBindBuffer(GL_ARRAY_BUFFER, _vbos[VAO_ID::MONO_RAIL_PATCHES]);
+    glBufferSubData(GL_ARRAY_BUFFER, 3 * firstCurve * sizeof(glm::vec3), (3 * (lastCurve + 1 - firstCurve) + 1) * sizeof(glm::vec3),
+                    &_knotNormals[3 * firstCurve]);
+
+    _computeArcLengths(firstSample);
+    // segment i spans samples i and i + 1
+    _trackBVH.refit(_bezierCurve.curvePoints.data(), firstSample > 0 ? firstSample - 1 : 0, lastSample);
+    if (_monorailChunks.empty()) return;
+
+    // a ring reads its own sample, the next one, and the previous one across a repeated sample, and
+    // blends the knot normals at both ends of its curve, so the curves either side change too
+    GLuint firstRing = firstCurve > 0 ? (firstCurve - 1) * SAMPLES_PER_CURVE : 0;
+    GLuint lastRing = std::min((lastCurve + 2) * SAMPLES_PER_CURVE - 1, (GLuint)_bezierCurve.curvePoints.size() - 1);
+
+    // boundary rings belong to two chunks, so step back one ring before dividing
+    GLuint firstChunk = firstRing > 0 ? (firstRing - 1) / MONORAIL_CHUNK_RINGS : 0;
+    GLuint lastChunk = std::min(lastRing / MONORAIL_CHUNK_RINGS, (GLuint)_monorailChunks.size() - 1);
+
+    // re-sweep and re-quantize the touched chunks in place; their vertex counts never change
+    if (_pTrackBuilder) {
+        for (GLuint c = firstChunk; c <= lastChunk; c++) {
+            _layoutMonorailChunk(c);
+        }
+        _pTrackBuilder->sweepChunks(_vbos[VAO_ID::BEZIER_CURVE], _bezierCurve.curvePoints.size(),
+                                    _vbos[VAO_ID::MONO_RAIL_PATCHES], _vbos[VAO_ID::MONO_RAIL],
+                                    firstChunk, lastChunk - firstChunk + 1, &_monorailChunks[firstChunk].bounds, sizeof(MonorailChunk));
+    } else {
+        std::vector<PackedVertex> chunkVertices;
+        glBindBuffer(GL_ARRAY_BUFFER, _vbos[VAO_ID::MONO_RAIL]);
+        for (GLuint c = firstChunk; c <= lastChunk; c++) {
+            _buildMonorailChunk(c, chunkVertices);
+            glBufferSubData(GL_ARRAY_BUFFER, _monorailChunks[c].baseVertex * sizeof(PackedVertex),
+                            chunkVertices.size() * sizeof(PackedVertex), chunkVertices.data());
+        }
+    }
+
+    // support beams standing under a changed sample
+    for (GLuint beam = (firstSample + BEAM_SPACING - 1) / BEAM_SPACING;
+         beam < _beamEntities.count && beam * BEAM_SPACING <= lastSample; beam++) {
+        _placeBeam(beam);
+    }
+}
+
+void FPEngine::_computeArcLengths(GLuint firstSample)
+{
+    _arcLengths.resize(_bezierCurve.curvePoints.size());
+    TrackGeometry::computeArcLengths(_bezierCurve.curvePoints.data(), _bezierCurve.curvePoints.size(), firstSample, _arcLengths.data());
+    _trackZones.setTrackLength(_arcLengths.empty() ? 0.0f : _arcLengths.back());
+}
+
+GLuint FPEngine::_sampleAtArcLength(GLfloat arcLength) const
+{
+    if (_arcLengths.empty()) return 0;
+
+    // first sample at or past the distance, then step back if the one before it is closer
+    auto it = std::lower_bound(_arcLengths.begin(), _arcLengths.end(), arcLength);
+    if (it == _arcLengths.end()) return _arcLengths.size() - 1;
+    if (it != _arcLengths.begin() && arcLength - *(it - 1) < *it - arcLength) --it;
+    return it - _arcLengths.begin();
+}
+
+void FPEngine::_reloadTrack(const std::vector<glm::vec3>& controlPoints)
+{
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::TRACK);
+    // a new track may size its buffers before the frames settle again
+    _steadyStateFrame = _frameNumber + ALLOCATION_WARMUP_FRAMES;
+
+    // where the cart is as a fraction of the old track length
+    GLfloat cartFraction = 0.0f;
+    if (!_arcLengths.empty() && _arcLengths.back() > 0.0f && currBezierIndex < (int)_arcLengths.size()) {
+        cartFraction = _arcLengths[currBezierIndex] / _arcLengths.back();
+    }
+
+    if (controlPoints.size() == _bezierCurve.numControlPoints) {
+        // same shape of track: patch only the points that moved
+        GLuint numChanged = 0;
+        for (GLuint i = 0; i < controlPoints.size(); i++) {
+            if (controlPoints[i] != _bezierCurve.controlPoints[i]) {
+                setControlPoint(i, controlPoints[i]);
+                numChanged++;
+            }
+        }
+        if (numChanged == 0) return;
+        const bool parkChanged = _fitParkToTrack();
+        _applyTrackEdits();
+        if (parkChanged) {
+            // the ground moved under every beam, not just those of the changed curves
+            _createTerrain();
+            for (GLuint beam = 0; beam < _beamEntities.count; beam++) {
+                _placeBeam(beam);
+            }
+        }
+        fprintf(stdout, "[INFO]: track reloaded, %u control points changed\n", numChanged);
+    } else {
+        // curves were added or removed: rebuild every track buffer
+        free(_bezierCurve.controlPoints);
+        _bezierCurve.numControlPoints = controlPoints.size();
+        _bezierCurve.numCurves = (_bezierCurve.numControlPoints - 1) / 3;
+        _bezierCurve.controlPoints = (glm::vec3*)malloc(sizeof(glm::vec3) * _bezierCurve.numControlPoints);
+        std::copy(controlPoints.begin(), controlPoints.end(), _bezierCurve.controlPoints);
+
+        _dirtyCurves.assign(_bezierCurve.numCurves, false);
+        _dirtyControlPointBegin = 0;
+        _dirtyControlPointEnd = 0;
+        if (_fitParkToTrack()) _createTerrain();
+
+        _createCage(_vaos[VAO_ID::BEZIER_CAGE], _vbos[VAO_ID::BEZIER_CAGE], _numVAOPoints[VAO_ID::BEZIER_CAGE]);
+        _createCurve(_vaos[VAO_ID::BEZIER_CURVE], _vbos[VAO_ID::BEZIER_CURVE], _numVAOPoints[VAO_ID::BEZIER_CURVE]);
+        _createTrackEntities();
+        _createMonorail(_vaos[VAO_ID::MONO_RAIL], _vbos[VAO_ID::MONO_RAIL], _ibos[VAO_ID::MONO_RAIL]);
+        _createMonorailPatches(_vaos[VAO_ID::MONO_RAIL_PATCHES], _vbos[VAO_ID::BEZIER_CAGE], _vbos[VAO_ID::MONO_RAIL_PATCHES], _ibos[VAO_ID::MONO_RAIL_PATCHES], _numVAOPoints[VAO_ID::MONO_RAIL_PATCHES]);
+        fprintf(stdout, "[INFO]: track reloaded with %u curves\n", _bezierCurve.numCurves);
+    }
+
+    // keep the ride going from the same fraction of the new track
+    if (!_arcLengths.empty()) {
+        currBezierIndex = _sampleAtArcLength(cartFraction * _arcLengths.back());
+        _cartJumped = true;
+    }
+}
+
 //*************************************************************************************
 //
 // Engine Setup
 
 void FPEngine::mSetupGLFW()
 {
+    // offline workers only need the context, they render offscreen, so their window is never
+    // shown.  The hint must be set before the base class creates the window, and hints need
+    // GLFW initialized, which the base class then leaves as it is
+    if (_offline)
+    {
+        glfwInit();
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    }
+
     CSCI441::OpenGLEngine::mSetupGLFW();
 
     // set our callbacks
     glfwSetKeyCallback(mpWindow, a3_engine_keyboard_callback);
     glfwSetMouseButtonCallback(mpWindow, a3_engine_mouse_button_callback);
     glfwSetCursorPosCallback(mpWindow, a3_engine_cursor_callback);
+
+    // cursor rays depend on the window size, so a replay runs at the size it was recorded at
+    GLint windowWidth, windowHeight;
+    if (_inputRecorder.getMode() == InputRecorder::Mode::REPLAY)
+    {
+        _inputRecorder.getWindowSize(windowWidth, windowHeight);
+        glfwSetWindowSize(mpWindow, windowWidth, windowHeight);
+    }
+    else
+    {
+        glfwGetWindowSize(mpWindow, &windowWidth, &windowHeight);
+        _inputRecorder.setWindowSize(windowWidth, windowHeight);
+    }
 }
 
 void FPEngine::mSetupOpenGL()
@@ -162,42 +550,14 @@ void FPEngine::mSetupOpenGL()
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // use one minus blending equation
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // clear the frame buffer to black
+
+    _framePacer.setup();
 }
 
 void FPEngine::mSetupShaders()
 {
-
-    _regularShaderProgram = new CSCI441::ShaderProgram("shaders/fp-std.v.glsl", "shaders/fp-std.f.glsl");
-    // query uniform locations
-    _regularShaderUniformLocations.mvpMatrix = _regularShaderProgram->getUniformLocation("mvpMatrix");
-    _regularShaderUniformLocations.modelViewMtx = _regularShaderProgram->getUniformLocation("modelViewMtx");
-    _regularShaderUniformLocations.time = _regularShaderProgram->getUniformLocation("time");
-    _regularShaderUniformLocations.useLight = _regularShaderProgram->getUniformLocation("useLight");
-    // TODO #12A - texture map
-    _regularShaderUniformLocations.useTexture = _regularShaderProgram->getUniformLocation("useTexture");
-    _regularShaderUniformLocations.materialColor = _regularShaderProgram->getUniformLocation("materialColor");
-    _regularShaderUniformLocations.normalMatrix = _regularShaderProgram->getUniformLocation("normalMatrix");
-    _regularShaderUniformLocations.cameraPos = _regularShaderProgram->getUniformLocation("cameraPos");
-    // LIGHT
-    // directional
-    _regularShaderUniformLocations.lightDirection = _regularShaderProgram->getUniformLocation("lightDirection");
-    _regularShaderUniformLocations.lightColor = _regularShaderProgram->getUniformLocation("lightColor");
-    // spotlight
-    _regularShaderUniformLocations.spotlightDir = _regularShaderProgram->getUniformLocation("spotlightDir");
-    _regularShaderUniformLocations.spotlightPos = _regularShaderProgram->getUniformLocation("spotlightPos");
-    _regularShaderUniformLocations.spotlightColor = _regularShaderProgram->getUniformLocation("spotlightColor");
-    _regularShaderUniformLocations.spotlightOuterCutOff = _regularShaderProgram->getUniformLocation("spotlightOuterCutOff");
-    _regularShaderUniformLocations.spotlightCutOff = _regularShaderProgram->getUniformLocation("spotlightCutOff");
-    
-    // query attribute locations
-    _regularShaderAttributeLocations.vPos = _regularShaderProgram->getAttributeLocation("vPos");
-    _regularShaderAttributeLocations.vNormal = _regularShaderProgram->getAttributeLocation("vNormal");
-    // TODO #12B - texture coordinate
-    _regularShaderAttributeLocations.texCoord = _regularShaderProgram->getAttributeLocation("textCoord");
-    // set static uniforms
-    // TODO #13 - set uniform
-    _regularShaderProgram->setProgramUniform("textureMap", 0);
-
+    _regularShaderProgram = _createSceneShaderProgram("shaders/fp-std.v.glsl", nullptr, "shaders/fp-std.f.glsl",
+                                                      _regularShaderUniformLocations, _regularShaderAttributeLocations);
 
     // hook up the CSCI441 object library to our shader program - MUST be done after the shader is used and before the objects are drawn
     // if we have multiple shaders the flow would be:
@@ -213,91 +573,174 @@ void FPEngine::mSetupShaders()
                                          _regularShaderAttributeLocations.vNormal,
                                          _regularShaderAttributeLocations.texCoord);
 
+    /* ######## TESSELLATED MONORAIL SHADER ######## */
+    _monorailShaderProgram = _createMonorailShaderProgram(nullptr, _monorailShaderUniformLocations, _monorailTessUniformLocations);
+    _tessellatedMonorail = true;
 
+    /* ######## MULTI-VIEW SHADERS ######## */
+    // the same vertex and fragment stages, so the attribute locations match the programs above
+    _regularMultiViewShaderProgram = _createSceneShaderProgram("shaders/fp-std.v.glsl", "shaders/fp-multiview.g.glsl", "shaders/fp-std.f.glsl",
+                                                               _regularMultiViewShaderUniformLocations, _regularMultiViewShaderAttributeLocations);
+    _monorailMultiViewShaderProgram = _createMonorailShaderProgram("shaders/fp-multiview.g.glsl",
+                                                                   _monorailMultiViewShaderUniformLocations, _monorailMultiViewTessUniformLocations);
+    _multiView = false;
 
-    /* ######## GLITCHED SHADER ######## */
-    _glitchedShaderProgram = new CSCI441::ShaderProgram("shaders/fp-glitched.v.glsl", "shaders/fp-glitched.f.glsl");
-    // query uniform locations
-    _glitchedShaderUniformLocations.mvpMatrix = _glitchedShaderProgram->getUniformLocation("mvpMatrix");
-    _glitchedShaderUniformLocations.modelViewMtx = _glitchedShaderProgram->getUniformLocation("modelViewMtx");
-    _glitchedShaderUniformLocations.time = _glitchedShaderProgram->getUniformLocation("time");
-    _glitchedShaderUniformLocations.useLight = _glitchedShaderProgram->getUniformLocation("useLight");
+    _selectShaderPrograms(false);
+}
 
+CSCI441::ShaderProgram* FPEngine::_createSceneShaderProgram(const char* vertexShaderFilename, const char* geometryShaderFilename,
+                                                            const char* fragmentShaderFilename,
+                                                            shaderUniformLocations& uniformLocations,
+                                                            shaderAttributeLocations& attributeLocations)
+{
+    auto shaderProgram = geometryShaderFilename
+        ? new CSCI441::ShaderProgram(vertexShaderFilename, nullptr, nullptr, geometryShaderFilename, fragmentShaderFilename)
+        : new CSCI441::ShaderProgram(vertexShaderFilename, fragmentShaderFilename);
+    // query uniform locations
+    uniformLocations.mvpMatrix = shaderProgram->getUniformLocation("mvpMatrix");
+    uniformLocations.modelViewMtx = shaderProgram->getUniformLocation("modelViewMtx");
+    uniformLocations.useLight = shaderProgram->getUniformLocation("useLight");
     // TODO #12A - texture map
-    _glitchedShaderUniformLocations.useTexture = _glitchedShaderProgram->getUniformLocation("useTexture");
-    _glitchedShaderUniformLocations.materialColor = _glitchedShaderProgram->getUniformLocation("materialColor");
-    _glitchedShaderUniformLocations.normalMatrix = _glitchedShaderProgram->getUniformLocation("normalMatrix");
-    _glitchedShaderUniformLocations.cameraPos = _glitchedShaderProgram->getUniformLocation("cameraPos");
+    uniformLocations.useTexture = shaderProgram->getUniformLocation("useTexture");
+    uniformLocations.materialColor = shaderProgram->getUniformLocation("materialColor");
+    uniformLocations.normalMatrix = shaderProgram->getUniformLocation("normalMatrix");
+    uniformLocations.cameraPos = shaderProgram->getUniformLocation("cameraPos");
+    uniformLocations.positionOffset = shaderProgram->getUniformLocation("positionOffset");
+    uniformLocations.positionScale = shaderProgram->getUniformLocation("positionScale");
     // LIGHT
     // directional
-    _glitchedShaderUniformLocations.lightDirection = _glitchedShaderProgram->getUniformLocation("lightDirection");
-    _glitchedShaderUniformLocations.lightColor = _glitchedShaderProgram->getUniformLocation("lightColor");
+    uniformLocations.lightDirection = shaderProgram->getUniformLocation("lightDirection");
+    uniformLocations.lightColor = shaderProgram->getUniformLocation("lightColor");
     // spotlight
-    _glitchedShaderUniformLocations.spotlightDir = _glitchedShaderProgram->getUniformLocation("spotlightDir");
-    _glitchedShaderUniformLocations.spotlightPos = _glitchedShaderProgram->getUniformLocation("spotlightPos");
-    _glitchedShaderUniformLocations.spotlightColor = _glitchedShaderProgram->getUniformLocation("spotlightColor");
-    _glitchedShaderUniformLocations.spotlightOuterCutOff = _glitchedShaderProgram->getUniformLocation("spotlightOuterCutOff");
-    _glitchedShaderUniformLocations.spotlightCutOff = _glitchedShaderProgram->getUniformLocation("spotlightCutOff");
-    
+    uniformLocations.spotlightDir = shaderProgram->getUniformLocation("spotlightDir");
+    uniformLocations.spotlightPos = shaderProgram->getUniformLocation("spotlightPos");
+    uniformLocations.spotlightColor = shaderProgram->getUniformLocation("spotlightColor");
+    uniformLocations.spotlightOuterCutOff = shaderProgram->getUniformLocation("spotlightOuterCutOff");
+    uniformLocations.spotlightCutOff = shaderProgram->getUniformLocation("spotlightCutOff");
+    // multi-view
+    uniformLocations.viewProjMatrices = geometryShaderFilename ? shaderProgram->getUniformLocation("viewProjMatrices") : -1;
+    uniformLocations.cameraPositions = geometryShaderFilename ? shaderProgram->getUniformLocation("cameraPositions") : -1;
+    uniformLocations.numViews = geometryShaderFilename ? shaderProgram->getUniformLocation("numViews") : -1;
+
     // query attribute locations
-    _glitchedShaderAttributeLocations.vPos = _glitchedShaderProgram->getAttributeLocation("vPos");
-    _glitchedShaderAttributeLocations.vNormal = _glitchedShaderProgram->getAttributeLocation("vNormal");
+    attributeLocations.vPos = shaderProgram->getAttributeLocation("vPos");
+    attributeLocations.vNormal = shaderProgram->getAttributeLocation("vNormal");
     // TODO #12B - texture coordinate
-    _glitchedShaderAttributeLocations.texCoord = _glitchedShaderProgram->getAttributeLocation("textCoord");
+    attributeLocations.texCoord = shaderProgram->getAttributeLocation("textCoord");
     // set static uniforms
     // TODO #13 - set uniform
-    _glitchedShaderProgram->setProgramUniform("textureMap", 0);
-
+    shaderProgram->setProgramUniform("textureMap", 0);
 
-    // hook up the CSCI441 object library to our shader program - MUST be done after the shader is used and before the objects are drawn
-    // if we have multiple shaders the flow would be:
-    //      1) shader->useProgram()
-    //      2) CSCI441::setVertexAttributeLocations()
-    //      3) CSCI441::draw*()
-    // but this lab only has one shader program ever in use, so we are safe to assign these values just once
-    //
-    // OR the alternative is to ensure that all of your shader programs use the
-    // same attribute locations for the vertex position, normal, and texture coordinate
-    // TODO #17 - set attribute
-    CSCI441::setVertexAttributeLocations(_glitchedShaderAttributeLocations.vPos,
-                                         _glitchedShaderAttributeLocations.vNormal,
-                                         _glitchedShaderAttributeLocations.texCoord);
+    return shaderProgram;
+}
 
-    
-    shaderIndex = 0;
+CSCI441::ShaderProgram* FPEngine::_createMonorailShaderProgram(const char* geometryShaderFilename,
+                                                               shaderUniformLocations& uniformLocations,
+                                                               monorailTessUniformLocations& tessLocations)
+{
+    auto shaderProgram = new CSCI441::ShaderProgram("shaders/fp-monorail.v.glsl",
+                                                    "shaders/fp-monorail.tc.glsl",
+                                                    "shaders/fp-monorail.te.glsl",
+                                                    geometryShaderFilename,
+                                                    "shaders/fp-std.f.glsl");
+    // query uniform locations
+    uniformLocations.mvpMatrix = shaderProgram->getUniformLocation("mvpMatrix");
+    uniformLocations.normalMatrix = shaderProgram->getUniformLocation("normalMatrix");
+    uniformLocations.cameraPos = shaderProgram->getUniformLocation("cameraPos");
+    uniformLocations.positionOffset = shaderProgram->getUniformLocation("positionOffset");
+    uniformLocations.materialColor = shaderProgram->getUniformLocation("materialColor");
+    uniformLocations.useLight = shaderProgram->getUniformLocation("useLight");
+    uniformLocations.useTexture = shaderProgram->getUniformLocation("useTexture");
+    // LIGHT
+    uniformLocations.lightDirection = shaderProgram->getUniformLocation("lightDirection");
+    uniformLocations.lightColor = shaderProgram->getUniformLocation("lightColor");
+    uniformLocations.spotlightDir = shaderProgram->getUniformLocation("spotlightDir");
+    uniformLocations.spotlightPos = shaderProgram->getUniformLocation("spotlightPos");
+    uniformLocations.spotlightColor = shaderProgram->getUniformLocation("spotlightColor");
+    uniformLocations.spotlightOuterCutOff = shaderProgram->getUniformLocation("spotlightOuterCutOff");
+    uniformLocations.spotlightCutOff = shaderProgram->getUniformLocation("spotlightCutOff");
+    // multi-view
+    uniformLocations.viewProjMatrices = geometryShaderFilename ? shaderProgram->getUniformLocation("viewProjMatrices") : -1;
+    uniformLocations.cameraPositions = geometryShaderFilename ? shaderProgram->getUniformLocation("cameraPositions") : -1;
+    uniformLocations.numViews = geometryShaderFilename ? shaderProgram->getUniformLocation("numViews") : -1;
+    // tessellation
+    tessLocations.tubeRadius = shaderProgram->getUniformLocation("tubeRadius");
+    tessLocations.tubeSegments = shaderProgram->getUniformLocation("tubeSegments");
+    tessLocations.ringDensity = shaderProgram->getUniformLocation("ringDensity");
+    tessLocations.lodDistance = shaderProgram->getUniformLocation("lodDistance");
+    // set static uniforms
+    shaderProgram->setProgramUniform(tessLocations.tubeRadius, MONORAIL_RADIUS);
+    shaderProgram->setProgramUniform(tessLocations.tubeSegments, MONORAIL_SEGMENTS);
+    shaderProgram->setProgramUniform(tessLocations.ringDensity, MONORAIL_RING_DENSITY);
+    shaderProgram->setProgramUniform(tessLocations.lodDistance, MONORAIL_LOD_DISTANCE);
 
+    return shaderProgram;
+}
 
-    _shaderPrograms[0] = _regularShaderProgram;
-    _shaderPrograms[1] = _glitchedShaderProgram;
+void FPEngine::_selectShaderPrograms(bool multiView)
+{
+    _pSceneShaderProgram = multiView ? _regularMultiViewShaderProgram : _regularShaderProgram;
+    _pSceneShaderUniformLocations = multiView ? &_regularMultiViewShaderUniformLocations : &_regularShaderUniformLocations;
+    _pSceneShaderAttributeLocations = multiView ? &_regularMultiViewShaderAttributeLocations : &_regularShaderAttributeLocations;
+    _pMonorailShaderProgram = multiView ? _monorailMultiViewShaderProgram : _monorailShaderProgram;
+    _pMonorailShaderUniformLocations = multiView ? &_monorailMultiViewShaderUniformLocations : &_monorailShaderUniformLocations;
 }
 
 void FPEngine::mSetupBuffers()
 {
-    _createGroundBuffers();
     _generateEnvironment();
 
-    _pCartModel = new CSCI441::ModelLoader();
-    _pCartModel->enableAutoGenerateNormals();
+    _pCartModel = _objectPool.create<Mesh>();
     if ( _pCartModel->loadModelFile( "models/FPCart7.obj" ) )
     {
-        _pCartModel->setAttributeLocations( _glitchedShaderAttributeLocations.vPos, _glitchedShaderAttributeLocations.vNormal );
         _pCartModel->setAttributeLocations( _regularShaderAttributeLocations.vPos, _regularShaderAttributeLocations.vNormal );
     }
     else
     {
         fprintf( stderr, "[ERROR]: Could not open OBJ Model\n" );
-        delete _pCartModel;
+        _objectPool.destroy(_pCartModel);
         _pCartModel = nullptr;
     }
     
     cartPos = glm::vec3(0.0f, 0.0f, 0.0f);
+    cartDirection = 0.0f;
+
+    // objects that exist for the whole run; only the cart entities ever move
+    _skyboxEntity = _scene.create(glm::vec3(0.0f), glm::mat3(1.0f), glm::vec3(10.0f));
+    _cartEntity = _scene.create(cartPos);
+    _heroEntity = _scene.create(cartPos, glm::mat3(glm::rotate(glm::mat4(1.0f), float(M_PI/2), CSCI441::X_AXIS)), glm::vec3(3.0f));
+    _propEntities.first = _skyboxEntity;
+    _propEntities.count = _heroEntity - _skyboxEntity + 1;
+    // track entities are appended after the static ones and replaced when the track is rebuilt
+    _controlPointEntities = _scene.createRange(0);
+    _beamEntities = _scene.createRange(0);
 
     glGenVertexArrays(NUM_VAOS, _vaos);
     glGenBuffers(NUM_VAOS, _vbos);
     glGenBuffers(NUM_VAOS, _ibos);
 
-    char* filename = (char*)malloc(sizeof(char) * 256);
-    filename = "data/rollercoaster.csv";
+    // beams and control points are baked into shared buffers, which grow with the track
+    _pGeometryPool = _objectPool.create<GeometryPool>();
+    _pGeometryPool->setup(STATIC_GEOMETRY_VERTICES, STATIC_GEOMETRY_INDICES,
+                          _pSceneShaderAttributeLocations->vPos,
+                          _pSceneShaderAttributeLocations->vNormal,
+                          _pSceneShaderAttributeLocations->texCoord,
+                          _multiDrawIndirect);
+    _pBeamBatch = _objectPool.create<StaticBatch>();
+    _pBeamBatch->setup(_pGeometryPool, StaticBatch::makeBox(glm::vec3(0.5f)));
+    _pControlPointBatch = _objectPool.create<StaticBatch>();
+    _pControlPointBatch->setup(_pGeometryPool, StaticBatch::makeSphere(CONTROL_POINT_RADIUS, 16, 16));
+
+    // the curve and monorail can be written by compute shaders straight into the buffers they draw from
+    if (_gpuTrackBuilder) {
+        _pTrackBuilder = _objectPool.create<TrackBuilder>();
+        if (!_pTrackBuilder->setup(CURVE_RESOLUTION, MONORAIL_RADIUS, MONORAIL_SEGMENTS, MONORAIL_CHUNK_RINGS)) {
+            _objectPool.destroy(_pTrackBuilder);
+            _pTrackBuilder = nullptr;
+        }
+    }
+
+    const char* filename = _trackFilename.c_str();
 
     _loadControlPoints(filename,
                                &_bezierCurve.numControlPoints, &_bezierCurve.numCurves,
@@ -310,6 +753,9 @@ void FPEngine::mSetupBuffers()
     {
         fprintf(stdout, "[INFO]: Read in %u points comprising %u curves\n", _bezierCurve.numControlPoints,
                 _bezierCurve.numCurves);
+        _dirtyCurves.assign(_bezierCurve.numCurves, false);
+        // the support beams stand on the ground, so it settles before they are placed
+        _fitParkToTrack();
 
         // generate cage
         _createCage(_vaos[VAO_ID::BEZIER_CAGE], _vbos[VAO_ID::BEZIER_CAGE], _numVAOPoints[VAO_ID::BEZIER_CAGE]);
@@ -317,283 +763,399 @@ void FPEngine::mSetupBuffers()
         // generate curve
         _createCurve(_vaos[VAO_ID::BEZIER_CURVE], _vbos[VAO_ID::BEZIER_CURVE], _numVAOPoints[VAO_ID::BEZIER_CURVE]);
 
+        // place control point spheres and support beams
+        _createTrackEntities();
+
+        // zones live beside the track, data/rollercoaster.csv uses data/rollercoaster.zones
+        const size_t extension = _trackFilename.find_last_of('.');
+        const size_t directory = _trackFilename.find_last_of("/\\");
+        const std::string zoneFilename = (extension != std::string::npos && (directory == std::string::npos || extension > directory)
+                                          ? _trackFilename.substr(0, extension) : _trackFilename) + ".zones";
+        _trackZones.load(zoneFilename.c_str());
+
         // generate monorail
-        _createMonorail(_bezierCurve.curvePoints, _vaos[VAO_ID::MONO_RAIL], _vbos[VAO_ID::MONO_RAIL], _ibos[VAO_ID::MONO_RAIL], 0.2f, 16);
+        _createMonorail(_vaos[VAO_ID::MONO_RAIL], _vbos[VAO_ID::MONO_RAIL], _ibos[VAO_ID::MONO_RAIL]);
+
+        // generate monorail patches for the tessellated path
+        _createMonorailPatches(_vaos[VAO_ID::MONO_RAIL_PATCHES], _vbos[VAO_ID::BEZIER_CAGE], _vbos[VAO_ID::MONO_RAIL_PATCHES], _ibos[VAO_ID::MONO_RAIL_PATCHES], _numVAOPoints[VAO_ID::MONO_RAIL_PATCHES]);
+    }
+
+    // pick up edits to the track file while running; a recording, replay or offline render must see the
+    // track it started with, since edits are not in the input log
+    if (_inputRecorder.getMode() == InputRecorder::Mode::OFF && !_offline)
+    {
+        _pTrackWatcher = _objectPool.create<TrackWatcher>(filename);
+        _pTrackWatcher->start();
     }
 
     cartPos = _bezierCurve.curvePoints[currBezierIndex];
+    _scene.setTranslation(_cartEntity, cartPos);
+    _scene.setTranslation(_heroEntity, cartPos + glm::vec3(0.0f, 0.5f, 0.0f));
+    _scene.update();
 
-    _sirByzler = new SirByzler(_glitchedShaderProgram->getShaderProgramHandle(),
-                               _glitchedShaderUniformLocations.mvpMatrix,
-                               _glitchedShaderUniformLocations.normalMatrix,
-                               _glitchedShaderUniformLocations.materialColor);
+    _sirByzler = _objectPool.create<SirByzler>(_regularShaderProgram->getShaderProgramHandle(),
+                               _regularShaderUniformLocations.mvpMatrix,
+                               _regularShaderUniformLocations.normalMatrix,
+                               _regularShaderUniformLocations.materialColor);
 
-    
-}
+    _createTerrain();
 
-void FPEngine::_createMonorail(std::vector<glm::vec3> curvePoints, GLuint& vao, GLuint& vbo, GLuint ibo, float radius, int numSegments) {
-    // containers for vertices and indices
-    std::vector<glm::vec3> vertices;
-    std::vector<GLuint> indices;
+    _pGlitchEffect = _objectPool.create<GlitchEffect>();
+    if (_pGlitchEffect->setup())
+    {
+        _pGlitchEffect->setResolutionScale(_glitchScale);
+    }
+    else
+    {
+        _objectPool.destroy(_pGlitchEffect);
+        _pGlitchEffect = nullptr;
+    }
 
-    // generate vertices and indices for the cylinder along the curve
-    for (size_t i = 0; i < curvePoints.size(); ++i) {
-        glm::vec3 point = curvePoints[i];
-        glm::vec3 tangent;
-        
-        // Compute tangent vector
-        if (i < curvePoints.size() - 1) {
-            tangent = glm::normalize(curvePoints[i + 1] - point);
-        } else {
-            tangent = glm::normalize(point - curvePoints[i - 1]);
+    // render offscreen at a budgeted resolution only when asked to
+    if (_frameBudget > 0.0f && !_offline)
+    {
+        _pDynamicResolution = _objectPool.create<DynamicResolution>();
+        if (_pDynamicResolution->setup())
+        {
+            _pDynamicResolution->setFrameBudget(_frameBudget);
+            fprintf(stdout, "[INFO]: dynamic resolution enabled, scene budget %.1f ms\n", _frameBudget);
         }
-
-        glm::vec3 normal = glm::normalize(glm::cross(tangent, glm::vec3(0, 1, 0)));
-        glm::vec3 binormal = glm::cross(tangent, normal);
-
-        // Generate circle vertices at this point
-        for (int j = 0; j < numSegments; ++j) {
-            float angle = j * 2.0f * M_PI / numSegments;
-            glm::vec3 offset = radius * (cos(angle) * normal + sin(angle) * binormal);
-            vertices.push_back(point + offset);
+        else
+        {
+            _objectPool.destroy(_pDynamicResolution);
+            _pDynamicResolution = nullptr;
         }
+    }
 
-        // Generate indices to connect this circle to the previous one
-        if (i > 0) {
-            int startIndex = i * numSegments;
-            int prevIndex = (i - 1) * numSegments;
-
-            for (int j = 0; j < numSegments; ++j) {
-                int nextJ = (j + 1) % numSegments;
-
-                // Two triangles per quad
-                indices.push_back(prevIndex + j);
-                indices.push_back(prevIndex + nextJ);
-                indices.push_back(startIndex + j);
+    // one captured frame per presented frame, so the video plays back at the rate swaps are paced to
+    if (!_captureFilename.empty() && !_offline && _framePacer.getTargetFramesPerSecond() == 0)
+    {
+        fprintf(stderr, "[ERROR]: Capturing needs swaps paced to the display, not capturing with --swap off\n");
+    }
+    else if (!_captureFilename.empty() && !_offline)
+    {
+        _pFrameCapture = _objectPool.create<FrameCapture>(_captureFilename.c_str(), _framePacer.getTargetFramesPerSecond());
+        if (!_pFrameCapture->start())
+        {
+            _objectPool.destroy(_pFrameCapture);
+            _pFrameCapture = nullptr;
+        }
+    }
+}
 
-                indices.push_back(startIndex + j);
-                indices.push_back(prevIndex + nextJ);
-                indices.push_back(startIndex + nextJ);
-            }
+void FPEngine::_createMonorail(GLuint vao, GLuint vbo, GLuint ibo) {
+    const GLuint numRings = _bezierCurve.curvePoints.size();
+    _monorailChunks.clear();
+    if (numRings < 2) return;
+
+    // chunk c covers rings [c * MONORAIL_CHUNK_RINGS, (c + 1) * MONORAIL_CHUNK_RINGS], neighbouring
+    // chunks both store their shared boundary ring so every chunk can be drawn on its own
+    _monorailChunks.resize((numRings - 2) / MONORAIL_CHUNK_RINGS + 1);
+
+    // local index pattern for one full chunk: two triangles per quad between consecutive rings.
+    // a shorter final chunk draws a prefix of the same pattern
+    std::vector<GLushort> indices;
+    indices.reserve(MONORAIL_CHUNK_RINGS * MONORAIL_SEGMENTS * 6);
+    for (GLuint ring = 1; ring <= MONORAIL_CHUNK_RINGS; ++ring) {
+        GLushort startIndex = ring * MONORAIL_SEGMENTS;
+        GLushort prevIndex = (ring - 1) * MONORAIL_SEGMENTS;
+
+        for (int j = 0; j < MONORAIL_SEGMENTS; ++j) {
+            GLushort nextJ = (j + 1) % MONORAIL_SEGMENTS;
+
+            indices.push_back(prevIndex + j);
+            indices.push_back(prevIndex + nextJ);
+            indices.push_back(startIndex + j);
+
+            indices.push_back(startIndex + j);
+            indices.push_back(prevIndex + nextJ);
+            indices.push_back(startIndex + nextJ);
         }
     }
 
-    // bind and upload data to gbo
-    glGenVertexArrays(1, &vao);
-    glGenBuffers(1, &vbo);
-    glGenBuffers(1, &ibo);
+    std::vector<PackedVertex> vertices;
+    size_t numVertices = 0;
+    if (_pTrackBuilder) {
+        // the GPU sweeps the rings, the CPU only decides where each chunk goes
+        for (GLuint c = 0; c < _monorailChunks.size(); ++c) {
+            numVertices += _layoutMonorailChunk(c);
+        }
+    } else {
+        std::vector<PackedVertex> chunkVertices;
+        vertices.reserve((numRings + _monorailChunks.size()) * MONORAIL_SEGMENTS);
+        for (GLuint c = 0; c < _monorailChunks.size(); ++c) {
+            _buildMonorailChunk(c, chunkVertices);
+            vertices.insert(vertices.end(), chunkVertices.begin(), chunkVertices.end());
+        }
+        numVertices = vertices.size();
+    }
 
+    // upload into the buffers generated in mSetupBuffers
     glBindVertexArray(vao);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(PackedVertex), _pTrackBuilder ? nullptr : vertices.data(), GL_STATIC_DRAW);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
-    glEnableVertexAttribArray(0);
+    VertexFormat::setAttributeLocations(_regularShaderAttributeLocations.vPos, _regularShaderAttributeLocations.vNormal, -1);
 
-    _monorailIndices = indices;
-}
+    if (_pTrackBuilder) {
+        _pTrackBuilder->sweepChunks(_vbos[VAO_ID::BEZIER_CURVE], numRings, _vbos[VAO_ID::MONO_RAIL_PATCHES], vbo,
+                                    0, _monorailChunks.size(), &_monorailChunks[0].bounds, sizeof(MonorailChunk));
+    }
 
-void FPEngine::renderMonorail(GLuint vao, size_t numIndices) const {
-    glBindVertexArray(vao);
-    glDrawElements(GL_TRIANGLES, numIndices, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    fprintf(stdout, "[INFO]: monorail built with %zu vertices in %zu chunks (%zu bytes)\n",
+            numVertices, _monorailChunks.size(), numVertices * sizeof(PackedVertex));
 }
 
+void FPEngine::_buildMonorailChunk(GLuint chunkIndex, std::vector<PackedVertex>& vertices) {
+    const GLuint numRings = _bezierCurve.curvePoints.size();
+    const GLuint firstRing = chunkIndex * MONORAIL_CHUNK_RINGS;
+    const GLuint lastRing = std::min(firstRing + MONORAIL_CHUNK_RINGS, numRings - 1);
+
+    // full precision rings: position and outward normal for every vertex, scratch that is
+    // released as soon as the chunk is packed
+    const FrameArena::Marker marker = _frameArena.getMarker();
+    const size_t numVertices = (lastRing - firstRing + 1) * MONORAIL_SEGMENTS;
+    glm::vec3* positions = _frameArena.allocate<glm::vec3>(numVertices);
+    glm::vec3* normals = _frameArena.allocate<glm::vec3>(numVertices);
+    TrackGeometry::sweepRings(_bezierCurve.curvePoints.data(), numRings, _knotNormals.data(), CURVE_RESOLUTION, firstRing, lastRing,
+                              MONORAIL_RADIUS, MONORAIL_SEGMENTS, positions, normals);
+
+    // quantize the chunk against its own bounds
+    MonorailChunk& chunk = _monorailChunks[chunkIndex];
+    chunk.bounds = VertexFormat::computeBounds(positions, numVertices);
+    chunk.baseVertex = chunkIndex * (MONORAIL_CHUNK_RINGS + 1) * MONORAIL_SEGMENTS;
+    chunk.numIndices = (lastRing - firstRing) * MONORAIL_SEGMENTS * 6;
+
+    vertices.clear();
+    for (size_t v = 0; v < numVertices; ++v) {
+        vertices.push_back(VertexFormat::pack(positions[v], normals[v], glm::vec2(0.0f), chunk.bounds));
+    }
+    _frameArena.rewind(marker);
+}
 
-void FPEngine::_createCage(GLuint vao, GLuint vbo, GLsizei& numVAOPoints) const
-{
-        numVAOPoints = _bezierCurve.numControlPoints;
-
-        glBindVertexArray(vao);
-
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferData(GL_ARRAY_BUFFER, numVAOPoints * sizeof(glm::vec3), _bezierCurve.controlPoints, GL_STATIC_DRAW);
-
-        glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->vPos);
-        glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->vPos, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+GLuint FPEngine::_layoutMonorailChunk(GLuint chunkIndex) {
+    const GLuint firstRing = chunkIndex * MONORAIL_CHUNK_RINGS;
+    const GLuint lastRing = std::min(firstRing + MONORAIL_CHUNK_RINGS, (GLuint)_bezierCurve.curvePoints.size() - 1);
+
+    // the box is found from the samples alone, before any vertex exists
+    MonorailChunk& chunk = _monorailChunks[chunkIndex];
+    glm::vec3 boxMin, boxMax;
+    TrackGeometry::sweepBounds(_bezierCurve.curvePoints.data(), firstRing, lastRing, MONORAIL_RADIUS, boxMin, boxMax);
+    chunk.bounds.origin = boxMin;
+    chunk.bounds.extent = boxMax - boxMin;
+    chunk.baseVertex = chunkIndex * (MONORAIL_CHUNK_RINGS + 1) * MONORAIL_SEGMENTS;
+    chunk.numIndices = (lastRing - firstRing) * MONORAIL_SEGMENTS * 6;
+    return (lastRing - firstRing + 1) * MONORAIL_SEGMENTS;
+}
 
-        fprintf(stdout, "[INFO]: control points cage read in with VAO/VBO %d/%d & %d points\n", vao, vbo, numVAOPoints);
+void FPEngine::renderMonorail(GLuint vao) const {
+    _glState.bindVertexArray(vao);
+    for (const MonorailChunk& chunk : _monorailChunks) {
+        _sendWorldPositionDecode(chunk.bounds);
+        glDrawElementsBaseVertex(GL_TRIANGLES, chunk.numIndices, GL_UNSIGNED_SHORT, (void*)0, chunk.baseVertex);
+    }
+    _sendPositionDecode(VertexFormat::IDENTITY_BOUNDS);
 }
 
-void FPEngine::_createCurve(GLuint vao, GLuint vbo, GLsizei& numVAOPoints)
+void FPEngine::_createMonorailPatches(GLuint vao, GLuint cageVBO, GLuint knotNormalVBO, GLuint ibo, GLsizei& numVAOPoints) const
 {
-    // TODO #02: generate the Bezier curve
-    GLint resolution = 100;
-
-    std::vector<glm::vec3> curvePoints;
-    for (int i = 0; i < _bezierCurve.numCurves; i++) {
-        int startIdx = 3 * i;
-        glm::vec3 p0 = _bezierCurve.controlPoints[startIdx];
-        glm::vec3 p1 = _bezierCurve.controlPoints[startIdx + 1];
-        glm::vec3 p2 = _bezierCurve.controlPoints[startIdx + 2];
-        glm::vec3 p3 = _bezierCurve.controlPoints[startIdx + 3];
-        
-        for (int j = 0; j <= resolution; j++) {
-            float t = float(j)/resolution;
-            curvePoints.push_back(_evalBezierCurve(p0, p1, p2, p3, t));
+    // consecutive curves share their end point, so patch i starts at control point 3i
+    std::vector<GLuint> indices;
+    indices.reserve(_bezierCurve.numCurves * 4);
+    for (GLuint i = 0; i < _bezierCurve.numCurves; i++) {
+        for (GLuint j = 0; j < 4; j++) {
+            indices.push_back(3 * i + j);
         }
     }
-    numVAOPoints = curvePoints.size();
-    fprintf(stdout, "[INFO]: bezier curve read in with VAO/VBO %d/%d & %d points\n", vao, vbo, numVAOPoints);
-    _bezierCurve.curvePoints = curvePoints;
-    glBindVertexArray(_vaos[VAO_ID::BEZIER_CURVE]);
+    numVAOPoints = indices.size();
 
-    glBindBuffer(GL_ARRAY_BUFFER, _vbos[VAO_ID::BEZIER_CURVE]);
-    glBufferData(GL_ARRAY_BUFFER, curvePoints.size() * sizeof(glm::vec3), curvePoints.data(), GL_STATIC_DRAW);
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, cageVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+    // the ring frame at each end of a patch comes from the knot normal beside its control point
+    glBindBuffer(GL_ARRAY_BUFFER, knotNormalVBO);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->vPos);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->vPos, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 
+    fprintf(stdout, "[INFO]: monorail patches read in with VAO/IBO %d/%d & %d patches\n", vao, ibo, _bezierCurve.numCurves);
 }
 
-void FPEngine::_loadControlPoints(const char* FILENAME, GLuint* numBezierPoints, GLuint* numBezierCurves,
-    glm::vec3*& bezierPoints)
+void FPEngine::_renderTessellatedMonorail(const Transform::ViewTransform& view) const
 {
-    // open the file
-    FILE* file = fopen(FILENAME, "r");
+    const GLuint monorailProgram = _pMonorailShaderProgram->getShaderProgramHandle();
+    _glState.useProgram(monorailProgram);
 
-    // check that the file opened properly
-    if (!file)
-    {
-        fprintf(stderr, "[ERROR]: Could not open \"%s\"\n", FILENAME);
-    }
-    else
-    {
-        // first value is the number of points in the file
-        fscanf(file, "%u\n", numBezierPoints);
+    // the control points are already in world space, moved to the view's origin on the GPU
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->positionOffset, Transform::rebase(glm::vec3(0.0f), view.origin));
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->mvpMatrix, view.viewProjMtx);
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->normalMatrix, glm::mat3(1.0f));
 
-        *numBezierCurves = (*numBezierPoints - 1) / 3;
-        std::cout << "numCurves: " << *numBezierCurves;
+    // level of detail is chosen from the distance to this view's camera
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->cameraPos, view.cameraPosition);
 
-        fprintf(stdout, "[INFO]: Reading in %u control points\n", *numBezierPoints);
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->materialColor, glm::vec3(0.0f));
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->useLight, 0);
+    _glState.setUniform(monorailProgram, _pMonorailShaderUniformLocations->useTexture, 0);
 
-        // allocate memory
-        bezierPoints = (glm::vec3*)malloc(sizeof(glm::vec3) * *numBezierPoints);
-        if (!bezierPoints)
-        {
-            fprintf(stderr, "[ERROR]: Could not allocate space for control points\n");
-        }
-        else
-        {
-            // read in all the points
-            for (int i = 0; i < *numBezierPoints; i++)
-            {
-                // each line is formatted as "x,y,z\n" as comma seperated floats
-                fscanf(file, "%f,%f,%f\n", &(bezierPoints[i].x), &(bezierPoints[i].y), &(bezierPoints[i].z));
-            }
-        }
-    }
-    // close the file
-    fclose(file);
-}
-glm::vec3 FPEngine::_evalBezierCurve(const glm::vec3 P0, const glm::vec3 P1, const glm::vec3 P2, const glm::vec3 P3,
-                                        const GLfloat T) const
-{
-    glm::vec3 bezierPoint = float(pow((1-T), 3))*P0 + 3*float(pow((1-T), 2))*T*P1 + 3*(1-T)*float(pow(T, 2))*P2 + float(pow(T,3))*P3; 
+    _glState.bindVertexArray(_vaos[VAO_ID::MONO_RAIL_PATCHES]);
+    glPatchParameteri(GL_PATCH_VERTICES, 4);
+    glDrawElements(GL_PATCHES, _numVAOPoints[VAO_ID::MONO_RAIL_PATCHES], GL_UNSIGNED_INT, (void*)0);
 
-    return bezierPoint;
+    // hand the scene program back
+    _glState.useProgram(_pSceneShaderProgram->getShaderProgramHandle());
 }
-void FPEngine::_createGroundBuffers()
+
+void FPEngine::_createCage(GLuint vao, GLuint vbo, GLsizei& numVAOPoints)
 {
-    // TODO #8: expand our struct
-    struct Vertex
-    {
-        glm::vec3 position;
-        glm::vec3 normal;
-        float s, t;
-    };
+        numVAOPoints = _bezierCurve.numControlPoints;
 
-    // TODO #9: add normal data
-    Vertex groundQuad[4] = {
-        {{-1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, 0.0, 0.0},
-        {{1.0f, 0.0f, -1.0f}, {0.0f, 1.0f, 0.0f}, 4.0, 0.0},
-        {{-1.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, 0.0, 4.0},
-        {{1.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 0.0f}, 4.0, 4.0}
-    };
+        glBindVertexArray(vao);
 
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, numVAOPoints * sizeof(glm::vec3), _bezierCurve.controlPoints, GL_STATIC_DRAW);
 
-    GLushort indices[4] = {0, 1, 2, 3};
+        glEnableVertexAttribArray(_pSceneShaderAttributeLocations->vPos);
+        glVertexAttribPointer(_pSceneShaderAttributeLocations->vPos, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-    _numGroundPoints = 4;
+        fprintf(stdout, "[INFO]: control points cage read in with VAO/VBO %d/%d & %d points\n", vao, vbo, numVAOPoints);
 
+        _controlPointBVH.buildPoints(_bezierCurve.controlPoints, _bezierCurve.numControlPoints, CONTROL_POINT_RADIUS);
+}
 
-    glGenVertexArrays(1, &_groundVAO);
-    glBindVertexArray(_groundVAO);
+void FPEngine::_createCurve(GLuint vao, GLuint vbo, GLsizei& numVAOPoints)
+{
+    // TODO #02: generate the Bezier curve
+    _bezierCurve.curvePoints.resize(_bezierCurve.numCurves * SAMPLES_PER_CURVE);
+    for (GLuint i = 0; i < _bezierCurve.numCurves; i++) {
+        TrackGeometry::sampleCurve(_bezierCurve.controlPoints, i, CURVE_RESOLUTION, &_bezierCurve.curvePoints[i * SAMPLES_PER_CURVE]);
+    }
+    numVAOPoints = _bezierCurve.curvePoints.size();
+    fprintf(stdout, "[INFO]: bezier curve read in with VAO/VBO %d/%d & %d points\n", vao, vbo, numVAOPoints);
+    glBindVertexArray(vao);
 
-    GLuint vbods[2];
-    glGenBuffers(2, vbods);
+    // the CPU samples still drive the ride, the GPU writes its own copy for drawing
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, _bezierCurve.curvePoints.size() * sizeof(glm::vec3),
+                 _pTrackBuilder ? nullptr : _bezierCurve.curvePoints.data(), GL_STATIC_DRAW);
+    if (_pTrackBuilder) {
+        _pTrackBuilder->sampleCurves(_vbos[VAO_ID::BEZIER_CAGE], vbo, 0, _bezierCurve.numCurves);
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, vbods[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(groundQuad), groundQuad, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(_pSceneShaderAttributeLocations->vPos);
+    glVertexAttribPointer(_pSceneShaderAttributeLocations->vPos, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
-    // Position attribute
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->vPos);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->vPos, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // every ring frame is blended from the normals carried to the curve end points
+    _knotNormals.assign(_bezierCurve.numControlPoints, glm::vec3(0.0f));
+    TrackGeometry::computeKnotNormals(_bezierCurve.curvePoints.data(), _bezierCurve.numCurves, CURVE_RESOLUTION, _knotNormals.data());
+    glBindBuffer(GL_ARRAY_BUFFER, _vbos[VAO_ID::MONO_RAIL_PATCHES]);
+    glBufferData(GL_ARRAY_BUFFER, _knotNormals.size() * sizeof(glm::vec3), _knotNormals.data(), GL_STATIC_DRAW);
 
-    // Normal attribute
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->vNormal);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->vNormal, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)sizeof(glm::vec3));
+    _computeArcLengths(0);
+    _trackBVH.buildSegments(_bezierCurve.curvePoints.data(), _bezierCurve.curvePoints.size(), MONORAIL_RADIUS);
+}
 
-    // Texture coordinate attribute
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->texCoord);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->texCoord, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(2 * sizeof(glm::vec3)));
+void FPEngine::_createTrackEntities()
+{
+    // drop the entities of the previous track, everything after them is track too
+    _scene.truncate(_controlPointEntities.first);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbods[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    _controlPointEntities = _scene.createRange(_bezierCurve.numControlPoints);
+    _pControlPointBatch->resize(_controlPointEntities.count);
+    for (GLuint i = 0; i < _controlPointEntities.count; i++) {
+        _scene.setTranslation(_controlPointEntities.first + i, _bezierCurve.controlPoints[i]);
+    }
 
+    // support beams stand under every BEAM_SPACING-th sample
+    _beamEntities = _scene.createRange((_bezierCurve.curvePoints.size() + BEAM_SPACING - 1) / BEAM_SPACING);
+    _pBeamBatch->resize(_beamEntities.count);
+    for (GLuint beam = 0; beam < _beamEntities.count; beam++) {
+        _placeBeam(beam);
+    }
+
+    // the frame arena holds one view pass of entity matrices, or one monorail chunk's rings,
+    // plus the per view arrays of a multi-view pass and room for alignment
+    const size_t viewPassBytes = 2 * sizeof(glm::mat4) * (_scene.getNumEntities() + 1);
+    const size_t chunkBytes = 2 * sizeof(glm::vec3) * (MONORAIL_CHUNK_RINGS + 1) * MONORAIL_SEGMENTS;
+    _frameArena.reserve(std::max(viewPassBytes, chunkBytes) + MAX_VIEWS * (sizeof(glm::mat4) + sizeof(glm::vec3)) + 256);
+    _entityOccludedFrames.assign(_scene.getNumEntities(), 0);
+    _steadyStateFrame = _frameNumber + ALLOCATION_WARMUP_FRAMES;
 }
 
-void FPEngine::_createSkyBox()
+bool FPEngine::_fitParkToTrack()
 {
-    // // TODO #8: expand our struct
-    struct VertexNormalTextured
-    {
-        glm::vec3 position;
-        glm::vec3 normal;
-        // TODO #14 - add texture coordinate
-        glm::vec2 texCoord;
-    };
-
-    VertexNormalTextured skyboxWall[4]{
-        {{-100.0f, -100.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}}, // bottom left
-        {{100.0f, -100.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f}}, // bottom right
-        {{-100.0f, 100.0f, 1.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f}}, // top left
-        {{100.0f, 100.0f, 1.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}} // top right
-    };
-
+    // the park is centred on the origin, so it has to reach the corner of the track's box
+    // furthest from it.  The curves never leave the box of their control points
+    glm::vec2 farthest(0.0f);
+    for (GLuint i = 0; i < _bezierCurve.numControlPoints; i++) {
+        const glm::vec3& point = _bezierCurve.controlPoints[i];
+        farthest = glm::max(farthest, glm::abs(glm::vec2(point.x, point.z)));
+    }
 
-    GLushort indices[4] = {0, 1, 2, 3};
-    _numGroundPoints = 4;
+    Heightfield::Settings groundSettings = _heightfield.getSettings();
+    const GLfloat parkRadius = std::max(WORLD_SIZE, glm::length(farthest) + PARK_MARGIN);
+    if (parkRadius == groundSettings.parkRadius) return false;
 
-    glGenVertexArrays(1, &_groundVAO);
-    glBindVertexArray(_groundVAO);
+    groundSettings.parkRadius = parkRadius;
+    _heightfield.setSettings(groundSettings);
+    fprintf(stdout, "[INFO]: park radius %.1f fits the track\n", parkRadius);
+    return true;
+}
 
+void FPEngine::_createTerrain()
+{
+    // chunks already streamed in were sampled from the old ground
+    _objectPool.destroy(_pTerrain);
+    _pTerrain = _objectPool.create<Terrain>(_heightfield);
+    if (!_pTerrain->setup(_pSceneShaderAttributeLocations->vPos,
+                          _pSceneShaderAttributeLocations->vNormal,
+                          _pSceneShaderAttributeLocations->texCoord))
+    {
+        _objectPool.destroy(_pTerrain);
+        _pTerrain = nullptr;
+    }
+}
 
-    GLuint vbods[2]; // 0 - VBO, 1 - IBO
-    glGenBuffers(2, vbods);
-    glBindBuffer(GL_ARRAY_BUFFER, vbods[0]);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(skyboxWall), skyboxWall, GL_STATIC_DRAW);
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->vPos);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->vPos, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured),
-                          (void*)nullptr);
+void FPEngine::_placeBeam(GLuint beam)
+{
+    // a unit cube centred halfway down to the ground and stretched to reach it; where the
+    // track dips into a hill the beam shrinks away
+    const glm::vec3& point = _bezierCurve.curvePoints[beam * BEAM_SPACING];
+    const GLfloat ground = std::min(_heightfield.getHeight(point.x, point.z), point.y);
+    _scene.setTranslation(_beamEntities.first + beam, glm::vec3(point.x, (point.y + ground) / 2, point.z));
+    _scene.setScale(_beamEntities.first + beam, glm::vec3(1.0f, 2*(point.y - ground), 1.0f));
+    _pBeamBatch->markDirty(beam);
+}
 
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->vNormal);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->vNormal, 3, GL_FLOAT, GL_FALSE, sizeof(VertexNormalTextured),
-                          (void*)(sizeof(glm::vec3)));
+void FPEngine::_loadControlPoints(const char* FILENAME, GLuint* numBezierPoints, GLuint* numBezierCurves,
+    glm::vec3*& bezierPoints)
+{
+    std::vector<glm::vec3> points;
+    if (!TrackGeometry::loadControlPoints(FILENAME, points)) return;
 
-    glEnableVertexAttribArray(_shaderAttributeLocations[shaderIndex]->texCoord);
-    glVertexAttribPointer(_shaderAttributeLocations[shaderIndex]->texCoord, 2, GL_FLOAT, GL_FALSE,
-                          sizeof(VertexNormalTextured), (void*)(2 * sizeof(glm::vec3)));
+    *numBezierPoints = points.size();
+    *numBezierCurves = (*numBezierPoints - 1) / 3;
+    fprintf(stdout, "[INFO]: Reading in %u control points\n", *numBezierPoints);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbods[1]);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    // allocate memory
+    bezierPoints = (glm::vec3*)malloc(sizeof(glm::vec3) * *numBezierPoints);
+    if (!bezierPoints)
+    {
+        fprintf(stderr, "[ERROR]: Could not allocate space for control points\n");
+        return;
+    }
+    std::copy(points.begin(), points.end(), bezierPoints);
 }
 
-
 GLuint FPEngine::_loadAndRegisterTexture(const char* FILENAME)
 {
     // our handle to the GPU
@@ -690,7 +1252,7 @@ void FPEngine::mSetupScene()
     animate = true; 
     hero = true;
 
-    _pArcballCam = new CSCI441::ArcballCam(2.0f);
+    _pArcballCam = _objectPool.create<CSCI441::ArcballCam>(2.0f);
     _pArcballCam->setLookAtPoint(cartPos);
     _pArcballCam->setTheta(0);
     _pArcballCam->setPhi(-M_PI / 1.8f);
@@ -699,76 +1261,71 @@ void FPEngine::mSetupScene()
     _cameraSpeed = glm::vec2(0.1f, 0.05f);
     cameras[0] = _pArcballCam;
 
-    _pMapCam = new CSCI441::FreeCam();
+    _pMapCam = _objectPool.create<CSCI441::FreeCam>();
     _pMapCam->setPosition(cartPos); // give the camera a scenic starting point
     _pMapCam->setTheta(-M_PI / 3.0f); // and a nice view
     _pMapCam->setPhi(M_PI / 2);
     _pMapCam->recomputeOrientation();
     _pMapCam->recomputeOrientation();
 
-    _pFreeCam = new CSCI441::FreeCam();
+    _pFreeCam = _objectPool.create<CSCI441::FreeCam>();
     _pFreeCam->setPosition(glm::vec3(10.0f, 5.0f, 3.0f)); // give the camera a scenic starting point
     _pFreeCam->setTheta(-M_PI / 3.0f); // and a nice view
     _pFreeCam->setPhi(M_PI / 2.8f);
     _pFreeCam->recomputeOrientation();
     cameras[1] = _pFreeCam;
 
+    _setLighting(_defaultLightColor);
+}
 
-
+void FPEngine::_setLighting(const glm::vec3 lightColor)
+{
     // Directional Light
     glm::vec3 lightDirection = glm::vec3(-1, -1, -1);
-    glm::vec3 lightColor = glm::vec3(1, 1, 1);
-
-
-    for (int i = 0; i <= 1; i++) {
-        glProgramUniform3fv(
-            _shaderPrograms[i]->getShaderProgramHandle(),
-            _shaderUniformLocations[i]->lightColor,
-            1,
-            glm::value_ptr(lightColor)
-        );
-
 
-        glProgramUniform3fv(
-            _shaderPrograms[i]->getShaderProgramHandle(),
-            _shaderUniformLocations[i]->lightDirection,
-            1,
-            glm::value_ptr(lightDirection)
-        );
+    // the single view and multi-view programs are lit the same way
+    for (bool multiView : {false, true}) {
+        _selectShaderPrograms(multiView);
+        // set every frame by the lighting zones, but only sent when a zone changes the color
+        _glState.setUniform(_pSceneShaderProgram->getShaderProgramHandle(), _pSceneShaderUniformLocations->lightColor, lightColor);
+        _glState.setUniform(_pSceneShaderProgram->getShaderProgramHandle(), _pSceneShaderUniformLocations->lightDirection, lightDirection);
 
         // //spotlight
         // glProgramUniform3fv(
-        //     _shaderPrograms[i]->getShaderProgramHandle(),
-        //     _shaderUniformLocations[i]->spotlightPos,
+        //     _pSceneShaderProgram->getShaderProgramHandle(),
+        //     _pSceneShaderUniformLocations->spotlightPos,
         //     1,
         //     glm::value_ptr(glm::vec3(0.0f, 5.0f, 0.0f))
         // );
         // glProgramUniform3fv(
-        //     _shaderPrograms[i]->getShaderProgramHandle(),
-        //     _shaderUniformLocations[i]->spotlightDir,
+        //     _pSceneShaderProgram->getShaderProgramHandle(),
+        //     _pSceneShaderUniformLocations->spotlightDir,
         //     1,
         //     glm::value_ptr(glm::vec3(0.0f, -1.0f, 0.0f))
         // );
         // glProgramUniform3fv(
-        //     _shaderPrograms[i]->getShaderProgramHandle(),
-        //     _shaderUniformLocations[i]->spotlightColor,
+        //     _pSceneShaderProgram->getShaderProgramHandle(),
+        //     _pSceneShaderUniformLocations->spotlightColor,
         //     1,
         //     glm::value_ptr(glm::vec3(1.0f, 0.0f, 1.0f))
         // );
         // float innerCutoffAngle = 10.0f; // inner cutoff in degrees
         // float outerCutoffAngle = 15.0f; // outer cutoff in degrees
         // glProgramUniform1f(
-        //     _shaderPrograms[i]->getShaderProgramHandle(),
-        //     _shaderUniformLocations[i]->spotlightCutOff,
+        //     _pSceneShaderProgram->getShaderProgramHandle(),
+        //     _pSceneShaderUniformLocations->spotlightCutOff,
         //     cos(glm::radians(innerCutoffAngle))
         // );
         // glProgramUniform1f(
-        //     _shaderPrograms[i]->getShaderProgramHandle(),
-        //     _shaderUniformLocations[i]->spotlightOuterCutOff,
+        //     _pSceneShaderProgram->getShaderProgramHandle(),
+        //     _pSceneShaderUniformLocations->spotlightOuterCutOff,
         //     cos(glm::radians(outerCutoffAngle))
         // );
 
+        _glState.setUniform(_pMonorailShaderProgram->getShaderProgramHandle(), _pMonorailShaderUniformLocations->lightColor, lightColor);
+        _glState.setUniform(_pMonorailShaderProgram->getShaderProgramHandle(), _pMonorailShaderUniformLocations->lightDirection, lightDirection);
     }
+    _selectShaderPrograms(false);
 }
 
 //*************************************************************************************
@@ -779,19 +1336,49 @@ void FPEngine::mCleanupShaders()
 {
     fprintf(stdout, "[INFO]: ...deleting Shaders.\n");
     delete _regularShaderProgram;
-    delete _glitchedShaderProgram;
+    delete _monorailShaderProgram;
+    delete _regularMultiViewShaderProgram;
+    delete _monorailMultiViewShaderProgram;
 }
 
 void FPEngine::mCleanupBuffers()
 {
     fprintf(stdout, "[INFO]: ...deleting VAOs....\n");
     CSCI441::deleteObjectVAOs();
-    glDeleteVertexArrays(1, &_groundVAO);
 
     fprintf(stdout, "[INFO]: ...deleting VBOs....\n");
     CSCI441::deleteObjectVBOs();
 
     fprintf(stdout, "[INFO]: ...deleting models..\n");
+    // objects holding GL resources go while the context is still current
+    _objectPool.destroy(_pCartModel);
+    _pCartModel = nullptr;
+
+    _objectPool.destroy(_pTrackWatcher);
+    _pTrackWatcher = nullptr;
+
+    _objectPool.destroy(_pDynamicResolution);
+    _pDynamicResolution = nullptr;
+
+    _objectPool.destroy(_pGlitchEffect);
+    _pGlitchEffect = nullptr;
+
+    _objectPool.destroy(_pTerrain);
+    _pTerrain = nullptr;
+
+    _objectPool.destroy(_pTrackBuilder);
+    _pTrackBuilder = nullptr;
+
+    // the batches hand their ranges back to the pool
+    _objectPool.destroy(_pBeamBatch);
+    _pBeamBatch = nullptr;
+    _objectPool.destroy(_pControlPointBatch);
+    _pControlPointBatch = nullptr;
+    _objectPool.destroy(_pGeometryPool);
+    _pGeometryPool = nullptr;
+
+    _objectPool.destroy(_pFrameCapture);
+    _pFrameCapture = nullptr;
 
 }
 
@@ -800,127 +1387,92 @@ void FPEngine::mCleanupBuffers()
 //
 // Rendering / Drawing Functions - this is where the magic happens!
 
-void FPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const
+void FPEngine::_sendSceneUniforms() const
 {
     // use our texture shader program
-    _shaderPrograms[shaderIndex]->useProgram();
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useLight, 1); // Use lighting
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->time, static_cast<float>(glfwGetTime()));
-
-
-    //spotlight
-    glProgramUniform3fv(
-        _shaderPrograms[shaderIndex]->getShaderProgramHandle(),
-        _shaderUniformLocations[shaderIndex]->spotlightPos,
-        1,
-        glm::value_ptr(glm::vec3(0.0f, 1.0f, 0.0f))
-    );
-    glProgramUniform3fv(
-        _shaderPrograms[shaderIndex]->getShaderProgramHandle(),
-        _shaderUniformLocations[shaderIndex]->spotlightDir,
-        1,
-        glm::value_ptr(glm::vec3(0.0f, -1.0f, 0.0f))
-    );
-    glProgramUniform3fv(
-        _shaderPrograms[shaderIndex]->getShaderProgramHandle(),
-        _shaderUniformLocations[shaderIndex]->spotlightColor,
-        1,
-        glm::value_ptr(glm::vec3(1.0f, 0.0f, 1.0f))
-    );
+    _glState.useProgram(_pSceneShaderProgram->getShaderProgramHandle());
+    _setSceneUniform(_pSceneShaderUniformLocations->useLight, 1); // Use lighting
+
+
+    //spotlight, fixed in the world, so the state cache only sends it again when the view origin moves
+    _setSceneUniform(_pSceneShaderUniformLocations->spotlightPos, Transform::rebase(glm::vec3(0.0f, 1.0f, 0.0f), _renderOrigin));
+    _setSceneUniform(_pSceneShaderUniformLocations->spotlightDir, glm::vec3(0.0f, -1.0f, 0.0f));
+    _setSceneUniform(_pSceneShaderUniformLocations->spotlightColor, glm::vec3(1.0f, 0.0f, 1.0f));
     float innerCutoffAngle = 15.0f; // inner cutoff in degrees
     float outerCutoffAngle = 25.0f; // outer cutoff in degrees
-    glProgramUniform1f(
-        _shaderPrograms[shaderIndex]->getShaderProgramHandle(),
-        _shaderUniformLocations[shaderIndex]->spotlightCutOff,
-        cos(glm::radians(innerCutoffAngle))
-    );
-    glProgramUniform1f(
-        _shaderPrograms[shaderIndex]->getShaderProgramHandle(),
-        _shaderUniformLocations[shaderIndex]->spotlightOuterCutOff,
-        cos(glm::radians(outerCutoffAngle))
-    );
-
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useTexture, 1); // Use texture for skybox
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useLight, 0); // don't use light
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::SKYBOX]);
-    glm::mat4 modelMtx = glm::scale(glm::mat4(1.0f), glm::vec3(10.0f, 10.0f, 10.0f));
-    _computeAndSendMatrixUniforms(modelMtx, viewMtx, projMtx);
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->materialColor, glm::vec3(1.0f, 0.0f, 0.0f));
+    _setSceneUniform(_pSceneShaderUniformLocations->spotlightCutOff, cosf(glm::radians(innerCutoffAngle)));
+    _setSceneUniform(_pSceneShaderUniformLocations->spotlightOuterCutOff, cosf(glm::radians(outerCutoffAngle)));
+}
 
+void FPEngine::_renderScene(const Transform::ViewTransform& view, const bool occlusionCulled) const
+{
+    _renderOrigin = view.origin;
+    _sendSceneUniforms();
+
+    _setSceneUniform(_pSceneShaderUniformLocations->useTexture, 1); // Use texture for skybox
+    _setSceneUniform(_pSceneShaderUniformLocations->useLight, 0); // don't use light
+    _glState.bindTexture(0, _texHandles[TEXTURE_ID::SKYBOX]);
+    _computeEntityUniforms(view, _propEntities);
+    _sendEntityUniforms(_skyboxEntity);
+    _setSceneUniform(_pSceneShaderUniformLocations->materialColor, glm::vec3(1.0f, 0.0f, 0.0f));
+
+    // the terrain runs past the sky's walls, so the sky only ever fills the background
+    glDepthMask(GL_FALSE);
     CSCI441::drawSolidCubeTextured(100);
+    // CSCI441 binds its own vertex array
+    _glState.invalidateBindings();
+    glDepthMask(GL_TRUE);
 
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useLight, 1); // use light
+    _setSceneUniform(_pSceneShaderUniformLocations->useLight, 1); // use light
 
-    glBindTexture(GL_TEXTURE_2D, _texHandles[TEXTURE_ID::DIRT]); // use dirt texture
+    _glState.bindTexture(0, _texHandles[TEXTURE_ID::DIRT]); // use dirt texture
 
-    // _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useTexture, 0);
+    // _pSceneShaderProgram->setProgramUniform(_pSceneShaderUniformLocations->useTexture, 0);
     //// BEGIN DRAWING THE GROUND PLANE ////
-    // draw the ground plane
-    glm::mat4 groundModelMtx = glm::scale(glm::mat4(1.0f), glm::vec3(WORLD_SIZE, 1.0f, WORLD_SIZE));
-    _computeAndSendMatrixUniforms(groundModelMtx, viewMtx, projMtx);
+    // draw the ground plane, its chunks are already in world space
+    _sendMatrixUniforms(view.viewProjMtx, view.viewMtx, glm::mat3(1.0f));
 
     glm::vec3 groundColor(0.0f, 0.0f, 0.0f);
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->materialColor, groundColor);
+    _setSceneUniform(_pSceneShaderUniformLocations->materialColor, groundColor);
 
-    glm::vec3 cameraPosition = cameras[cameraIndex]->getPosition();
-    glUniform3fv(_shaderUniformLocations[shaderIndex]->cameraPos, 1, glm::value_ptr(cameraPosition));
+    _setSceneUniform(_pSceneShaderUniformLocations->cameraPos, view.cameraPosition);
 
-    glBindVertexArray(_groundVAO);
-    glDrawElements(GL_TRIANGLE_STRIP, _numGroundPoints, GL_UNSIGNED_SHORT, (void*)0);
+    _renderTerrain(occlusionCulled);
     //// END DRAWING THE GROUND PLANE ////
 
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useTexture, 0);  // don't texture
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->materialColor, glm::vec3(0.3f, 0.3f, 0.3f));
+    _setSceneUniform(_pSceneShaderUniformLocations->useTexture, 0);  // don't texture
+    _setSceneUniform(_pSceneShaderUniformLocations->materialColor, glm::vec3(0.3f, 0.3f, 0.3f));
 
     //// BEGIN DRAWING THE CART ////
-    if (!hero) {
-        glm::mat4 transToSpotMtx = glm::translate( glm::mat4( 1.0 ), cartPos );
-        // compute full model matrix
-        glm::mat4 modelMatrix = glm::rotate(transToSpotMtx, cartDirection, CSCI441::Y_AXIS);
-        _computeAndSendMatrixUniforms( modelMatrix, viewMtx, projMtx );
+    if (!hero && _isEntityDrawn(_cartEntity, occlusionCulled)) {
+        _sendEntityUniforms( _cartEntity );
 
-        _shaderPrograms[shaderIndex]->setProgramUniform( _shaderUniformLocations[shaderIndex]->materialColor, glm::vec3( 0.45, 0.45, 0.45 ) );
+        _setSceneUniform(_pSceneShaderUniformLocations->materialColor, glm::vec3( 0.45, 0.45, 0.45 ));
 
         if ( _pCartModel != nullptr )
         {
-            if ( !_pCartModel->draw( _glitchedShaderProgram->getShaderProgramHandle( ) ) )
+            _sendPositionDecode( _pCartModel->getPositionBounds() );
+            if ( !_pCartModel->draw() )
             {
                 fprintf( stderr, "[ERROR]: Could not draw OBJ Model\n" );
                 glfwSetWindowShouldClose( mpWindow, GLFW_TRUE );
             }
+            _glState.invalidateBindings();
+            _sendPositionDecode( VertexFormat::IDENTITY_BOUNDS );
         }
-    } else {
-        glm::mat4 transToSpotMtx = glm::translate( glm::mat4( 1.0 ), cartPos );
-        transToSpotMtx = glm::translate(transToSpotMtx, glm::vec3(0.0f, 0.5f, 0.0f));
-        transToSpotMtx = glm::rotate(transToSpotMtx, float(M_PI/2), CSCI441::X_AXIS);
-        transToSpotMtx = glm::scale(transToSpotMtx, glm::vec3(3.0f, 3.0f, 3.0f));
-        _computeAndSendMatrixUniforms( transToSpotMtx, viewMtx, projMtx );
-        _shaderPrograms[shaderIndex]->setProgramUniform( _shaderUniformLocations[shaderIndex]->materialColor, glm::vec3( 0.45, 0.45, 0.45 ) );
-        _sirByzler->drawPlane(transToSpotMtx, viewMtx, projMtx);
     }
     
     //***************************************************************************
     // draw each of the control points represented by a sphere
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useTexture, 0);  // don't texture
+    _setSceneUniform(_pSceneShaderUniformLocations->useTexture, 0);  // don't texture
     if (controlPoints) {
-        _shaderPrograms[shaderIndex]->setProgramUniform( _glitchedShaderUniformLocations.materialColor, glm::vec3( 1.0f, 0.0f, 1.0f ) );
-        for (int i = 0; i < _bezierCurve.numControlPoints; i++)
-        {
-            glm::mat4 modelMatrix = glm::translate(glm::mat4(1.0f), _bezierCurve.controlPoints[i]);
-            _computeAndSendTransformationMatrices(_shaderPrograms[shaderIndex],
-                                                modelMatrix, viewMtx, projMtx,
-                                                _shaderUniformLocations[shaderIndex]->mvpMatrix,
-                                                _shaderUniformLocations[shaderIndex]->normalMatrix);
-            CSCI441::drawSolidSphere(0.25f, 16, 16);
-        }
+        _setSceneUniform(_pSceneShaderUniformLocations->materialColor, glm::vec3( 1.0f, 0.0f, 1.0f ));
+        _renderStaticBatch(_pControlPointBatch, _controlPointEntities, view, occlusionCulled);
     }
 
 
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
-    _computeAndSendTransformationMatrices(_shaderPrograms[shaderIndex],
-                                            modelMatrix, viewMtx, projMtx,
-                                            _shaderUniformLocations[shaderIndex]->mvpMatrix,
-                                            _shaderUniformLocations[shaderIndex]->normalMatrix);
+    _setSceneUniform(_pSceneShaderUniformLocations->mvpMatrix, view.viewProjMtx);
+    _setSceneUniform(_pSceneShaderUniformLocations->normalMatrix, glm::mat3(1.0f));
 
     //***************************************************************************
     // draw the animated evaluation sphere
@@ -937,26 +1489,139 @@ void FPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const
     
     //***************************************************************************
     // draw monorail
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->materialColor, glm::vec3(0.0));
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useLight, 0);
-    renderMonorail(_vaos[MONO_RAIL], _monorailIndices.size());
+    _setSceneUniform(_pSceneShaderUniformLocations->materialColor, glm::vec3(0.0));
+    _setSceneUniform(_pSceneShaderUniformLocations->useLight, 0);
+    if (_tessellatedMonorail) {
+        _renderTessellatedMonorail(view);
+    } else {
+        renderMonorail(_vaos[MONO_RAIL]);
+    }
 
     // draw support beams
-    for (int i = 0; i < _bezierCurve.curvePoints.size(); i++) {
-        if (i % 50 == 0) {
-            modelMtx = glm::mat4(1.0f);
-            modelMtx = glm::translate(modelMtx, _bezierCurve.curvePoints[i]);
-            modelMtx = glm::translate(modelMtx, glm::vec3(0.0f, -_bezierCurve.curvePoints[i].y / 2, 0.0f));
-            modelMtx = glm::scale(modelMtx, glm::vec3(1.0f, 2*_bezierCurve.curvePoints[i].y, 1.0f));
-            _computeAndSendMatrixUniforms( modelMtx, viewMtx, projMtx );
-            CSCI441::drawSolidCube(0.5f);
+    _renderStaticBatch(_pBeamBatch, _beamEntities, view, occlusionCulled);
+
+    // lines and the hero plane are drawn per view by _renderMultiView()
+    if (!_multiView) {
+        _renderViewPrimitives(view);
+    }
+}
+
+void FPEngine::_renderTerrain(const bool occlusionCulled) const
+{
+    if (!_pTerrain) return;
+
+    const std::vector<Terrain::Chunk>& chunks = _pTerrain->getVisibleChunks();
+    const bool culled = occlusionCulled && _occlusionCulling;
+    _glState.bindVertexArray(_pTerrain->getVAO());
+    for (GLuint c = 0; c < chunks.size(); c++) {
+        if (culled && !_chunkDrawn[c]) continue;
+        const Terrain::Chunk& chunk = chunks[c];
+        _sendWorldPositionDecode(chunk.bounds);
+        glDrawElementsBaseVertex(GL_TRIANGLES, _pTerrain->getNumIndices(), GL_UNSIGNED_SHORT, (void*)0, chunk.baseVertex);
+    }
+    _sendPositionDecode(VertexFormat::IDENTITY_BOUNDS);
+}
+
+void FPEngine::_updateStaticGeometry()
+{
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::RENDER);
+    _pBeamBatch->update(_scene.getModelMatrices() + _beamEntities.first, _scene.getNormalMatrices() + _beamEntities.first);
+    _pControlPointBatch->update(_scene.getModelMatrices() + _controlPointEntities.first,
+                                _scene.getNormalMatrices() + _controlPointEntities.first);
+}
+
+void FPEngine::_renderStaticBatch(StaticBatch* pBatch, const SceneRegistry::Range range,
+                                  const Transform::ViewTransform& view, const bool occlusionCulled) const
+{
+    // copies are already in world space
+    _sendMatrixUniforms(view.viewProjMtx, view.viewMtx, glm::mat3(1.0f));
+    _sendWorldPositionDecode(pBatch->getBounds());
+    _pGeometryPool->clearDraws();
+    for (GLuint copy = 0; copy < range.count; copy++) {
+        if (_isEntityDrawn(range.first + copy, occlusionCulled)) pBatch->addDraw(copy);
+    }
+    _pGeometryPool->submitDraws();
+    _glState.invalidateBindings();
+    _sendPositionDecode(VertexFormat::IDENTITY_BOUNDS);
+}
+
+void FPEngine::_cullOccluded()
+{
+    if (!_occlusionCulling || _views.empty()) return;
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::RENDER);
+
+    // the terrain is the only occluder large enough to be worth rasterizing.  The culler works in
+    // absolute world space, where float is plenty for a buffer this coarse
+    const Transform::ViewTransform& view = _views[0].transform;
+    _occlusionCuller.beginFrame(view.viewProjMtx * glm::translate(glm::mat4(1.0f), -glm::vec3(view.origin)));
+    if (_pTerrain) {
+        for (const Terrain::Chunk& chunk : _pTerrain->getVisibleChunks()) {
+            _occlusionCuller.rasterizeHeightGrid(chunk.origin, chunk.size, Terrain::OCCLUDER_CELLS, chunk.occluderHeights);
+        }
+    }
+    _occlusionCuller.buildPyramid();
+
+    if (_pTerrain) {
+        const std::vector<Terrain::Chunk>& chunks = _pTerrain->getVisibleChunks();
+        _chunkDrawn.resize(chunks.size());
+        for (GLuint c = 0; c < chunks.size(); c++) {
+            _chunkDrawn[c] = _occlusionCuller.isVisible(chunks[c].bounds.origin, chunks[c].bounds.origin + chunks[c].bounds.extent);
+        }
+    }
+
+    // beams are 0.5 cubes and control points spheres before their model matrices
+    _cullEntities(_beamEntities, glm::vec3(-0.25f), glm::vec3(0.25f));
+    if (controlPoints) {
+        _cullEntities(_controlPointEntities, glm::vec3(-CONTROL_POINT_RADIUS), glm::vec3(CONTROL_POINT_RADIUS));
+    }
+    if (!hero && _pCartModel) {
+        const PositionBounds& bounds = _pCartModel->getPositionBounds();
+        _cullEntities({_cartEntity, 1}, bounds.origin, bounds.origin + bounds.extent);
+    }
+}
+
+void FPEngine::_cullEntities(const SceneRegistry::Range range, const glm::vec3 localMin, const glm::vec3 localMax)
+{
+    const glm::vec3 localCenter = 0.5f * (localMin + localMax);
+    const glm::vec3 localHalfExtent = 0.5f * (localMax - localMin);
+    for (SceneRegistry::Entity entity = range.first; entity < range.first + range.count; entity++) {
+        // world box of the transformed local box, each axis gathering the extents it is rotated onto
+        const glm::mat4& modelMtx = _scene.getModelMatrix(entity);
+        const glm::vec3 center = glm::vec3(modelMtx * glm::vec4(localCenter, 1.0f));
+        const glm::vec3 halfExtent = glm::abs(glm::vec3(modelMtx[0])) * localHalfExtent.x
+                                   + glm::abs(glm::vec3(modelMtx[1])) * localHalfExtent.y
+                                   + glm::abs(glm::vec3(modelMtx[2])) * localHalfExtent.z;
+        GLubyte& occludedFrames = _entityOccludedFrames[entity];
+        if (_occlusionCuller.isVisible(center - halfExtent, center + halfExtent)) {
+            occludedFrames = 0;
+        } else if (occludedFrames < OCCLUSION_HYSTERESIS) {
+            occludedFrames++;
         }
     }
+}
+
+bool FPEngine::_isEntityDrawn(const SceneRegistry::Entity entity, const bool occlusionCulled) const
+{
+    return !occlusionCulled || !_occlusionCulling || _entityOccludedFrames[entity] < OCCLUSION_HYSTERESIS;
+}
+
+void FPEngine::_renderViewPrimitives(const Transform::ViewTransform& view) const
+{
+    _renderOrigin = view.origin;
+    if (hero) {
+        _computeEntityUniforms(view, {_heroEntity, 1});
+        _sendEntityUniforms( _heroEntity );
+        _setSceneUniform(_pSceneShaderUniformLocations->materialColor, glm::vec3( 0.45, 0.45, 0.45 ));
+        _sirByzler->drawPlane(Transform::rebase(_scene.getModelMatrix(_heroEntity), view.origin), view.viewMtx, view.projMtx);
+        // the plane sets its own matrices and color on the single view program
+        _glState.invalidateUniforms(_regularShaderProgram->getShaderProgramHandle());
+        _glState.invalidateBindings();
+    }
 
     // use the flat shader to draw lines
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->useLight, 0); // don't use lighting for lines
-    modelMatrix = glm::mat4(1.0f);
-    _computeAndSendMatrixUniforms(modelMatrix, viewMtx, projMtx);
+    _setSceneUniform(_pSceneShaderUniformLocations->useTexture, 0);  // don't texture
+    _setSceneUniform(_pSceneShaderUniformLocations->useLight, 0); // don't use lighting for lines
+    _sendMatrixUniforms(view.viewProjMtx, view.viewMtx, glm::mat3(1.0f));
     // draw the curve control cage
     // glBindVertexArray(_vaos[VAO_ID::BEZIER_CAGE]);
     // glDrawArrays(GL_LINE_STRIP, 0, _numVAOPoints[VAO_ID::BEZIER_CAGE]);
@@ -964,20 +1629,133 @@ void FPEngine::_renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const
     //***************************************************************************
     // draw the curve
     // LOOKHERE #1 draw the curve itself
-    glBindVertexArray(_vaos[VAO_ID::BEZIER_CURVE]);
+    _sendWorldPositionDecode(VertexFormat::IDENTITY_BOUNDS);
+    _glState.bindVertexArray(_vaos[VAO_ID::BEZIER_CURVE]);
     glDrawArrays(GL_LINE_STRIP, 0, _numVAOPoints[VAO_ID::BEZIER_CURVE]);
+    _sendPositionDecode(VertexFormat::IDENTITY_BOUNDS);
 }
 
-void FPEngine::_updateScene()
+void FPEngine::_collectViews(GLint renderWidth, GLint renderHeight, GLfloat renderScale)
 {
-    if (currBezierIndex >= 305 && currBezierIndex <= 405) {
-        shaderIndex = 1;
-        _sirByzler->flyForward();
-        hero = true;
+    _views.clear();
+
+    // one level of detail for every view, chosen for the current camera
+    if (_pTerrain) {
+        _pTerrain->update(cameras[cameraIndex]->getPosition());
+    }
+    // beams and control points moved by this frame's edits
+    _updateStaticGeometry();
+
+    // the current camera fills the window
+    RenderView mainView;
+    mainView.transform = Transform::makeViewTransform(cameras[cameraIndex]->getViewMatrix(), cameras[cameraIndex]->getProjectionMatrix());
+    mainView.viewport[0] = 0.0f;
+    mainView.viewport[1] = 0.0f;
+    mainView.viewport[2] = renderWidth;
+    mainView.viewport[3] = renderHeight;
+    _views.push_back(mainView);
+
+    // picture in picture map in the top right corner
+    if (firstPerson) {
+        RenderView mapView;
+        // drawn relative to the main camera, so both views can share one world space submission
+        mapView.transform = Transform::makeViewTransform(_pMapCam->getViewMatrix(), _pMapCam->getProjectionMatrix(),
+                                                         mainView.transform.origin);
+        // the inset keeps its size on screen whatever the render scale
+        const GLfloat mapSize = 200.0f * renderScale;
+        mapView.viewport[0] = renderWidth - mapSize;
+        mapView.viewport[1] = renderHeight - mapSize;
+        mapView.viewport[2] = mapSize;
+        mapView.viewport[3] = mapSize;
+        _views.push_back(mapView);
+    }
+}
+
+void FPEngine::_renderViews()
+{
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::RENDER);
+    // track rebuilds and post-processing bind their own programs, vertex arrays and textures
+    _glState.invalidateBindings();
+    if (_multiView && _views.size() <= MAX_VIEWS) {
+        _renderMultiView();
     } else {
-        shaderIndex = 0;
-        hero = false;
+        for (GLuint v = 0; v < _views.size(); v++) {
+            // later views sit on top of earlier ones
+            if (v > 0) glClear(GL_DEPTH_BUFFER_BIT);
+            glViewport(_views[v].viewport[0], _views[v].viewport[1], _views[v].viewport[2], _views[v].viewport[3]);
+            // every view pass reuses the same arena memory for its matrices
+            const FrameArena::Marker marker = _frameArena.getMarker();
+            _renderScene(_views[v].transform, v == 0);
+            _frameArena.rewind(marker);
+        }
     }
+    // draws leave their vertex array bound, so buffer uploads after the frame cannot touch it
+    _glState.bindVertexArray(0);
+}
+
+void FPEngine::_viewDepthRange(GLuint view, GLdouble& nearDepth, GLdouble& farDepth) const
+{
+    const GLdouble slice = 1.0 / _views.size();
+    nearDepth = (_views.size() - 1 - view) * slice;
+    farDepth = nearDepth + slice;
+}
+
+void FPEngine::_renderMultiView()
+{
+    const GLsizei numViews = _views.size();
+
+    // viewport i and depth range i belong to view i, the geometry shader picks one per invocation
+    glm::mat4* viewProjMatrices = _frameArena.allocate<glm::mat4>(numViews);
+    glm::vec3* cameraPositions = _frameArena.allocate<glm::vec3>(numViews);
+    for (GLsizei v = 0; v < numViews; v++) {
+        GLdouble nearDepth, farDepth;
+        _viewDepthRange(v, nearDepth, farDepth);
+        glViewportIndexedf(v, _views[v].viewport[0], _views[v].viewport[1], _views[v].viewport[2], _views[v].viewport[3]);
+        glDepthRangeIndexed(v, nearDepth, farDepth);
+        viewProjMatrices[v] = _views[v].transform.viewProjMtx;
+        cameraPositions[v] = _views[v].transform.cameraPosition;
+    }
+    const std::pair<CSCI441::ShaderProgram*, const shaderUniformLocations*> multiViewPrograms[2] = {
+        {_regularMultiViewShaderProgram, &_regularMultiViewShaderUniformLocations},
+        {_monorailMultiViewShaderProgram, &_monorailMultiViewShaderUniformLocations}
+    };
+    for (const auto& program : multiViewPrograms) {
+        const GLuint handle = program.first->getShaderProgramHandle();
+        glProgramUniformMatrix4fv(handle, program.second->viewProjMatrices, numViews, GL_FALSE, glm::value_ptr(viewProjMatrices[0]));
+        glProgramUniform3fv(handle, program.second->cameraPositions, numViews, glm::value_ptr(cameraPositions[0]));
+        glProgramUniform1i(handle, program.second->numViews, numViews);
+    }
+
+    // one submission of the scene in world space relative to the shared view origin, projected
+    // into every view by the geometry shader.  The monorail still picks its level of detail from
+    // the main camera
+    Transform::ViewTransform world = Transform::makeViewTransform(glm::mat4(1.0f), glm::mat4(1.0f));
+    world.origin = _views[0].transform.origin;
+    world.cameraPosition = _views[0].transform.cameraPosition;
+    _selectShaderPrograms(true);
+    _renderScene(world, false);
+    _selectShaderPrograms(false);
+
+    // lines and the hero plane go through the single view programs, which only use viewport 0
+    _sendSceneUniforms();
+    for (GLsizei v = 0; v < numViews; v++) {
+        GLdouble nearDepth, farDepth;
+        _viewDepthRange(v, nearDepth, farDepth);
+        glViewportIndexedf(0, _views[v].viewport[0], _views[v].viewport[1], _views[v].viewport[2], _views[v].viewport[3]);
+        glDepthRangeIndexed(0, nearDepth, farDepth);
+        _renderViewPrimitives(_views[v].transform);
+    }
+    glDepthRangeIndexed(0, 0.0, 1.0);
+}
+
+void FPEngine::_updateScene()
+{
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::SCENE);
+    if (_pTrackWatcher && _pTrackWatcher->poll(_reloadedControlPoints)) {
+        _reloadTrack(_reloadedControlPoints);
+    }
+    _applyTrackEdits();
+
     // switch cams
     if (_keys[GLFW_KEY_SPACE])
     {
@@ -1007,6 +1785,17 @@ void FPEngine::_updateScene()
         _keys[GLFW_KEY_C] = false;
     }
 
+    if (_keys[GLFW_KEY_T]) {
+        _tessellatedMonorail = !_tessellatedMonorail;
+        _keys[GLFW_KEY_T] = false;
+    }
+
+    if (_keys[GLFW_KEY_V]) {
+        _multiView = !_multiView;
+        fprintf(stdout, "[INFO]: %s rendering\n", _multiView ? "multi-view" : "per view");
+        _keys[GLFW_KEY_V] = false;
+    }
+
     if (_keys[GLFW_KEY_1]) {
         animate = !animate;
 
@@ -1016,7 +1805,7 @@ void FPEngine::_updateScene()
     // move cart forward
     if (_keys[GLFW_KEY_W] || _keys[GLFW_KEY_UP]) {
         if (cameraIndex == 1) {
-            cameras[cameraIndex]->moveForward(0.5f);
+            cameras[cameraIndex]->moveForward(FREE_CAM_SPEED * _frameStep);
         } else if (!animate) {
             currBezierIndex++;
             if (currBezierIndex >= _bezierCurve.curvePoints.size()) {
@@ -1031,7 +1820,7 @@ void FPEngine::_updateScene()
     // move cart backward
     if (_keys[GLFW_KEY_S] || _keys[GLFW_KEY_DOWN]) {
         if (cameraIndex == 1) {
-            cameras[cameraIndex]->moveBackward(0.5f);
+            cameras[cameraIndex]->moveBackward(FREE_CAM_SPEED * _frameStep);
         } else if (!animate) {
             currBezierIndex--;
             if (currBezierIndex < 0) {
@@ -1061,15 +1850,112 @@ void FPEngine::_updateScene()
         glm::vec3 direction = glm::normalize(_bezierCurve.curvePoints[nextIndex] - _bezierCurve.curvePoints[prevIndex]);
         
         cartDirection = atan2(direction.z, direction.x) + M_PI/2;  // set cart orientation to tangent of the curve
-
         cartPos = _bezierCurve.curvePoints[currBezierIndex];
-        _pArcballCam->setLookAtPoint(cartPos);
+    }
+
+    _applyTrackZone();
+    _placeRide(cartPos, cartDirection);
+}
+
+void FPEngine::_applyTrackZone()
+{
+    if (currBezierIndex < (int)_arcLengths.size()) {
+        if (_cartJumped) {
+            _trackZones.seek(_arcLengths[currBezierIndex]);
+        } else {
+            _trackZones.moveTo(_arcLengths[currBezierIndex]);
+        }
+    }
+    _cartJumped = false;
+
+    // lighting and camera zones only need attention when one is entered or left
+    bool lightingChanged = false, cameraChanged = false;
+    for (const TrackZones::Event& event : _trackZones.getEvents()) {
+        const TrackZones::Action action = _trackZones.getZone(event.zone).action;
+        lightingChanged = lightingChanged || action == TrackZones::Action::LIGHTING;
+        cameraChanged = cameraChanged || action == TrackZones::Action::CAMERA;
+    }
+
+    TrackZones::Zone zone;
+    if (lightingChanged) {
+        _setLighting(_trackZones.getLatestActive(TrackZones::Action::LIGHTING, zone) ? zone.value : _defaultLightColor);
+    }
+    if (cameraChanged) {
+        if (_trackZones.getLatestActive(TrackZones::Action::CAMERA, zone)) {
+            if (_riderCameraIndex < 0) _riderCameraIndex = cameraIndex;
+            cameraIndex = std::clamp(static_cast<int>(zone.value.x), 0, 1);
+        } else if (_riderCameraIndex >= 0) {
+            cameraIndex = _riderCameraIndex;
+            _riderCameraIndex = -1;
+        }
         _pArcballCam->recomputeOrientation();
+        _pFreeCam->recomputeOrientation();
+    }
+
+    _glitchActive = _trackZones.isActive(TrackZones::Action::GLITCH);
+    hero = _trackZones.getLatestActive(TrackZones::Action::HERO, zone);
+    if (hero) {
+        // the live ride moves one sample a frame, so this is the frames spent in the zone
+        const GLuint zoneStart = _sampleAtArcLength(zone.begin);
+        _flyHero(currBezierIndex > (int)zoneStart ? currBezierIndex - zoneStart + 1 : 1);
     }
+}
+
+void FPEngine::_flyHero(const GLuint steps)
+{
+    // SirByzler only flies forward, so a plane that is ahead starts over
+    if (steps < _heroSteps) {
+        _objectPool.destroy(_sirByzler);
+        _sirByzler = _objectPool.create<SirByzler>(_regularShaderProgram->getShaderProgramHandle(),
+                                                   _regularShaderUniformLocations.mvpMatrix,
+                                                   _regularShaderUniformLocations.normalMatrix,
+                                                   _regularShaderUniformLocations.materialColor);
+        _heroSteps = 0;
+    }
+    for (; _heroSteps < steps; _heroSteps++) {
+        _sirByzler->flyForward();
+    }
+}
+
+void FPEngine::_placeRide(const glm::vec3 position, const GLfloat direction)
+{
+    cartPos = position;
+    cartDirection = direction;
+    _pArcballCam->setLookAtPoint(cartPos);
+    _pArcballCam->recomputeOrientation();
 
     _pMapCam->setTheta(-cartDirection + M_PI);
     _pMapCam->setPosition(cartPos + glm::vec3(0.0f, 2.0f, 0.0f));
     _pMapCam->recomputeOrientation();
+
+    // move the cart entities with the ride, then rebuild the matrices of whatever changed
+    _scene.setTranslation(_cartEntity, cartPos);
+    _scene.setRotation(_cartEntity, glm::mat3(glm::rotate(glm::mat4(1.0f), cartDirection, CSCI441::Y_AXIS)));
+    _scene.setTranslation(_heroEntity, cartPos + glm::vec3(0.0f, 0.5f, 0.0f));
+    _scene.update();
+}
+
+void FPEngine::_placeRideAt(const double seconds)
+{
+    const std::vector<glm::vec3>& points = _bezierCurve.curvePoints;
+    if (points.size() < 2 || _arcLengths.size() != points.size()) return;
+
+    // constant speed along the track, so a lap takes as long as the live ride's
+    const double lapSeconds = _lapSeconds();
+    const GLfloat distance = static_cast<GLfloat>(fmod(seconds, lapSeconds) / lapSeconds) * _arcLengths.back();
+
+    // interpolate within the sample segment containing the distance
+    GLuint segment = std::upper_bound(_arcLengths.begin(), _arcLengths.end(), distance) - _arcLengths.begin();
+    segment = std::min<GLuint>(std::max<GLuint>(segment, 1), points.size() - 1) - 1;
+    const GLfloat segmentLength = _arcLengths[segment + 1] - _arcLengths[segment];
+    const GLfloat t = segmentLength > 0.0f ? (distance - _arcLengths[segment]) / segmentLength : 0.0f;
+
+    currBezierIndex = t < 0.5f ? segment : segment + 1;
+    _applyTrackZone();
+
+    const glm::vec3 tangent = points[segment + 1] - points[segment];
+    const GLfloat direction = glm::dot(tangent, tangent) > 0.0f ? atan2f(tangent.z, tangent.x) + M_PI / 2 : cartDirection;
+    _placeRide(glm::mix(points[segment], points[segment + 1], t), direction);
 }
 
 
@@ -1078,12 +1964,47 @@ void FPEngine::run()
     //  This is our draw loop - all rendering is done here.  We use a loop to keep the window open
     //	until the user decides to close the window and quit the program.  Without a loop, the
     //	window will display once and then the program exits.
+    if (_offline) {
+        _runOffline();
+        return;
+    }
+
+    double frameStart = glfwGetTime();
     while (!glfwWindowShouldClose(mpWindow))
     {
+        // keep the driver from queueing frames ahead, then sample input as late as possible so
+        // the frame simulated and drawn next already reflects it
+        _framePacer.waitForQueue();
+        AllocationTracker::beginFrame();
+        _glState.beginFrame();
+        _frameArena.reset();
+        {
+            AllocationTracker::Scope scope(AllocationTracker::Subsystem::INPUT);
+            glfwPollEvents(); // check for any events and signal to redraw screen
+        }
+
+        // feed back the input recorded during this frame
+        InputRecorder::InputEvent event;
+        while (_inputRecorder.nextEvent(_frameNumber, event))
+        {
+            _dispatchInputEvent(event);
+        }
+        if (_inputRecorder.isReplayFinished(_frameNumber))
+        {
+            setWindowShouldClose();
+        }
+        _framePacer.inputSampled();
+
+        // a replay already took this frame's clock from the log with the input
+        if (_inputRecorder.getMode() != InputRecorder::Mode::REPLAY)
+        {
+            _simulationTime = static_cast<GLfloat>(glfwGetTime());
+        }
+        _inputRecorder.recordFrame(_frameNumber, _simulationTime, _frameStep);
+        _updateScene();
+
         // check if the window was instructed to be closed
         glDrawBuffer(GL_BACK); // work with our back frame buffer
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        // clear the current color contents and depth buffer in the window
 
         // Get the size of our framebuffer.  Ideally this should be the same dimensions as our window, but
         // when using a Retina display the actual window can be larger than the requested window.  Therefore,
@@ -1091,22 +2012,161 @@ void FPEngine::run()
         GLint framebufferWidth, framebufferHeight;
         glfwGetFramebufferSize(mpWindow, &framebufferWidth, &framebufferHeight);
 
-        // update the viewport - tell OpenGL we want to render to the whole window
-        glViewport(0, 0, framebufferWidth, framebufferHeight);
-        // draw everything to the window
-        _renderScene(cameras[cameraIndex]->getViewMatrix(), cameras[cameraIndex]->getProjectionMatrix());
+        // with a frame budget the scene goes to an offscreen target sized to fit the budget
+        GLint renderWidth = framebufferWidth, renderHeight = framebufferHeight;
+        if (_pDynamicResolution) {
+            _pDynamicResolution->beginFrame(framebufferWidth, framebufferHeight, renderWidth, renderHeight);
+        }
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // clear the current color contents and depth buffer
+
+        // draw everything, from every view
+        _collectViews(renderWidth, renderHeight, framebufferWidth > 0 ? static_cast<GLfloat>(renderWidth) / framebufferWidth : 1.0f);
+        _cullOccluded();
+        _renderViews();
+        if (_pDynamicResolution) {
+            _pDynamicResolution->endFrame();
+        }
+        if (_glitchActive && _pGlitchEffect) {
+            _pGlitchEffect->apply(0, framebufferWidth, framebufferHeight, _simulationTime);
+        }
+        if (_pFrameCapture) {
+            AllocationTracker::Scope scope(AllocationTracker::Subsystem::CAPTURE);
+            _pFrameCapture->captureFrame(framebufferWidth, framebufferHeight);
+        }
 
-        if (firstPerson) {
-            glClear(GL_DEPTH_BUFFER_BIT);
-            glViewport(framebufferWidth - 200, framebufferHeight - 200, 200, 200);
-            _renderScene(_pMapCam->getViewMatrix(), _pMapCam->getProjectionMatrix());
+        glfwSwapBuffers(mpWindow); // flush the OpenGL commands and make sure they get rendered!
+        if (_checkAllocations) _checkFrameAllocations();
+
+        double frameEnd = glfwGetTime();
+        _framePacer.framePresented(_frameNumber, frameEnd - frameStart);
+        _logFinishedFrames();
+        if (_inputRecorder.getMode() != InputRecorder::Mode::REPLAY)
+        {
+            _frameStep = static_cast<GLfloat>(std::min(frameEnd - frameStart, static_cast<double>(MAX_FRAME_STEP)));
+        }
+        frameStart = frameEnd;
+        _frameNumber++;
+    }
+
+    if (_pFrameCapture) _pFrameCapture->finish();
+    _framePacer.finish();
+    _logFinishedFrames();
+    if (_framePacer.getNumMeasuredFrames() > 0)
+    {
+        fprintf(stdout, "[INFO]: input latency over %u frames: %.2f ms average, %.2f ms worst\n",
+                _framePacer.getNumMeasuredFrames(), _framePacer.getAverageLatency() * 1000.0, _framePacer.getMaxLatency() * 1000.0);
+    }
+    _inputRecorder.finish(_frameNumber);
+    if (_checkAllocations) _reportAllocations();
+    _reportGLState();
+}
+
+void FPEngine::_checkFrameAllocations()
+{
+    const size_t allocations = AllocationTracker::getFrameAllocations();
+    if (allocations == 0 || _frameNumber < _steadyStateFrame) return;
+
+    _numAllocatingFrames++;
+    fprintf(stderr, "[ERROR]: frame %u made %zu heap allocations in steady state:", _frameNumber, allocations);
+    for (int s = 0; s < AllocationTracker::NUM_SUBSYSTEMS; s++) {
+        const auto subsystem = static_cast<AllocationTracker::Subsystem>(s);
+        const AllocationTracker::Counters counters = AllocationTracker::getFrameCounters(subsystem);
+        if (counters.allocations > 0) {
+            fprintf(stderr, " %s %zu (%zu bytes)", AllocationTracker::getName(subsystem), counters.allocations, counters.bytes);
         }
+    }
+    fprintf(stderr, "\n");
+}
 
+void FPEngine::_reportAllocations() const
+{
+    fprintf(stdout, "[INFO]: %u of %u steady state frames allocated, frame arena high water %zu of %zu bytes\n",
+            _numAllocatingFrames, _frameNumber > _steadyStateFrame ? _frameNumber - _steadyStateFrame : 0,
+            _frameArena.getHighWater(), _frameArena.getCapacity());
+    for (int s = 0; s < AllocationTracker::NUM_SUBSYSTEMS; s++) {
+        const auto subsystem = static_cast<AllocationTracker::Subsystem>(s);
+        const AllocationTracker::Counters counters = AllocationTracker::getTotalCounters(subsystem);
+        fprintf(stdout, "[INFO]:   %-8s %zu allocations, %zu bytes\n", AllocationTracker::getName(subsystem), counters.allocations, counters.bytes);
+    }
+}
 
-        _updateScene();
-        glfwSwapBuffers(mpWindow); // flush the OpenGL commands and make sure they get rendered!
+void FPEngine::_reportGLState() const
+{
+    const unsigned long long issued = _glState.getTotalIssued();
+    const unsigned long long elided = _glState.getTotalElided();
+    if (_frameNumber == 0 || issued + elided == 0) return;
+    fprintf(stdout, "[INFO]: state cache issued %.1f and elided %.1f GL calls per frame (%.0f%% elided), last frame %u and %u\n",
+            static_cast<double>(issued) / _frameNumber, static_cast<double>(elided) / _frameNumber,
+            100.0 * elided / (issued + elided), _glState.getNumIssued(), _glState.getNumElided());
+}
 
-        glfwPollEvents(); // check for any events and signal to redraw screen
+void FPEngine::_runOffline()
+{
+    const GLint width = _offlineJob.width;
+    const GLint height = _offlineJob.height;
+
+    // the hidden window only provides the context, frames are drawn at the job's resolution
+    GLuint framebuffer, renderbuffers[2];
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+
+    FrameCapture capture(_offlineJob.output.c_str(), _offlineJob.framesPerSecond);
+    capture.setFrameNumbering(_offlineJob.worker, _offlineJob.numWorkers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        fprintf(stderr, "[ERROR]: Could not create a %dx%d offline render target\n", width, height);
+    }
+    else if (capture.start())
+    {
+        // the inset keeps its share of the picture at any output resolution
+        GLint windowWidth, windowHeight;
+        glfwGetWindowSize(mpWindow, &windowWidth, &windowHeight);
+        const GLfloat renderScale = windowHeight > 0 ? static_cast<GLfloat>(height) / windowHeight : 1.0f;
+
+        // every frame is a function of its simulation time, so any worker can render any frame
+        const GLuint numFrames = _offlineJob.numFrames > 0 ? _offlineJob.numFrames
+                                 : _lapFrames(_bezierCurve.numCurves, _offlineJob.framesPerSecond);
+        for (GLuint frame = _offlineJob.worker; frame < numFrames; frame += _offlineJob.numWorkers)
+        {
+            _frameNumber = frame;
+            _glState.beginFrame();
+            _frameArena.reset();
+            _simulationTime = static_cast<GLfloat>(frame) / _offlineJob.framesPerSecond;
+            _placeRideAt(_simulationTime);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            _collectViews(width, height, renderScale);
+            _cullOccluded();
+            _renderViews();
+            if (_glitchActive && _pGlitchEffect) {
+                _pGlitchEffect->apply(framebuffer, width, height, _simulationTime);
+            }
+            capture.captureFrame(width, height);
+        }
+        capture.finish();
+        _offlineSucceeded = capture.getNumFramesLost() == 0;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(2, renderbuffers);
+}
+
+void FPEngine::_logFinishedFrames()
+{
+    FramePacer::FrameTiming timing;
+    while (_framePacer.nextFrameTiming(timing))
+    {
+        _inputRecorder.recordFrameTime(timing.frame, timing.frameSeconds, timing.latencySeconds);
     }
 }
 
@@ -1114,18 +2174,56 @@ void FPEngine::run()
 //
 // Private Helper Functions
 
-void FPEngine::_computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const
+void FPEngine::_computeEntityUniforms(const Transform::ViewTransform& view, const SceneRegistry::Range range) const
+{
+    _entityMVPMatrices = _frameArena.allocate<glm::mat4>(range.count);
+    _entityModelViewMatrices = _frameArena.allocate<glm::mat4>(range.count);
+    _entityUniformsFirst = range.first;
+    Transform::computeMatrixUniforms(view, _scene.getModelMatrices() + range.first, range.count,
+                                     _entityMVPMatrices, _entityModelViewMatrices);
+}
+
+void FPEngine::_sendEntityUniforms(const SceneRegistry::Entity entity) const
+{
+    _sendMatrixUniforms(_entityMVPMatrices[entity - _entityUniformsFirst], _entityModelViewMatrices[entity - _entityUniformsFirst],
+                        _scene.getNormalMatrix(entity));
+}
+
+void FPEngine::_sendMatrixUniforms(const glm::mat4& mvpMtx, const glm::mat4& modelViewMtx, const glm::mat3& normalMtx) const
+{
+    _setSceneUniform(_pSceneShaderUniformLocations->mvpMatrix, mvpMtx);
+    _setSceneUniform(_pSceneShaderUniformLocations->modelViewMtx, modelViewMtx);
+    _setSceneUniform(_pSceneShaderUniformLocations->normalMatrix, normalMtx);
+}
+
+void FPEngine::_computeMouseRay(glm::vec2 mousePosition, glm::vec3& origin, glm::vec3& direction) const
 {
-    // precompute the Model-View-Projection matrix on the CPU
-    glm::mat4 mvpMtx = projMtx * viewMtx * modelMtx;
-    // then send it to the shader on the GPU to apply to every vertex
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->mvpMatrix, mvpMtx);
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->modelViewMtx, (viewMtx * modelMtx));
+    GLint windowWidth, windowHeight;
+    glfwGetWindowSize(mpWindow, &windowWidth, &windowHeight);
 
-    // TODO #7: compute and send the normal matrix
-    glm::mat3 normalMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
-    _shaderPrograms[shaderIndex]->setProgramUniform(_shaderUniformLocations[shaderIndex]->normalMatrix, normalMtx);
+    // window coordinates to normalized device coordinates, flipping y
+    glm::vec2 ndc(2.0f * mousePosition.x / windowWidth - 1.0f, 1.0f - 2.0f * mousePosition.y / windowHeight);
 
+    // unproject the cursor onto the near and far planes
+    glm::mat4 inverseViewProj = glm::inverse(cameras[cameraIndex]->getProjectionMatrix() * cameras[cameraIndex]->getViewMatrix());
+    glm::vec4 nearPoint = inverseViewProj * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+    glm::vec4 farPoint = inverseViewProj * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+
+    origin = glm::vec3(nearPoint) / nearPoint.w;
+    direction = glm::normalize(glm::vec3(farPoint) / farPoint.w - origin);
+}
+
+void FPEngine::_sendPositionDecode(const PositionBounds& bounds) const
+{
+    _setSceneUniform(_pSceneShaderUniformLocations->positionOffset, bounds.origin);
+    _setSceneUniform(_pSceneShaderUniformLocations->positionScale, bounds.extent);
+}
+
+void FPEngine::_sendWorldPositionDecode(const PositionBounds& bounds) const
+{
+    // the box's corner is moved in double, so the decoded positions come out small near the camera
+    _setSceneUniform(_pSceneShaderUniformLocations->positionOffset, Transform::rebase(bounds.origin, _renderOrigin));
+    _setSceneUniform(_pSceneShaderUniformLocations->positionScale, bounds.extent);
 }
 
 //*************************************************************************************
@@ -1163,10 +2261,9 @@ void FPEngine::_computeAndSendTransformationMatrices(CSCI441::ShaderProgram* sha
     // ensure our shader program is not null
     if (shaderProgram)
     {
-        // precompute the MVP matrix CPU side
+        // precompute the MVP and Normal matrices CPU side
         glm::mat4 mvpMatrix = projectionMatrix * viewMatrix * modelMatrix;
-        // precompute the Normal matrix CPU side
-        glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(modelMatrix)));
+        glm::mat3 normalMatrix = Transform::normalMatrix(modelMatrix);
 
         // send the matrices to the shader
         shaderProgram->setProgramUniform(mvpMtxLocation, mvpMatrix);
@@ -6,8 +6,33 @@
 #include <CSCI441/OpenGLEngine.hpp>
 #include <CSCI441/ShaderProgram.hpp>
 #include <CSCI441/ModelLoader.hpp>
+#include "Mesh.h"
+#include "VertexFormat.h"
 #include "SirByzler.h"
-
+#include "TrackGeometry.h"
+#include "Transform.h"
+#include "SceneRegistry.h"
+#include "Heightfield.h"
+#include "Terrain.h"
+#include "OcclusionCuller.h"
+#include "GeometryPool.h"
+#include "GLStateCache.h"
+#include "StaticBatch.h"
+#include "TrackBuilder.h"
+#include "InputRecorder.h"
+#include "TrackBVH.h"
+#include "TrackWatcher.h"
+#include "TrackZones.h"
+#include "DynamicResolution.h"
+#include "GlitchEffect.h"
+#include "FramePacer.h"
+#include "FrameCapture.h"
+#include "OfflineRender.h"
+#include "AllocationTracker.h"
+#include "FrameArena.h"
+#include "ObjectPool.h"
+
+#include <string>
 #include <vector>
 
 class FPEngine final : public CSCI441::OpenGLEngine {
@@ -37,9 +62,76 @@ public:
     /// \param currMousePosition the current cursor position
     void handleCursorPositionEvent(glm::vec2 currMousePosition);
 
+    /// \desc selects the control point file to load, CSV or binary .trk, call before initialize()
+    /// \param FILENAME track file, data/rollercoaster.csv by default
+    void setTrackFile(const char* FILENAME);
+
+    /// \desc logs every input event handled this session, call before initialize()
+    /// \param FILENAME input log to create
+    /// \returns false if the log could not be created
+    bool recordInput(const char* FILENAME);
+    /// \desc plays back a recorded input log in place of live input, call before initialize()
+    /// \param FILENAME input log to replay
+    /// \returns false if the log could not be read
+    bool replayInput(const char* FILENAME);
+    /// \desc writes the duration of every frame to a CSV file
+    /// \param FILENAME CSV file to create
+    /// \returns false if the file could not be created
+    bool logFrameTimes(const char* FILENAME);
+    /// \desc renders the scene at whatever resolution keeps its GPU time within a budget and
+    /// upscales it to the window, call before initialize()
+    /// \param milliseconds GPU frame time budget of the scene, 0 to always render at full resolution
+    void setFrameBudget(GLfloat milliseconds) { _frameBudget = milliseconds; }
+    /// \desc sets the resolution the glitch zone's post-process runs at, call before initialize()
+    /// \param scale fraction of the frame resolution per axis
+    void setGlitchScale(GLfloat scale) { _glitchScale = scale; }
+    /// \desc selects how buffer swaps wait for the display, call before initialize()
+    void setSwapMode(FramePacer::SwapMode mode) { _framePacer.setSwapMode(mode); }
+    /// \desc limits how many frames the driver may queue ahead of the display, call before initialize()
+    /// \param maxQueuedFrames frames allowed in flight, 1 for the lowest latency
+    void setMaxQueuedFrames(GLuint maxQueuedFrames) { _framePacer.setMaxQueuedFrames(maxQueuedFrames); }
+    /// \desc records every presented frame, call before initialize()
+    /// \param FILENAME a .y4m video, or a numbered PNG sequence such as frames/ride_%05u.png
+    void captureFrames(const char* FILENAME) { _captureFilename = FILENAME; }
+    /// \desc renders a share of an offline ride into a hidden window instead of running
+    /// interactively, call before initialize()
+    /// \param job frames to render and where to write them
+    void renderOffline(const OfflineRender::Job& job) { _offlineJob = job; _offline = true; }
+    /// \desc number of frames an offline render of one lap of a track draws, without creating
+    /// an engine
+    /// \param FILENAME track file, nullptr for the default track
+    /// \param framesPerSecond simulated frames per second
+    /// \returns 0 if the track could not be read
+    static GLuint getLapFrames(const char* FILENAME, GLuint framesPerSecond);
+    /// \desc true if the offline job ran and every one of its frames was written
+    [[nodiscard]] bool offlineRenderSucceeded() const { return _offlineSucceeded; }
+    /// \desc reports every frame that allocates from the heap once the engine has settled, and
+    /// the heap use of each subsystem on exit, call before initialize()
+    void checkAllocations(bool check) { _checkAllocations = check; }
+    /// \desc skips drawing what the terrain hides from the main view, on by default
+    void setOcclusionCulling(bool cull) { _occlusionCulling = cull; }
+    /// \desc submits static geometry with glMultiDrawElementsIndirect where the driver has it,
+    /// on by default.  Off always takes the GL 4.1 path, call before initialize()
+    void setMultiDrawIndirect(bool multiDrawIndirect) { _multiDrawIndirect = multiDrawIndirect; }
+    /// \desc builds the curve and monorail buffers with compute shaders where the driver has GL
+    /// 4.3, off by default.  Call before initialize()
+    void setGPUTrackBuilder(bool gpuTrackBuilder) { _gpuTrackBuilder = gpuTrackBuilder; }
+
     /// \desc value off-screen to represent mouse has not begun interacting with window yet
     static constexpr GLfloat MOUSE_UNINITIALIZED = -9999.0f;
 
+    /// \desc moves a single control point of the track.  Only the curves using the point are
+    /// marked dirty; their samples, tube rings and support beams are rebuilt and patched into
+    /// the existing GPU buffers on the next frame
+    /// \param index control point to move
+    /// \param position new world space position of the control point
+    void setControlPoint(GLuint index, glm::vec3 position);
+    /// \desc current position of a control point
+    /// \param index control point to query
+    [[nodiscard]] glm::vec3 getControlPoint(GLuint index) const;
+    /// \desc number of control points making up the track
+    [[nodiscard]] GLuint getNumControlPoints() const { return _bezierCurve.numControlPoints; }
+
 private:
     void mSetupGLFW() final;
     void mSetupOpenGL() final;
@@ -51,10 +143,155 @@ private:
     void mCleanupBuffers() final;
     void mCleanupShaders() final;
 
-    /// \desc draws everything to the scene from a particular point of view
-    /// \param viewMtx the current view matrix for our camera
-    /// \param projMtx the current projection matrix for our camera
-    void _renderScene(glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    /// \desc applies a key event, live or replayed
+    void _processKeyEvent(GLint key, GLint action);
+    /// \desc applies a mouse button event, live or replayed
+    void _processMouseButtonEvent(GLint button, GLint action);
+    /// \desc applies a cursor movement, live or replayed
+    void _processCursorPositionEvent(glm::vec2 currMousePosition);
+    /// \desc routes a replayed event to its handler
+    void _dispatchInputEvent(const InputRecorder::InputEvent& event);
+
+    /// \desc records or replays input and logs frame times
+    InputRecorder _inputRecorder;
+    /// \desc number of frames simulated so far, the timestamp of recorded input
+    GLuint _frameNumber;
+    /// \desc nominal seconds per frame, the step the ride is timed with
+    static constexpr GLfloat REPLAY_TIMESTEP = 1.0f / 60.0f;
+    /// \desc longest step the camera controls take, so a stall does not fling the camera
+    static constexpr GLfloat MAX_FRAME_STEP = 0.1f;
+    /// \desc duration of the last frame in seconds, what per frame camera motion is scaled by.
+    /// Read back from the log when replaying
+    GLfloat _frameStep;
+    /// \desc seconds since the ride started, the wall clock live, read back from the log when
+    /// replaying and fixed steps when rendering offline.  Drives the glitch animation
+    GLfloat _simulationTime;
+    /// \desc free cam speed in world units per second
+    static constexpr GLfloat FREE_CAM_SPEED = 30.0f;
+
+    /// \desc bounds the frames in flight, samples input late and measures input latency
+    FramePacer _framePacer;
+    /// \desc writes the timings of frames the GPU has finished to the frame time log
+    void _logFinishedFrames();
+
+    /// \desc transient data of the current frame, reset at the start of every frame.  View
+    /// passes and monorail chunk builds rewind it when they finish, so it only ever holds one
+    mutable FrameArena _frameArena;
+    /// \desc shadows the bound program, vertex array and textures and the scene programs'
+    /// uniforms, so passes can set what they need without repeating GL calls
+    mutable GLStateCache _glState;
+    /// \desc reports how many GL calls the state cache issued and elided per frame
+    void _reportGLState() const;
+    /// \desc sets a uniform of the active scene program through the state cache
+    template<typename T>
+    void _setSceneUniform(GLint location, const T& value) const {
+        _glState.setUniform(_pSceneShaderProgram->getShaderProgramHandle(), location, value);
+    }
+    /// \desc cameras, the cart model and the render subsystems, destroyed with the engine at
+    /// the latest
+    ObjectPool _objectPool;
+    /// \desc frames after startup or a track rebuild before a frame is expected not to allocate
+    static constexpr GLuint ALLOCATION_WARMUP_FRAMES = 8;
+    /// \desc if true, steady state frames that allocate are reported
+    bool _checkAllocations;
+    /// \desc first frame of the current steady state
+    GLuint _steadyStateFrame;
+    /// \desc steady state frames that allocated
+    GLuint _numAllocatingFrames;
+    /// \desc reports the frame if it allocated in steady state, call once it is presented
+    void _checkFrameAllocations();
+    /// \desc prints what each subsystem allocated over the whole run
+    void _reportAllocations() const;
+
+    /// \desc true when rendering an offline job rather than running interactively
+    bool _offline;
+    OfflineRender::Job _offlineJob;
+    bool _offlineSucceeded;
+    /// \desc renders every frame of the offline job to an offscreen target at the job's resolution
+    void _runOffline();
+    /// \desc lap duration in seconds, the live ride advances one curve sample per REPLAY_TIMESTEP
+    [[nodiscard]] double _lapSeconds() const { return _bezierCurve.curvePoints.size() * static_cast<double>(REPLAY_TIMESTEP); }
+    /// \desc frames in one lap of a track of a number of curves
+    static GLuint _lapFrames(GLuint numCurves, GLuint framesPerSecond);
+    /// \desc places the cart and cameras where the ride is at a simulation time, moving at
+    /// constant speed along the track by arc length, without stepping through earlier frames
+    /// \param seconds simulation time since the start of the ride
+    void _placeRideAt(double seconds);
+    /// \desc moves the cart, cart cameras and cart entities to a point on the track
+    /// \param position cart position
+    /// \param direction cart heading about the y axis
+    void _placeRide(glm::vec3 position, GLfloat direction);
+    /// \desc follows the cart through the track zones and applies the actions of the zones it is in
+    void _applyTrackZone();
+    /// \desc brings the hero plane to the pose it has after a number of steps through its zone.
+    /// The pose depends only on where the cart is, not on how many frames were drawn, so offline
+    /// workers starting anywhere agree with the live ride
+    /// \param steps curve samples the cart has travelled since entering the hero zone
+    void _flyHero(GLuint steps);
+    /// \desc steps the hero plane has flown since it was created
+    GLuint _heroSteps;
+    /// \desc tints the directional light of every scene program
+    /// \param lightColor color of the directional light
+    void _setLighting(glm::vec3 lightColor);
+    /// \desc draws every view in _views into the bound framebuffer
+    void _renderViews();
+
+    /// \desc file frames are captured to, empty when not capturing
+    std::string _captureFilename;
+    /// \desc reads back and writes out every presented frame while capturing, otherwise null
+    FrameCapture* _pFrameCapture;
+
+    /// \desc draws everything to the scene from a particular point of view.  In multi-view mode
+    /// the view is the identity and the geometry shader projects into every view instead
+    /// \param view cached matrices of the current view pass
+    /// \param occlusionCulled true to skip what _cullOccluded() found hidden, for the main view only
+    void _renderScene(const Transform::ViewTransform& view, bool occlusionCulled) const;
+    /// \desc draws what the multi-view geometry shader cannot replicate: line primitives, and
+    /// the hero plane, which SirByzler draws through the single view program
+    /// \param view cached matrices of the current view pass
+    void _renderViewPrimitives(const Transform::ViewTransform& view) const;
+    /// \desc sets the lighting and time uniforms of the active scene program
+    void _sendSceneUniforms() const;
+
+    //***************************************************************************
+    // Multi-view Rendering
+
+    /// \desc most views one multi-view pass can draw, must match MAX_VIEWS in shaders/fp-multiview*.g.glsl
+    static constexpr GLuint MAX_VIEWS = 4;
+    /// \desc one camera's view of the scene and the part of the framebuffer it covers
+    struct RenderView {
+        Transform::ViewTransform transform;
+        /// \desc x, y, width, height in framebuffer pixels
+        GLfloat viewport[4];
+    };
+    /// \desc views drawn this frame, later views are drawn over earlier ones
+    std::vector<RenderView> _views;
+    /// \desc fills _views with the current camera and, in first person, the map inset
+    /// \param renderWidth width of the target the scene is rendered into
+    /// \param renderHeight height of the target the scene is rendered into
+    /// \param renderScale ratio of the render target to the window, sizes the inset
+    void _collectViews(GLint renderWidth, GLint renderHeight, GLfloat renderScale);
+    /// \desc if true all views are drawn with one submission of the scene, otherwise the scene is
+    /// submitted once per view.  Toggled with V; more than MAX_VIEWS views always render per view
+    bool _multiView;
+    /// \desc draws every view in _views with one submission of the scene
+    void _renderMultiView();
+    /// \desc depth range of a view.  Views get disjoint slices with later views nearer, so an
+    /// inset covers the views under it without clearing depth in between
+    void _viewDepthRange(GLuint view, GLdouble& nearDepth, GLdouble& farDepth) const;
+
+    /// \desc GPU time budget of the scene in milliseconds, 0 disables dynamic resolution
+    GLfloat _frameBudget;
+    /// \desc offscreen target and upscaler used when a frame budget is set, otherwise null
+    DynamicResolution* _pDynamicResolution;
+
+    /// \desc true while the cart is in the glitch zone
+    bool _glitchActive;
+    /// \desc fraction of the frame resolution the glitch is computed at, per axis
+    GLfloat _glitchScale;
+    /// \desc post-process applied to finished frames in the glitch zone, null if it failed to build
+    GlitchEffect* _pGlitchEffect;
+
     /// \desc handles moving our FreeCam as determined by keyboard input
     void _updateScene();
 
@@ -104,7 +341,7 @@ private:
     /// \param [in] vao VAO descriptor to bind
     /// \param [in] vbo VBO descriptor to bind
     /// \param [out] numVAOPoints sets the number of vertices that make up the IBO array
-    void _createCage(GLuint vao, GLuint vbo, GLsizei &numVAOPoints) const;
+    void _createCage(GLuint vao, GLuint vbo, GLsizei &numVAOPoints);
 
     /// \desc creates the Bezier curve object
     /// \param [in] vao VAO descriptor to bind
@@ -112,9 +349,134 @@ private:
     /// \param [out] numVAOPoints sets the number of vertices that make up the IBO array
     void _createCurve(GLuint vao, GLuint vbo, GLsizei &numVAOPoints);
 
-    void _createMonorail(std::vector<glm::vec3> curvePoints, GLuint &vao, GLuint &vbo, GLuint ibo, float radius, int numSegments);
-    void renderMonorail(GLuint vao, size_t numIndices) const;
-    std::vector<GLuint>  _monorailIndices;
+    /// \desc number of segments each curve is sampled into
+    static constexpr GLuint CURVE_RESOLUTION = 100;
+    /// \desc number of samples each curve contributes to curvePoints
+    static constexpr GLuint SAMPLES_PER_CURVE = CURVE_RESOLUTION + 1;
+
+    /// \desc sweeps the monorail tube along the curve samples and uploads it into the given buffers
+    /// \param [in] vao VAO descriptor to bind
+    /// \param [in] vbo VBO descriptor to fill with packed vertices
+    /// \param [in] ibo IBO descriptor to fill with the shared chunk index pattern
+    void _createMonorail(GLuint vao, GLuint vbo, GLuint ibo);
+    /// \desc sweeps and packs the rings of one monorail chunk, updating the chunk's bounds
+    /// \param [in] chunkIndex chunk to build
+    /// \param [out] vertices packed vertices of the chunk
+    void _buildMonorailChunk(GLuint chunkIndex, std::vector<PackedVertex>& vertices);
+    /// \desc places one monorail chunk in the VBO and sizes its bounds from the curve samples,
+    /// for the GPU track builder to sweep
+    /// \param [in] chunkIndex chunk to lay out
+    /// \returns number of vertices in the chunk
+    GLuint _layoutMonorailChunk(GLuint chunkIndex);
+
+    /// \desc if true the curve and monorail are built with compute shaders where available
+    bool _gpuTrackBuilder;
+    /// \desc compute programs writing the curve and monorail buffers, null when the CPU builds them
+    TrackBuilder* _pTrackBuilder;
+    void renderMonorail(GLuint vao) const;
+
+    /// \desc creates the patch index buffer the tessellated monorail draws from
+    /// \param [in] vao VAO descriptor to bind
+    /// \param [in] cageVBO VBO holding the control points
+    /// \param [in] knotNormalVBO VBO holding the knot normals, one per control point
+    /// \param [in] ibo IBO descriptor to fill with patch indices
+    /// \param [out] numVAOPoints sets the number of indices in the IBO
+    void _createMonorailPatches(GLuint vao, GLuint cageVBO, GLuint knotNormalVBO, GLuint ibo, GLsizei &numVAOPoints) const;
+    /// \desc draws the monorail by tessellating the control point patches on the GPU
+    /// \param view cached matrices of the current view pass
+    void _renderTessellatedMonorail(const Transform::ViewTransform& view) const;
+
+    /// \desc radius of the monorail tube
+    static constexpr GLfloat MONORAIL_RADIUS = 0.2f;
+    /// \desc vertices around the monorail tube at full detail
+    static constexpr GLint MONORAIL_SEGMENTS = 16;
+    /// \desc tessellated rings per world unit near the camera
+    static constexpr GLfloat MONORAIL_RING_DENSITY = 4.0f;
+    /// \desc distance from the camera where tessellated detail starts to fall off
+    static constexpr GLfloat MONORAIL_LOD_DISTANCE = 8.0f;
+    /// \desc if true the monorail is tessellated on the GPU, otherwise the CPU swept mesh is drawn
+    bool _tessellatedMonorail;
+
+    /// \desc number of tube rings quantized against one set of chunk bounds
+    static constexpr GLuint MONORAIL_CHUNK_RINGS = 64;
+    /// \desc a run of monorail rings sharing one position decode box.  Every chunk uses the
+    /// same local 16-bit index pattern, offset into the VBO by its base vertex
+    struct MonorailChunk {
+        /// \desc decode box for this chunk's packed positions
+        PositionBounds bounds;
+        /// \desc index of the chunk's first vertex in the monorail VBO
+        GLint baseVertex;
+        /// \desc number of indices to draw from the shared pattern
+        GLsizei numIndices;
+    };
+    /// \desc chunks making up the monorail, in track order
+    std::vector<MonorailChunk> _monorailChunks;
+
+    /// \desc number of curve samples between support beams
+    static constexpr GLuint BEAM_SPACING = 50;
+    /// \desc places support beam i under curve sample i * BEAM_SPACING
+    void _placeBeam(GLuint beam);
+
+    /// \desc per curve flag set when one of its control points moved
+    std::vector<bool> _dirtyCurves;
+    /// \desc range of control points [begin, end) changed since the last upload
+    GLuint _dirtyControlPointBegin;
+    GLuint _dirtyControlPointEnd;
+    /// \desc regenerates dirty curves and patches only the affected parts of the GPU buffers
+    void _applyTrackEdits();
+
+    /// \desc cumulative distance along the curve samples, _arcLengths[i] is the length from
+    /// the first sample to sample i
+    std::vector<GLfloat> _arcLengths;
+    /// \desc ring frame normal where each curve starts and where the last one ends, one entry
+    /// per control point with the handles' entries unused, see TrackGeometry::computeKnotNormals
+    std::vector<glm::vec3> _knotNormals;
+    /// \desc recomputes the cumulative arc lengths from a sample to the end of the track
+    /// \param firstSample first sample whose position may have changed
+    void _computeArcLengths(GLuint firstSample);
+    /// \desc finds the curve sample closest to a distance along the track
+    /// \param arcLength distance from the first sample
+    [[nodiscard]] GLuint _sampleAtArcLength(GLfloat arcLength) const;
+
+    /// \desc stretches of track that glitch the frame, fly the hero, tint the light or switch
+    /// cameras, loaded from a .zones file next to the track file
+    TrackZones _trackZones;
+    /// \desc set when the cart jumps rather than rides to a new sample, the zones are then
+    /// re-evaluated at the new position instead of followed along the track
+    bool _cartJumped;
+    /// \desc light color outside any lighting zone
+    glm::vec3 _defaultLightColor;
+    /// \desc camera the rider chose before a camera zone took over, -1 while no zone has
+    int _riderCameraIndex;
+
+    /// \desc radius of the spheres drawn at, and picked around, each control point
+    static constexpr GLfloat CONTROL_POINT_RADIUS = 0.25f;
+    /// \desc spatial index over the curve sample segments, swept by the monorail radius
+    TrackBVH _trackBVH;
+    /// \desc spatial index over the control point spheres
+    TrackBVH _controlPointBVH;
+    /// \desc control point being dragged with the mouse, -1 if none
+    GLint _selectedControlPoint;
+    /// \desc point and normal of the camera facing plane the selected control point moves in
+    glm::vec3 _dragPlanePoint;
+    glm::vec3 _dragPlaneNormal;
+    /// \desc computes the world space ray under a cursor position for the current camera
+    /// \param mousePosition cursor position in window coordinates
+    /// \param [out] origin ray origin on the near plane
+    /// \param [out] direction normalized ray direction
+    void _computeMouseRay(glm::vec2 mousePosition, glm::vec3& origin, glm::vec3& direction) const;
+
+    /// \desc control point file loaded at startup and watched for changes
+    std::string _trackFilename;
+    /// \desc watches the track file and parses it on a background thread when it changes
+    TrackWatcher* _pTrackWatcher;
+    /// \desc reused receive buffer for control points handed over by the watcher
+    std::vector<glm::vec3> _reloadedControlPoints;
+    /// \desc applies a re-parsed track file.  Moved control points go through
+    /// setControlPoint so only the affected curves are rebuilt; a different number of points
+    /// rebuilds the whole track.  The cart keeps its fraction of the total track length
+    /// \param controlPoints control points read from the track file
+    void _reloadTrack(const std::vector<glm::vec3>& controlPoints);
     /// \desc This function loads the Bezier control points from a given file.  Upon
     /// completion, the parameters will store the number of points read in, the
     /// number of curves they represent, and the array of actual points.
@@ -124,28 +486,58 @@ private:
     /// \param [out] bezierPoints the points array read in
     static void _loadControlPoints(const char* FILENAME, GLuint *numBezierPoints, GLuint *numBezierCurves, glm::vec3* &bezierPoints);
 
-    /// \desc This function solves the Bezier curve equation for four given control
-    /// points at a given location t.
-    /// \param p0 first control point
-    /// \param p1 second control point
-    /// \param p2 third control point
-    /// \param p3 fourth control point
-    /// \param t parameter to evaluate control points
-    /// \returns interpolated point
-   glm::vec3 _evalBezierCurve(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, GLfloat t) const;
-
-    /// \desc the size of the world (controls the ground size and locations of buildings)
+    /// \desc the smallest park around the track, the ground stays low within it
     static constexpr GLfloat WORLD_SIZE = 55.0f;
-    /// \desc VAO for our ground
-    GLuint _groundVAO;
-    /// \desc the number of points that make up our ground object
-    GLsizei _numGroundPoints;
-
-
-    /// \desc creates the ground VAO
-    void _createGroundBuffers();
-
-    void _createSkyBox();
+    /// \desc room between the track and the edge of the park, where the hills start to rise
+    static constexpr GLfloat PARK_MARGIN = 10.0f;
+    /// \desc sizes the park so the ground stays low under the whole track
+    /// \returns true if the park changed size
+    bool _fitParkToTrack();
+    /// \desc creates the terrain drawing _heightfield, replacing any it had before
+    void _createTerrain();
+    /// \desc height of the ground everywhere, which the terrain draws and the beams stand on
+    Heightfield _heightfield;
+    /// \desc streamed level of detail chunks of _heightfield
+    Terrain* _pTerrain;
+    /// \desc draws the terrain chunks picked for this frame
+    /// \param occlusionCulled true to skip the chunks _cullOccluded() found hidden
+    void _renderTerrain(bool occlusionCulled) const;
+
+    /// \desc software depth pyramid of the terrain as seen from the main view
+    OcclusionCuller _occlusionCuller;
+    bool _occlusionCulling;
+    /// \desc entities hidden this many frames in a row are culled.  Waiting a frame before
+    /// culling keeps a misjudged silhouette from making an object flicker
+    static constexpr GLubyte OCCLUSION_HYSTERESIS = 2;
+    /// \desc consecutive frames each entity has been found hidden from the main view
+    std::vector<GLubyte> _entityOccludedFrames;
+    /// \desc whether each of the terrain's visible chunks is drawn in the main view
+    std::vector<GLubyte> _chunkDrawn;
+    /// \desc rasterizes the terrain for the main view and tests the chunks, beams, control points
+    /// and cart against it, call once the views are collected
+    void _cullOccluded();
+    /// \desc tests every entity of a range against the occlusion pyramid
+    /// \param localMin minimum corner of the entities' bounding box before their model matrix
+    /// \param localMax maximum corner of the entities' bounding box before their model matrix
+    void _cullEntities(SceneRegistry::Range range, glm::vec3 localMin, glm::vec3 localMax);
+    /// \desc true unless the entity has been hidden long enough to be culled
+    [[nodiscard]] bool _isEntityDrawn(SceneRegistry::Entity entity, bool occlusionCulled) const;
+
+    /// \desc shared buffers the beams and control point spheres are packed into
+    GeometryPool* _pGeometryPool;
+    /// \desc starting size of the pool, enough for a few hundred control points and beams
+    static constexpr GLuint STATIC_GEOMETRY_VERTICES = 65536;
+    static constexpr GLuint STATIC_GEOMETRY_INDICES = 4096;
+    bool _multiDrawIndirect;
+    /// \desc one copy of the beam cube per beam entity, one sphere per control point entity
+    StaticBatch* _pBeamBatch;
+    StaticBatch* _pControlPointBatch;
+    /// \desc rewrites the batch copies of entities that moved, call after the scene is updated
+    void _updateStaticGeometry();
+    /// \desc draws the copies of a batch whose entities are not culled as one multi-draw
+    /// \param range entities the batch's copies follow, copy i follows entity range.first + i
+    void _renderStaticBatch(StaticBatch* pBatch, SceneRegistry::Range range,
+                            const Transform::ViewTransform& view, bool occlusionCulled) const;
 
     /// \desc smart container to store information specific to each building we wish to draw
     struct BuildingData {
@@ -160,7 +552,8 @@ private:
         glm::vec3 color;
     };
 
-    CSCI441::ModelLoader* _pCartModel;
+    /// \desc cart model, imported once and then loaded from its binary mesh cache
+    Mesh* _pCartModel;
     glm::vec3 cartPos;
     float cartDirection;
 
@@ -171,13 +564,44 @@ private:
     void _generateEnvironment();
 
 
-    /// \desc precomputes the matrix uniforms CPU-side and then sends them
-    /// to the GPU to be used in the shader for each vertex.  It is more efficient
-    /// to calculate these once and then use the resultant product in the shader.
-    /// \param modelMtx model transformation matrix
-    /// \param viewMtx camera view matrix
-    /// \param projMtx camera projection matrix
-    void _computeAndSendMatrixUniforms(glm::mat4 modelMtx, glm::mat4 viewMtx, glm::mat4 projMtx) const;
+    /// \desc sends already computed matrix uniforms to the active shader
+    void _sendMatrixUniforms(const glm::mat4& mvpMtx, const glm::mat4& modelViewMtx, const glm::mat3& normalMtx) const;
+
+    /// \desc transforms of every object drawn in the scene
+    SceneRegistry _scene;
+    /// \desc entities that exist for the whole run, created in mSetupBuffers()
+    SceneRegistry::Entity _skyboxEntity;
+    SceneRegistry::Entity _cartEntity;
+    SceneRegistry::Entity _heroEntity;
+    /// \desc the three entities above, which are contiguous
+    SceneRegistry::Range _propEntities;
+    /// \desc one sphere per control point, entity first + i sits on control point i
+    SceneRegistry::Range _controlPointEntities;
+    /// \desc one support beam per BEAM_SPACING curve samples
+    SceneRegistry::Range _beamEntities;
+    /// \desc (re)creates the control point and beam entities for the current track
+    void _createTrackEntities();
+
+    /// \desc view dependent matrices of the entities of the last _computeEntityUniforms() call,
+    /// in the frame arena
+    mutable glm::mat4* _entityMVPMatrices;
+    mutable glm::mat4* _entityModelViewMatrices;
+    /// \desc entity the matrices above start at
+    mutable SceneRegistry::Entity _entityUniformsFirst;
+    /// \desc computes the view dependent matrices of a group of entities as one batch
+    void _computeEntityUniforms(const Transform::ViewTransform& view, SceneRegistry::Range range) const;
+    /// \desc sends the matrices of an entity computed by _computeEntityUniforms()
+    void _sendEntityUniforms(SceneRegistry::Entity entity) const;
+
+    /// \desc sends the decode box for quantized vertex positions to the active shader
+    /// \param bounds box to decode against, VertexFormat::IDENTITY_BOUNDS for float positions
+    void _sendPositionDecode(const PositionBounds& bounds) const;
+    /// \desc sends the decode box for quantized world space positions, moved to the origin of
+    /// the view pass being drawn
+    /// \param bounds box to decode against, VertexFormat::IDENTITY_BOUNDS for float positions
+    void _sendWorldPositionDecode(const PositionBounds& bounds) const;
+    /// \desc world position the current view pass is drawn relative to
+    mutable glm::dvec3 _renderOrigin;
 
 
 
@@ -227,8 +651,14 @@ private:
         GLint spotlightColor;
         GLint spotlightCutOff;
         GLint spotlightOuterCutOff;
-        GLfloat time;
         GLfloat useLight;
+        // quantized position decode
+        GLint positionOffset;
+        GLint positionScale;
+        // per view arrays of the multi-view programs, -1 in single view programs
+        GLint viewProjMatrices;
+        GLint cameraPositions;
+        GLint numViews;
     };
 
     struct shaderAttributeLocations {
@@ -241,29 +671,53 @@ private:
     shaderUniformLocations _regularShaderUniformLocations;
     shaderAttributeLocations _regularShaderAttributeLocations;
 
-    CSCI441::ShaderProgram* _glitchedShaderProgram;
-    shaderUniformLocations _glitchedShaderUniformLocations;
-    shaderAttributeLocations _glitchedShaderAttributeLocations;
-
-    int shaderIndex;
-
-    CSCI441::ShaderProgram* _shaderPrograms[2] = {
-        _regularShaderProgram,
-        _glitchedShaderProgram
-    };
-
-    shaderAttributeLocations* _shaderAttributeLocations[2] = {
-        &_regularShaderAttributeLocations,
-        &_glitchedShaderAttributeLocations
-    };
-
-    shaderUniformLocations* _shaderUniformLocations[2] = {
-        &_regularShaderUniformLocations,
-        &_glitchedShaderUniformLocations
-    };
-
-
-    static constexpr GLuint NUM_VAOS = 4;
+    /// \desc shader program that extrudes the monorail in the tessellation stages
+    CSCI441::ShaderProgram* _monorailShaderProgram;
+    shaderUniformLocations _monorailShaderUniformLocations;
+    /// \desc locations of the tessellation specific uniforms
+    struct monorailTessUniformLocations {
+        GLint tubeRadius;
+        GLint tubeSegments;
+        GLint ringDensity;
+        GLint lodDistance;
+    } _monorailTessUniformLocations;
+
+    /// \desc multi-view versions of the programs above: the same stages plus a geometry shader
+    /// that replicates each triangle into every view
+    CSCI441::ShaderProgram* _regularMultiViewShaderProgram;
+    shaderUniformLocations _regularMultiViewShaderUniformLocations;
+    shaderAttributeLocations _regularMultiViewShaderAttributeLocations;
+
+    CSCI441::ShaderProgram* _monorailMultiViewShaderProgram;
+    shaderUniformLocations _monorailMultiViewShaderUniformLocations;
+    monorailTessUniformLocations _monorailMultiViewTessUniformLocations;
+
+    /// \desc scene program in use, single view or multi-view.  The glitch is a post-process
+    /// over the finished frame, so every scene pass draws with this one
+    CSCI441::ShaderProgram* _pSceneShaderProgram;
+    shaderUniformLocations* _pSceneShaderUniformLocations;
+    shaderAttributeLocations* _pSceneShaderAttributeLocations;
+
+    /// \desc monorail program in use, single view or multi-view
+    CSCI441::ShaderProgram* _pMonorailShaderProgram;
+    shaderUniformLocations* _pMonorailShaderUniformLocations;
+
+    /// \desc loads a scene program and queries its uniform and attribute locations
+    /// \param geometryShaderFilename geometry stage, or nullptr for none
+    static CSCI441::ShaderProgram* _createSceneShaderProgram(const char* vertexShaderFilename, const char* geometryShaderFilename,
+                                                             const char* fragmentShaderFilename,
+                                                             shaderUniformLocations& uniformLocations,
+                                                             shaderAttributeLocations& attributeLocations);
+    /// \desc loads a tessellated monorail program and sets its static uniforms
+    /// \param geometryShaderFilename geometry stage, or nullptr for none
+    static CSCI441::ShaderProgram* _createMonorailShaderProgram(const char* geometryShaderFilename,
+                                                                shaderUniformLocations& uniformLocations,
+                                                                monorailTessUniformLocations& tessLocations);
+    /// \desc points the scene and monorail programs in use at the single view or multi-view programs
+    void _selectShaderPrograms(bool multiView);
+
+
+    static constexpr GLuint NUM_VAOS = 5;
     /// \desc used to index through our VAO/VBO/IBO array to give named access
     enum VAO_ID {
         /// \desc the platform that represents our ground for everything to appear on
@@ -273,7 +727,10 @@ private:
         /// \desc the actual bezier curve itself
         BEZIER_CURVE = 2,
 
-        MONO_RAIL = 3
+        MONO_RAIL = 3,
+        /// \desc control points indexed as one tessellation patch per curve, sharing the cage VBO.
+        /// its own VBO holds the knot normals, read by the patches and the GPU track builder
+        MONO_RAIL_PATCHES = 4
     };
     /// \desc VAO for our objects
     GLuint _vaos[NUM_VAOS];
@@ -0,0 +1,51 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdio>
+
+FrameArena::FrameArena()
+    : _capacity(0),
+      _used(0),
+      _highWater(0),
+      _overflowBytes(0)
+{
+}
+
+void FrameArena::reserve(const size_t bytes)
+{
+    _overflowBlocks.clear();
+    _overflowBytes = 0;
+    _used = 0;
+    if (bytes != _capacity) {
+        _block.reset(bytes > 0 ? new unsigned char[bytes] : nullptr);
+        _capacity = bytes;
+    }
+}
+
+void FrameArena::reset()
+{
+    if (_overflowBytes > 0) {
+        // new[] aligns the block for any fundamental type, so the padding counted in _used is all it needs
+        fprintf(stdout, "[INFO]: frame arena grown from %zu to %zu bytes\n", _capacity, _highWater);
+        reserve(_highWater);
+        return;
+    }
+    _used = 0;
+}
+
+void* FrameArena::_allocate(const size_t bytes, const size_t alignment)
+{
+    const size_t offset = (_used + alignment - 1) & ~(alignment - 1);
+    if (_block && offset + bytes <= _capacity) {
+        _used = offset + bytes;
+        _highWater = std::max(_highWater, getUsed());
+        return _block.get() + offset;
+    }
+
+    // out of room: this frame gets a block of its own, reset() folds it into the main block
+    _overflowBlocks.emplace_back(new unsigned char[bytes + alignment]);
+    _overflowBytes += bytes + alignment;
+    _highWater = std::max(_highWater, getUsed());
+    const size_t address = reinterpret_cast<size_t>(_overflowBlocks.back().get());
+    return reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+}
@@ -0,0 +1,65 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// \class FrameArena
+/// \desc Linear allocator for data that lives for one frame.  Allocating bumps an offset into
+/// one block reserved up front, and reset() at the start of the next frame releases everything
+/// at once.  A frame that outgrows the block still gets its memory, from extra heap blocks,
+/// and the next reset() grows the block to the frame's high water mark so the steady state
+/// goes back to never touching the heap.  Only trivially destructible types may be allocated,
+/// nothing is destroyed on reset
+class FrameArena {
+public:
+    /// \desc creates an arena, call reserve() before the first frame
+    FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /// \desc sizes the block, releasing anything allocated
+    /// \param bytes capacity of the block
+    void reserve(size_t bytes);
+    /// \desc releases everything allocated this frame, growing the block first if the frame overflowed it
+    void reset();
+
+    /// \desc allocates uninitialized storage for an array, valid until the next reset()
+    /// \param count number of elements
+    template<typename T>
+    T* allocate(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "the arena never runs destructors");
+        return static_cast<T*>(_allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /// \desc position in the block, everything allocated after it can be released early
+    typedef size_t Marker;
+    [[nodiscard]] Marker getMarker() const { return _used; }
+    /// \desc releases everything allocated from the block since getMarker(), so passes that
+    /// run many times a frame can reuse the same memory.  Overflow blocks are kept until reset()
+    void rewind(Marker marker) { _used = marker; }
+
+    /// \desc bytes allocated this frame
+    [[nodiscard]] size_t getUsed() const { return _used + _overflowBytes; }
+    /// \desc capacity of the block
+    [[nodiscard]] size_t getCapacity() const { return _capacity; }
+    /// \desc most bytes any frame has allocated
+    [[nodiscard]] size_t getHighWater() const { return _highWater; }
+
+private:
+    void* _allocate(size_t bytes, size_t alignment);
+
+    std::unique_ptr<unsigned char[]> _block;
+    size_t _capacity;
+    /// \desc bytes of the block handed out this frame
+    size_t _used;
+    size_t _highWater;
+    /// \desc heap blocks of a frame that did not fit, freed on reset
+    std::vector<std::unique_ptr<unsigned char[]>> _overflowBlocks;
+    size_t _overflowBytes;
+};
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,357 @@
+#include "FrameCapture.h"
+
+#include "AllocationTracker.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    /// \desc true if the name ends with the given extension
+    bool hasExtension(const std::string& filename, const char* extension) {
+        const size_t length = strlen(extension);
+        return filename.size() > length && filename.compare(filename.size() - length, length, extension) == 0;
+    }
+
+    /// \desc true if the name holds exactly one frame number conversion, %u or %d with an
+    /// optional zero padded width, so it is safe to hand to snprintf
+    bool isFramePattern(const std::string& filename) {
+        GLuint numConversions = 0;
+        for (size_t i = 0; i < filename.size(); i++) {
+            if (filename[i] != '%') continue;
+            size_t end = i + 1;
+            while (end < filename.size() && filename[end] >= '0' && filename[end] <= '9') end++;
+            if (end == filename.size() || (filename[end] != 'u' && filename[end] != 'd')) return false;
+            numConversions++;
+            i = end;
+        }
+        return numConversions == 1;
+    }
+
+    /// \desc CRC-32 as used by PNG chunks
+    GLuint crc32(GLuint crc, const GLubyte* data, const size_t length) {
+        static GLuint table[256] = {0};
+        if (table[1] == 0) {
+            for (GLuint n = 0; n < 256; n++) {
+                GLuint c = n;
+                for (int k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                table[n] = c;
+            }
+        }
+        crc = ~crc;
+        for (size_t i = 0; i < length; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void putBigEndian(std::vector<GLubyte>& out, const GLuint value) {
+        out.push_back(value >> 24);
+        out.push_back(value >> 16);
+        out.push_back(value >> 8);
+        out.push_back(value);
+    }
+
+    /// \desc writes one PNG chunk, length, type, data and CRC
+    bool writeChunk(FILE* file, const char type[4], const GLubyte* data, const GLuint length) {
+        GLubyte header[8] = {
+            static_cast<GLubyte>(length >> 24), static_cast<GLubyte>(length >> 16),
+            static_cast<GLubyte>(length >> 8), static_cast<GLubyte>(length),
+            static_cast<GLubyte>(type[0]), static_cast<GLubyte>(type[1]),
+            static_cast<GLubyte>(type[2]), static_cast<GLubyte>(type[3])
+        };
+        const GLuint crc = crc32(crc32(0, header + 4, 4), data, length);
+        const GLubyte footer[4] = {
+            static_cast<GLubyte>(crc >> 24), static_cast<GLubyte>(crc >> 16),
+            static_cast<GLubyte>(crc >> 8), static_cast<GLubyte>(crc)
+        };
+        return fwrite(header, 1, 8, file) == 8
+               && (length == 0 || fwrite(data, 1, length, file) == length)
+               && fwrite(footer, 1, 4, file) == 4;
+    }
+}
+
+FrameCapture::FrameCapture(const char* FILENAME, const GLuint framesPerSecond)
+    : _filename(FILENAME),
+      _format(Format::Y4M),
+      _framesPerSecond(framesPerSecond),
+      _pVideoFile(nullptr),
+      _width(0),
+      _height(0),
+      _numCaptured(0),
+      _numSkipped(0),
+      _firstFrame(0),
+      _frameStride(1),
+      _nextPBO(0),
+      _finishing(false),
+      _numFailed(0)
+{
+    for (GLuint i = 0; i < NUM_PBOS; i++) {
+        _pbos[i] = 0;
+        _fences[i] = nullptr;
+        _pboFrames[i] = 0;
+    }
+}
+
+FrameCapture::~FrameCapture()
+{
+    finish();
+}
+
+bool FrameCapture::start()
+{
+    if (hasExtension(_filename, ".y4m")) {
+        _format = Format::Y4M;
+        _pVideoFile = fopen(_filename.c_str(), "wb");
+        if (!_pVideoFile) {
+            fprintf(stderr, "[ERROR]: Could not create capture video \"%s\"\n", _filename.c_str());
+            return false;
+        }
+    } else if (hasExtension(_filename, ".png") && isFramePattern(_filename)) {
+        _format = Format::PNG;
+    } else {
+        fprintf(stderr, "[ERROR]: Capture \"%s\" must be a .y4m video or a .png name with one %%u frame number\n", _filename.c_str());
+        return false;
+    }
+
+    glGenBuffers(NUM_PBOS, _pbos);
+    _pendingFrames.reserve(MAX_PENDING_FRAMES);
+    _thread = std::thread(&FrameCapture::_write, this);
+    fprintf(stdout, "[INFO]: capturing frames to \"%s\"\n", _filename.c_str());
+    return true;
+}
+
+void FrameCapture::captureFrame(const GLint width, const GLint height)
+{
+    if (!_thread.joinable() || width <= 0 || height <= 0) return;
+
+    const GLsizeiptr frameSize = static_cast<GLsizeiptr>(width) * height * 4;
+    if (_width == 0) {
+        _width = width;
+        _height = height;
+        for (const GLuint pbo : _pbos) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (_pVideoFile) {
+            fprintf(_pVideoFile, "YUV4MPEG2 W%d H%d F%u:1 Ip A1:1 C420jpeg XYSCSS=420JPEG\n", _width, _height, _framesPerSecond);
+        }
+    }
+    if (width != _width || height != _height) {
+        _numSkipped++;
+        return;
+    }
+
+    // the buffer about to be reused holds the oldest read back, long since finished
+    const GLuint slot = _nextPBO;
+    if (_fences[slot]) _readBack(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[slot]);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    _fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _pboFrames[slot] = _firstFrame + _numCaptured++ * _frameStride;
+    _nextPBO = (slot + 1) % NUM_PBOS;
+}
+
+void FrameCapture::finish()
+{
+    if (!_thread.joinable()) return;
+
+    for (GLuint n = 0; n < NUM_PBOS; n++) {
+        const GLuint slot = (_nextPBO + n) % NUM_PBOS;
+        if (_fences[slot]) _readBack(slot);
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _finishing = true;
+    }
+    _frameQueued.notify_one();
+    _thread.join();
+
+    glDeleteBuffers(NUM_PBOS, _pbos);
+    if (_pVideoFile) fclose(_pVideoFile);
+    _pVideoFile = nullptr;
+
+    fprintf(stdout, "[INFO]: captured %u frames to \"%s\"\n", _numCaptured - _numFailed, _filename.c_str());
+    if (_numFailed > 0) {
+        fprintf(stderr, "[ERROR]: %u captured frames could not be written\n", _numFailed);
+    }
+    if (_numSkipped > 0) {
+        fprintf(stderr, "[ERROR]: %u frames were skipped because the window no longer matched the %dx%d capture\n",
+                _numSkipped, _width, _height);
+    }
+}
+
+void FrameCapture::_readBack(const GLuint slot)
+{
+    // NUM_PBOS frames have been drawn since this read back was issued, so this rarely waits
+    GLenum status;
+    do {
+        status = glClientWaitSync(_fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+    } while (status == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(_fences[slot]);
+    _fences[slot] = nullptr;
+
+    // hold back if the writer is too far behind, rather than let the queue grow without bound
+    Frame frame;
+    frame.index = _pboFrames[slot];
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _frameWritten.wait(lock, [this] { return _pendingFrames.size() < MAX_PENDING_FRAMES; });
+        if (!_freeBuffers.empty()) {
+            frame.pixels.swap(_freeBuffers.back());
+            _freeBuffers.pop_back();
+        }
+    }
+
+    const size_t frameSize = static_cast<size_t>(_width) * _height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, _pbos[slot]);
+    const auto* pixels = static_cast<const GLubyte*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT));
+    if (pixels) {
+        frame.pixels.assign(pixels, pixels + frameSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!pixels) {
+        fprintf(stderr, "[ERROR]: Could not map captured frame %u\n", frame.index);
+        _numFailed++;
+        _freeBuffers.push_back(std::move(frame.pixels));
+        return;
+    }
+    _pendingFrames.push_back(std::move(frame));
+    _frameQueued.notify_one();
+}
+
+void FrameCapture::_write()
+{
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::CAPTURE);
+    while (true) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _frameQueued.wait(lock, [this] { return !_pendingFrames.empty() || _finishing; });
+            if (_pendingFrames.empty()) return;
+            frame = std::move(_pendingFrames.front());
+            _pendingFrames.erase(_pendingFrames.begin());
+        }
+
+        const bool written = _format == Format::Y4M ? _writeY4M(frame) : _writePNG(frame);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!written) _numFailed++;
+            _freeBuffers.push_back(std::move(frame.pixels));
+        }
+        _frameWritten.notify_one();
+    }
+}
+
+bool FrameCapture::_writeY4M(const Frame& frame)
+{
+    const GLint chromaWidth = (_width + 1) / 2;
+    const GLint chromaHeight = (_height + 1) / 2;
+    const size_t lumaSize = static_cast<size_t>(_width) * _height;
+    const size_t chromaSize = static_cast<size_t>(chromaWidth) * chromaHeight;
+    _encoded.resize(lumaSize + 2 * chromaSize);
+    GLubyte* planeY = _encoded.data();
+    GLubyte* planeU = planeY + lumaSize;
+    GLubyte* planeV = planeU + chromaSize;
+
+    // GL rows run bottom to top, video rows top to bottom
+    const auto source = [&](GLint x, GLint y) {
+        return frame.pixels.data() + (static_cast<size_t>(_height - 1 - y) * _width + x) * 4;
+    };
+    for (GLint y = 0; y < _height; y++) {
+        for (GLint x = 0; x < _width; x++) {
+            const GLubyte* rgb = source(x, y);
+            planeY[static_cast<size_t>(y) * _width + x] = ((66 * rgb[0] + 129 * rgb[1] + 25 * rgb[2] + 128) >> 8) + 16;
+        }
+    }
+    // chroma is the average of each 2x2 block, clamped at odd edges
+    for (GLint cy = 0; cy < chromaHeight; cy++) {
+        for (GLint cx = 0; cx < chromaWidth; cx++) {
+            GLint r = 0, g = 0, b = 0;
+            for (GLint dy = 0; dy < 2; dy++) {
+                for (GLint dx = 0; dx < 2; dx++) {
+                    const GLubyte* rgb = source(std::min(2 * cx + dx, _width - 1), std::min(2 * cy + dy, _height - 1));
+                    r += rgb[0];
+                    g += rgb[1];
+                    b += rgb[2];
+                }
+            }
+            const size_t index = static_cast<size_t>(cy) * chromaWidth + cx;
+            planeU[index] = ((-38 * r - 74 * g + 112 * b + 512) >> 10) + 128;
+            planeV[index] = ((112 * r - 94 * g - 18 * b + 512) >> 10) + 128;
+        }
+    }
+
+    return fputs("FRAME\n", _pVideoFile) >= 0
+           && fwrite(_encoded.data(), 1, _encoded.size(), _pVideoFile) == _encoded.size();
+}
+
+bool FrameCapture::_writePNG(const Frame& frame)
+{
+    char filename[1024];
+    snprintf(filename, sizeof(filename), _filename.c_str(), frame.index);
+    FILE* file = fopen(filename, "wb");
+    if (!file) {
+        fprintf(stderr, "[ERROR]: Could not create capture image \"%s\"\n", filename);
+        return false;
+    }
+
+    // scanlines of RGB, each behind a filter byte of 0, top row first
+    const size_t rowSize = 1 + static_cast<size_t>(_width) * 3;
+    _scanlines.resize(rowSize * _height);
+    for (GLint y = 0; y < _height; y++) {
+        GLubyte* out = _scanlines.data() + y * rowSize;
+        const GLubyte* row = frame.pixels.data() + static_cast<size_t>(_height - 1 - y) * _width * 4;
+        *out++ = 0;
+        for (GLint x = 0; x < _width; x++, out += 3) {
+            out[0] = row[4 * x];
+            out[1] = row[4 * x + 1];
+            out[2] = row[4 * x + 2];
+        }
+    }
+
+    // zlib stream of stored deflate blocks: 2 byte header, 5 bytes per block, 4 byte checksum
+    constexpr size_t MAX_BLOCK = 65535;
+    const size_t imageSize = _scanlines.size();
+    _encoded.clear();
+    _encoded.reserve(2 + (imageSize / MAX_BLOCK + 1) * 5 + imageSize + 4);
+    _encoded.push_back(0x78);
+    _encoded.push_back(0x01);
+    for (size_t offset = 0; offset < imageSize; offset += MAX_BLOCK) {
+        const size_t length = std::min(imageSize - offset, MAX_BLOCK);
+        _encoded.push_back(offset + length == imageSize ? 1 : 0);
+        _encoded.push_back(length & 0xFF);
+        _encoded.push_back(length >> 8);
+        _encoded.push_back(~length & 0xFF);
+        _encoded.push_back((~length >> 8) & 0xFF);
+        _encoded.insert(_encoded.end(), _scanlines.begin() + offset, _scanlines.begin() + offset + length);
+    }
+    // Adler-32, reduced every 5552 bytes, the most that cannot overflow 32 bits
+    GLuint adlerA = 1, adlerB = 0;
+    for (size_t offset = 0; offset < imageSize; offset += 5552) {
+        const size_t end = std::min(imageSize, offset + 5552);
+        for (size_t i = offset; i < end; i++) {
+            adlerA += _scanlines[i];
+            adlerB += adlerA;
+        }
+        adlerA %= 65521;
+        adlerB %= 65521;
+    }
+    putBigEndian(_encoded, (adlerB << 16) | adlerA);
+
+    static constexpr GLubyte SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<GLubyte> header;
+    putBigEndian(header, _width);
+    putBigEndian(header, _height);
+    header.insert(header.end(), {8, 2, 0, 0, 0}); // 8 bit RGB, no interlace
+
+    const bool written = fwrite(SIGNATURE, 1, sizeof(SIGNATURE), file) == sizeof(SIGNATURE)
+                         && writeChunk(file, "IHDR", header.data(), header.size())
+                         && writeChunk(file, "IDAT", _encoded.data(), _encoded.size())
+                         && writeChunk(file, "IEND", nullptr, 0);
+    return fclose(file) == 0 && written;
+}
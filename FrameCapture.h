@@ -0,0 +1,118 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <glad/gl.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// \class FrameCapture
+/// \desc Records every presented frame to disk without stalling the GPU.  Each frame is read
+/// back into one of a ring of pixel buffer objects and only mapped once the ring comes back
+/// around to it, by which time the copy has finished.  Mapped pixels are handed to a writer
+/// thread that converts and streams them out, either as one raw Y4M video or as a numbered
+/// sequence of PNG images
+class FrameCapture {
+public:
+    /// \desc creates a capture, call start() once a context is current
+    /// \param FILENAME a .y4m video, or a PNG name with a printf style frame number such as
+    /// frames/ride_%05u.png
+    /// \param framesPerSecond frame rate written to a Y4M header
+    FrameCapture(const char* FILENAME, GLuint framesPerSecond);
+    /// \desc flushes the remaining frames and stops the writer thread
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    /// \desc creates the pixel buffers and starts the writer thread
+    /// \returns false if the file name is not a Y4M or PNG pattern, or the video could not be created
+    bool start();
+    /// \desc queues a read back of the bound read framebuffer and hands the oldest finished
+    /// read back to the writer.  The capture size is fixed by the first frame; frames of any
+    /// other size are skipped
+    /// \param width framebuffer width
+    /// \param height framebuffer height
+    void captureFrame(GLint width, GLint height);
+    /// \desc writes every frame still in the ring, waits for the writer and releases the pixel
+    /// buffers.  Call while the context is still current
+    void finish();
+
+    /// \desc numbers the captured frames first, first + stride, ... in PNG file names,
+    /// instead of 0, 1, ...  Call before the first captureFrame()
+    void setFrameNumbering(GLuint first, GLuint stride) { _firstFrame = first; _frameStride = stride; }
+
+    /// \desc number of frames read back so far
+    [[nodiscard]] GLuint getNumFramesCaptured() const { return _numCaptured; }
+    /// \desc number of frames that could not be written or were skipped, valid after finish()
+    [[nodiscard]] GLuint getNumFramesLost() const { return _numFailed + _numSkipped; }
+
+private:
+    /// \desc a frame read back from the GPU, rows bottom to top as RGBA
+    struct Frame {
+        GLuint index;
+        std::vector<GLubyte> pixels;
+    };
+
+    /// \desc maps a pixel buffer and queues its contents for the writer
+    void _readBack(GLuint slot);
+    /// \desc body of the writer thread
+    void _write();
+    /// \desc appends a frame to the Y4M video as 4:2:0 BT.601 limited range
+    bool _writeY4M(const Frame& frame);
+    /// \desc writes a frame as an uncompressed PNG, deflate stored blocks keep the writer cheap
+    bool _writePNG(const Frame& frame);
+
+    /// \desc pixel buffers in the ring, a read back is mapped NUM_PBOS frames after it was issued
+    static constexpr GLuint NUM_PBOS = 3;
+    /// \desc frames the writer may fall behind by before capture waits for it
+    static constexpr GLuint MAX_PENDING_FRAMES = 8;
+
+    enum class Format { Y4M, PNG };
+
+    std::string _filename;
+    Format _format;
+    GLuint _framesPerSecond;
+    /// \desc open Y4M video, null for PNG sequences
+    FILE* _pVideoFile;
+
+    GLint _width;
+    GLint _height;
+    GLuint _numCaptured;
+    /// \desc frames not captured because the window was resized
+    GLuint _numSkipped;
+    /// \desc number given to the first frame, and the step between frame numbers
+    GLuint _firstFrame;
+    GLuint _frameStride;
+
+    GLuint _pbos[NUM_PBOS];
+    GLsync _fences[NUM_PBOS];
+    /// \desc frame index held by each pixel buffer, valid while its fence is set
+    GLuint _pboFrames[NUM_PBOS];
+    GLuint _nextPBO;
+
+    std::thread _thread;
+    /// \desc guards everything below
+    std::mutex _mutex;
+    /// \desc signaled when a frame is queued or capture finishes
+    std::condition_variable _frameQueued;
+    /// \desc signaled when the writer releases a buffer
+    std::condition_variable _frameWritten;
+    /// \desc oldest first, reserved up front so queueing a frame never allocates
+    std::vector<Frame> _pendingFrames;
+    /// \desc pixel storage returned by the writer for reuse
+    std::vector<std::vector<GLubyte>> _freeBuffers;
+    bool _finishing;
+    /// \desc frames handed to the writer that could not be written
+    GLuint _numFailed;
+
+    /// \desc writer scratch space for converted pixels, only touched by the writer thread
+    std::vector<GLubyte> _encoded;
+    std::vector<GLubyte> _scanlines;
+};
+
+#endif // FRAME_CAPTURE_H
@@ -0,0 +1,158 @@
+#include "FramePacer.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+FramePacer::FramePacer()
+    : _swapMode(SwapMode::ADAPTIVE),
+      _maxQueuedFrames(1),
+      _targetFramesPerSecond(0),
+      _inputTime(0.0),
+      _clockOffset(0.0),
+      _numMeasured(0),
+      _totalLatency(0.0),
+      _maxLatency(0.0)
+{
+}
+
+FramePacer::~FramePacer()
+{
+    for (const FrameInFlight& frame : _framesInFlight) {
+        glDeleteSync(frame.fence);
+        glDeleteQueries(1, &frame.timestampQuery);
+    }
+    if (!_freeQueries.empty()) {
+        glDeleteQueries(_freeQueries.size(), _freeQueries.data());
+    }
+}
+
+void FramePacer::setup()
+{
+    GLint swapInterval = 0;
+    switch (_swapMode) {
+        case SwapMode::IMMEDIATE:
+            swapInterval = 0;
+            break;
+        case SwapMode::VSYNC:
+            swapInterval = 1;
+            break;
+        case SwapMode::ADAPTIVE:
+            // a negative interval lets a late frame tear instead of waiting for the next refresh
+            if (glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+                swapInterval = -1;
+            } else {
+                fprintf(stdout, "[INFO]: adaptive vsync is not supported, using vsync\n");
+                swapInterval = 1;
+            }
+            break;
+    }
+    glfwSwapInterval(swapInterval);
+
+    // a synced swap presents once every swap interval refreshes of the display
+    _targetFramesPerSecond = 0;
+    const GLFWvidmode* pVideoMode = glfwGetPrimaryMonitor() ? glfwGetVideoMode(glfwGetPrimaryMonitor()) : nullptr;
+    if (swapInterval != 0 && pVideoMode) {
+        _targetFramesPerSecond = pVideoMode->refreshRate / abs(swapInterval);
+    }
+
+    // a frame is only ever in one of these at a time, so none of them grows once reserved
+    _framesInFlight.reserve(_maxQueuedFrames);
+    _freeQueries.reserve(_maxQueuedFrames);
+    _finishedFrames.reserve(_maxQueuedFrames);
+    fprintf(stdout, "[INFO]: swap interval %d, at most %u frame%s in flight\n",
+            swapInterval, _maxQueuedFrames, _maxQueuedFrames == 1 ? "" : "s");
+}
+
+void FramePacer::waitForQueue()
+{
+    _retireFrames(false);
+    while (_framesInFlight.size() >= _maxQueuedFrames) {
+        _retireFrames(true);
+    }
+}
+
+void FramePacer::inputSampled()
+{
+    _calibrateClock();
+    _inputTime = glfwGetTime();
+}
+
+void FramePacer::framePresented(const GLuint frame, const double frameSeconds)
+{
+    FrameInFlight inFlight;
+    inFlight.frame = frame;
+    inFlight.inputTime = _inputTime;
+    inFlight.frameSeconds = frameSeconds;
+    if (_freeQueries.empty()) {
+        glGenQueries(1, &inFlight.timestampQuery);
+    } else {
+        inFlight.timestampQuery = _freeQueries.back();
+        _freeQueries.pop_back();
+    }
+    // the query lands after the swap in the command stream, the fence right behind it
+    glQueryCounter(inFlight.timestampQuery, GL_TIMESTAMP);
+    inFlight.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _framesInFlight.push_back(inFlight);
+}
+
+void FramePacer::finish()
+{
+    while (!_framesInFlight.empty()) {
+        _retireFrames(true);
+    }
+    if (!_freeQueries.empty()) {
+        glDeleteQueries(_freeQueries.size(), _freeQueries.data());
+        _freeQueries.clear();
+    }
+}
+
+bool FramePacer::nextFrameTiming(FrameTiming& timing)
+{
+    if (_finishedFrames.empty()) return false;
+    timing = _finishedFrames.front();
+    _finishedFrames.erase(_finishedFrames.begin());
+    return true;
+}
+
+void FramePacer::_retireFrames(bool waitForOldest)
+{
+    while (!_framesInFlight.empty()) {
+        FrameInFlight& oldest = _framesInFlight.front();
+
+        // a zero timeout only checks the fence; waiting flushes so the fence is sure to signal
+        GLenum status;
+        do {
+            status = glClientWaitSync(oldest.fence, waitForOldest ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                      waitForOldest ? 1000000000ull : 0);
+        } while (waitForOldest && status == GL_TIMEOUT_EXPIRED);
+        if (status == GL_TIMEOUT_EXPIRED) return;
+        waitForOldest = false;
+
+        FrameTiming timing;
+        timing.frame = oldest.frame;
+        timing.frameSeconds = oldest.frameSeconds;
+        timing.latencySeconds = 0.0;
+        if (status != GL_WAIT_FAILED) {
+            GLuint64 finishNanoseconds = 0;
+            glGetQueryObjectui64v(oldest.timestampQuery, GL_QUERY_RESULT, &finishNanoseconds);
+            timing.latencySeconds = finishNanoseconds * 1e-9 + _clockOffset - oldest.inputTime;
+
+            _numMeasured++;
+            _totalLatency += timing.latencySeconds;
+            if (timing.latencySeconds > _maxLatency) _maxLatency = timing.latencySeconds;
+        }
+        _finishedFrames.push_back(timing);
+
+        glDeleteSync(oldest.fence);
+        _freeQueries.push_back(oldest.timestampQuery);
+        _framesInFlight.erase(_framesInFlight.begin());
+    }
+}
+
+void FramePacer::_calibrateClock()
+{
+    // reading GL_TIMESTAMP returns the GPU clock now, without waiting on queued work
+    GLint64 gpuNanoseconds = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNanoseconds);
+    _clockOffset = glfwGetTime() - gpuNanoseconds * 1e-9;
+}
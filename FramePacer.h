@@ -0,0 +1,121 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <glad/gl.h>
+#include <GLFW/glfw3.h>
+
+#include <vector>
+
+/// \class FramePacer
+/// \desc Keeps the driver from queueing frames ahead of the display and measures how long input
+/// takes to reach the screen.  Every presented frame is followed by a fence; before input is
+/// sampled for the next frame the pacer waits until at most a set number of frames are still
+/// in flight, so the input read right after is shown as soon as the GPU can draw it.  A
+/// timestamp query next to each fence records when the GPU finished the frame, which is
+/// mapped to the CPU clock to give the input-to-present latency of every frame
+class FramePacer {
+public:
+    /// \desc how buffer swaps wait for the display
+    enum class SwapMode {
+        /// \desc swap immediately, tearing allowed
+        IMMEDIATE,
+        /// \desc wait for vertical blank
+        VSYNC,
+        /// \desc wait for vertical blank, but swap immediately when a frame is late instead of
+        /// waiting a whole refresh.  Falls back to VSYNC without driver support
+        ADAPTIVE
+    };
+
+    /// \desc timing of a frame whose GPU work has finished
+    struct FrameTiming {
+        /// \desc simulation frame
+        GLuint frame;
+        /// \desc wall clock time between the start of this frame and the next
+        double frameSeconds;
+        /// \desc time from sampling the frame's input until the GPU finished drawing it
+        double latencySeconds;
+    };
+
+    /// \desc creates a pacer allowing one frame in flight with adaptive vsync
+    FramePacer();
+    /// \desc deletes the fences and queries of frames still in flight
+    ~FramePacer();
+
+    FramePacer(const FramePacer&) = delete;
+    FramePacer& operator=(const FramePacer&) = delete;
+
+    /// \desc selects the swap mode, call before setup()
+    void setSwapMode(SwapMode mode) { _swapMode = mode; }
+    /// \desc limits the number of frames submitted but not yet finished by the GPU, call before setup()
+    /// \param maxQueuedFrames frames allowed in flight, at least 1
+    void setMaxQueuedFrames(GLuint maxQueuedFrames) { _maxQueuedFrames = maxQueuedFrames > 0 ? maxQueuedFrames : 1; }
+
+    /// \desc applies the swap interval to the current context
+    void setup();
+
+    /// \desc blocks until fewer than the maximum number of frames are in flight, call right
+    /// before polling input
+    void waitForQueue();
+    /// \desc marks the moment this frame's input was sampled
+    void inputSampled();
+    /// \desc fences the frame just handed to glfwSwapBuffers()
+    /// \param frame simulation frame that was presented
+    /// \param frameSeconds wall clock time the frame took
+    void framePresented(GLuint frame, double frameSeconds);
+    /// \desc waits for every frame in flight, so their timings can be collected, and releases
+    /// the timing queries.  Call while the context is still current
+    void finish();
+
+    /// \desc takes the timing of the next finished frame, in presentation order
+    /// \param [out] timing finished frame
+    /// \returns false when no more frames have finished
+    bool nextFrameTiming(FrameTiming& timing);
+
+    /// \desc number of frames whose latency was measured
+    [[nodiscard]] GLuint getNumMeasuredFrames() const { return _numMeasured; }
+    /// \desc mean and worst input-to-present latency so far, in seconds
+    [[nodiscard]] double getAverageLatency() const { return _numMeasured > 0 ? _totalLatency / _numMeasured : 0.0; }
+    [[nodiscard]] double getMaxLatency() const { return _maxLatency; }
+    /// \desc frames per second the swaps are paced to, known after setup().  0 when swaps
+    /// do not wait for the display
+    [[nodiscard]] GLuint getTargetFramesPerSecond() const { return _targetFramesPerSecond; }
+
+private:
+    /// \desc a presented frame the GPU may still be working on
+    struct FrameInFlight {
+        GLuint frame;
+        double inputTime;
+        double frameSeconds;
+        GLsync fence;
+        /// \desc GL_TIMESTAMP query written when the GPU reaches the end of the frame
+        GLuint timestampQuery;
+    };
+
+    /// \desc retires every frame in flight whose fence has signaled
+    /// \param waitForOldest if true blocks on the oldest frame first
+    void _retireFrames(bool waitForOldest);
+    /// \desc measures the offset between the GPU timestamp clock and the CPU clock
+    void _calibrateClock();
+
+    SwapMode _swapMode;
+    GLuint _maxQueuedFrames;
+    GLuint _targetFramesPerSecond;
+
+    /// \desc CPU time this frame's input was sampled
+    double _inputTime;
+    /// \desc CPU seconds minus GPU seconds, refreshed every frame since the clocks drift
+    double _clockOffset;
+
+    /// \desc oldest first.  Only a few frames are ever queued, so vectors that keep their
+    /// capacity beat deques, which allocate and free blocks as frames come and go
+    std::vector<FrameInFlight> _framesInFlight;
+    /// \desc timing queries no longer in flight, reused to avoid creating one per frame
+    std::vector<GLuint> _freeQueries;
+    std::vector<FrameTiming> _finishedFrames;
+
+    GLuint _numMeasured;
+    double _totalLatency;
+    double _maxLatency;
+};
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,158 @@
+#include "GLStateCache.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstring>
+
+GLStateCache::GLStateCache()
+    : _program(UNKNOWN),
+      _vao(UNKNOWN),
+      _activeTextureUnit(UNKNOWN),
+      _textures{},
+      _numIssued(0),
+      _numElided(0),
+      _lastFrameIssued(0),
+      _lastFrameElided(0),
+      _totalIssued(0),
+      _totalElided(0)
+{
+    invalidateBindings();
+}
+
+bool GLStateCache::hasGL43()
+{
+    // the engine asks for a 4.1 context, drivers that can do more usually hand back more
+    return GLAD_GL_VERSION_4_3;
+}
+
+void GLStateCache::beginFrame()
+{
+    _totalIssued += _numIssued;
+    _totalElided += _numElided;
+    _lastFrameIssued = _numIssued;
+    _lastFrameElided = _numElided;
+    _numIssued = 0;
+    _numElided = 0;
+}
+
+void GLStateCache::useProgram(const GLuint program)
+{
+    if (program == _program) {
+        _numElided++;
+        return;
+    }
+    glUseProgram(program);
+    _program = program;
+    _numIssued++;
+}
+
+void GLStateCache::bindVertexArray(const GLuint vao)
+{
+    if (vao == _vao) {
+        _numElided++;
+        return;
+    }
+    glBindVertexArray(vao);
+    _vao = vao;
+    _numIssued++;
+}
+
+void GLStateCache::bindTexture(const GLuint unit, const GLuint texture)
+{
+    if (unit >= MAX_TEXTURE_UNITS) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        _activeTextureUnit = unit;
+        _numIssued += 2;
+        return;
+    }
+    if (texture == _textures[unit]) {
+        _numElided++;
+        return;
+    }
+    if (unit != _activeTextureUnit) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        _activeTextureUnit = unit;
+        _numIssued++;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture);
+    _textures[unit] = texture;
+    _numIssued++;
+}
+
+void GLStateCache::setUniform(const GLuint program, const GLint location, const GLint value)
+{
+    if (_updateUniform(program, location, &value, 1)) glProgramUniform1i(program, location, value);
+}
+
+void GLStateCache::setUniform(const GLuint program, const GLint location, const GLfloat value)
+{
+    if (_updateUniform(program, location, &value, 1)) glProgramUniform1f(program, location, value);
+}
+
+void GLStateCache::setUniform(const GLuint program, const GLint location, const glm::vec3& value)
+{
+    if (_updateUniform(program, location, glm::value_ptr(value), 3)) glProgramUniform3fv(program, location, 1, glm::value_ptr(value));
+}
+
+void GLStateCache::setUniform(const GLuint program, const GLint location, const glm::mat3& value)
+{
+    if (_updateUniform(program, location, glm::value_ptr(value), 9)) glProgramUniformMatrix3fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void GLStateCache::setUniform(const GLuint program, const GLint location, const glm::mat4& value)
+{
+    if (_updateUniform(program, location, glm::value_ptr(value), 16)) glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void GLStateCache::invalidateBindings()
+{
+    _program = UNKNOWN;
+    _vao = UNKNOWN;
+    _activeTextureUnit = UNKNOWN;
+    for (GLuint& texture : _textures) {
+        texture = UNKNOWN;
+    }
+}
+
+void GLStateCache::invalidateUniforms(const GLuint program)
+{
+    for (ProgramUniforms& uniforms : _programs) {
+        if (uniforms.program != program) continue;
+        for (UniformValue& value : uniforms.values) {
+            value.size = 0;
+        }
+    }
+}
+
+bool GLStateCache::_updateUniform(const GLuint program, const GLint location, const void* value, const GLuint size)
+{
+    if (location < 0) return false;
+
+    // a handful of programs, so a linear search beats hashing
+    ProgramUniforms* pUniforms = nullptr;
+    for (ProgramUniforms& uniforms : _programs) {
+        if (uniforms.program == program) {
+            pUniforms = &uniforms;
+            break;
+        }
+    }
+    if (!pUniforms) {
+        _programs.push_back({program, {}});
+        pUniforms = &_programs.back();
+    }
+    if (static_cast<GLuint>(location) >= pUniforms->values.size()) {
+        pUniforms->values.resize(location + 1, UniformValue{0, {}});
+    }
+
+    // compared bit for bit, so changing 0.0 to -0.0 is still sent
+    UniformValue& shadow = pUniforms->values[location];
+    if (shadow.size == size && memcmp(shadow.bits, value, size * sizeof(GLuint)) == 0) {
+        _numElided++;
+        return false;
+    }
+    shadow.size = size;
+    memcpy(shadow.bits, value, size * sizeof(GLuint));
+    _numIssued++;
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class GLStateCache
+/// \desc Shadows the GL state the renderer changes most and only calls GL when a value really
+/// changes.  The bound program, vertex array and 2D textures are remembered, and every uniform
+/// set through the cache is remembered per program and location, so setting the same material
+/// color or flag again costs a compare instead of a driver call.  Code that changes the same
+/// state behind the cache's back must say so with invalidateBindings() or invalidateUniforms(),
+/// or the cache would skip a call it needs.  Calls issued and skipped are counted per frame
+class GLStateCache {
+public:
+    /// \desc texture units whose 2D binding is shadowed
+    static constexpr GLuint MAX_TEXTURE_UNITS = 4;
+
+    /// \desc creates a cache that knows nothing of the current state
+    GLStateCache();
+
+    GLStateCache(const GLStateCache&) = delete;
+    GLStateCache& operator=(const GLStateCache&) = delete;
+
+    /// \desc whether the current context offers GL 4.3, for compute shaders and indirect draws
+    static bool hasGL43();
+
+    /// \desc starts counting a new frame, the last frame's counts stay readable
+    void beginFrame();
+
+    /// \desc glUseProgram
+    void useProgram(GLuint program);
+    /// \desc glBindVertexArray
+    void bindVertexArray(GLuint vao);
+    /// \desc glActiveTexture and glBindTexture of a GL_TEXTURE_2D
+    void bindTexture(GLuint unit, GLuint texture);
+
+    /// \desc glProgramUniform* of one value, a location of -1 is ignored
+    void setUniform(GLuint program, GLint location, GLint value);
+    void setUniform(GLuint program, GLint location, GLfloat value);
+    void setUniform(GLuint program, GLint location, const glm::vec3& value);
+    void setUniform(GLuint program, GLint location, const glm::mat3& value);
+    void setUniform(GLuint program, GLint location, const glm::mat4& value);
+
+    /// \desc forgets the bound program, vertex array and textures, call after code outside the
+    /// cache may have changed them
+    void invalidateBindings();
+    /// \desc forgets the uniforms of a program, call after code outside the cache set any of them
+    void invalidateUniforms(GLuint program);
+
+    /// \desc GL calls made and skipped during the last complete frame
+    [[nodiscard]] GLuint getNumIssued() const { return _lastFrameIssued; }
+    [[nodiscard]] GLuint getNumElided() const { return _lastFrameElided; }
+    /// \desc GL calls made and skipped since the cache was created
+    [[nodiscard]] unsigned long long getTotalIssued() const { return _totalIssued + _numIssued; }
+    [[nodiscard]] unsigned long long getTotalElided() const { return _totalElided + _numElided; }
+
+private:
+    /// \desc the last value sent to one uniform, compared as raw bits
+    struct UniformValue {
+        /// \desc number of 32-bit words stored, 0 if the value is unknown
+        GLuint size;
+        GLuint bits[16];
+    };
+    /// \desc shadowed uniforms of one program, indexed by location
+    struct ProgramUniforms {
+        GLuint program;
+        std::vector<UniformValue> values;
+    };
+
+    /// \desc compares a value with its shadow and stores it if it differs
+    /// \returns true if the value changed and has to be sent
+    bool _updateUniform(GLuint program, GLint location, const void* value, GLuint size);
+
+    /// \desc the binding is unknown
+    static constexpr GLuint UNKNOWN = ~0u;
+
+    GLuint _program;
+    GLuint _vao;
+    GLuint _activeTextureUnit;
+    GLuint _textures[MAX_TEXTURE_UNITS];
+    std::vector<ProgramUniforms> _programs;
+
+    GLuint _numIssued;
+    GLuint _numElided;
+    GLuint _lastFrameIssued;
+    GLuint _lastFrameElided;
+    unsigned long long _totalIssued;
+    unsigned long long _totalElided;
+};
+
+#endif // GL_STATE_CACHE_H
@@ -0,0 +1,156 @@
+#include "GeometryPool.h"
+
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cstdio>
+
+GeometryPool::GeometryPool()
+    : _positionLocation(-1),
+      _normalLocation(-1),
+      _texCoordLocation(-1),
+      _vao(0),
+      _vbo(0),
+      _ibo(0),
+      _multiDrawIndirect(false),
+      _indirectBuffer(0),
+      _indirectCapacity(0)
+{
+}
+
+GeometryPool::~GeometryPool()
+{
+    glDeleteBuffers(1, &_vbo);
+    glDeleteBuffers(1, &_ibo);
+    glDeleteBuffers(1, &_indirectBuffer);
+    glDeleteVertexArrays(1, &_vao);
+}
+
+void GeometryPool::setup(const GLuint vertexCapacity, const GLuint indexCapacity,
+                         const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation,
+                         const bool allowMultiDrawIndirect)
+{
+    _positionLocation = positionLocation;
+    _normalLocation = normalLocation;
+    _texCoordLocation = texCoordLocation;
+    _vertexRanges.reset(std::max(vertexCapacity, 1u));
+    _indexRanges.reset(std::max(indexCapacity, 1u));
+
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+
+    glGenBuffers(1, &_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, _vertexRanges.getCapacity() * sizeof(PackedVertex), nullptr, GL_STATIC_DRAW);
+    VertexFormat::setAttributeLocations(_positionLocation, _normalLocation, _texCoordLocation);
+
+    glGenBuffers(1, &_ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, _indexRanges.getCapacity() * sizeof(GLushort), nullptr, GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    _multiDrawIndirect = allowMultiDrawIndirect && (GLStateCache::hasGL43() || GLAD_GL_ARB_multi_draw_indirect);
+    if (_multiDrawIndirect) {
+        glGenBuffers(1, &_indirectBuffer);
+    }
+    fprintf(stdout, "[INFO]: static geometry pool of %u vertices and %u indices, submitted with %s\n",
+            _vertexRanges.getCapacity(), _indexRanges.getCapacity(),
+            _multiDrawIndirect ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex");
+}
+
+GeometryPool::Range GeometryPool::allocateVertices(const GLuint count)
+{
+    Range range = _vertexRanges.allocate(count);
+    if (range.count == 0 && count > 0) {
+        const GLuint oldCapacity = _vertexRanges.getCapacity();
+        const GLuint newCapacity = std::max(2 * oldCapacity, oldCapacity + count);
+        _growBuffer(GL_ARRAY_BUFFER, _vbo, oldCapacity * sizeof(PackedVertex), newCapacity * sizeof(PackedVertex));
+        _vertexRanges.grow(newCapacity);
+
+        // the VAO still points at the old buffer
+        glBindVertexArray(_vao);
+        glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+        VertexFormat::setAttributeLocations(_positionLocation, _normalLocation, _texCoordLocation);
+        glBindVertexArray(0);
+        range = _vertexRanges.allocate(count);
+    }
+    return range;
+}
+
+GeometryPool::Range GeometryPool::allocateIndices(const GLuint count)
+{
+    Range range = _indexRanges.allocate(count);
+    if (range.count == 0 && count > 0) {
+        const GLuint oldCapacity = _indexRanges.getCapacity();
+        const GLuint newCapacity = std::max(2 * oldCapacity, oldCapacity + count);
+        // the element binding is VAO state, so the new buffer is bound with the VAO current
+        glBindVertexArray(_vao);
+        _growBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo, oldCapacity * sizeof(GLushort), newCapacity * sizeof(GLushort));
+        glBindVertexArray(0);
+        _indexRanges.grow(newCapacity);
+        range = _indexRanges.allocate(count);
+    }
+    return range;
+}
+
+void GeometryPool::uploadVertices(const Range range, const PackedVertex* vertices) const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(range.first) * sizeof(PackedVertex),
+                    range.count * sizeof(PackedVertex), vertices);
+}
+
+void GeometryPool::uploadIndices(const Range range, const GLushort* indices) const
+{
+    // through the copy target, so no VAO's element binding changes
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _ibo);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(range.first) * sizeof(GLushort),
+                    range.count * sizeof(GLushort), indices);
+}
+
+void GeometryPool::addDraw(const Range indices, const GLuint baseVertex)
+{
+    if (indices.count == 0) return;
+    _commands.push_back({indices.count, 1, indices.first, static_cast<GLint>(baseVertex), 0});
+}
+
+void GeometryPool::submitDraws()
+{
+    if (_commands.empty() || _vao == 0) return;
+
+    glBindVertexArray(_vao);
+    if (_multiDrawIndirect) {
+        // orphan the buffer so this frame's commands never wait on the last frame's draws
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirectBuffer);
+        _indirectCapacity = std::max(_indirectCapacity, static_cast<GLuint>(_commands.size()));
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, _indirectCapacity * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, _commands.size() * sizeof(DrawCommand), _commands.data());
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, _commands.size(), 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    } else {
+        _counts.resize(_commands.size());
+        _indexOffsets.resize(_commands.size());
+        _baseVertices.resize(_commands.size());
+        for (size_t c = 0; c < _commands.size(); c++) {
+            _counts[c] = _commands[c].count;
+            _indexOffsets[c] = reinterpret_cast<const void*>(static_cast<size_t>(_commands[c].firstIndex) * sizeof(GLushort));
+            _baseVertices[c] = _commands[c].baseVertex;
+        }
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, _counts.data(), GL_UNSIGNED_SHORT, _indexOffsets.data(),
+                                      _commands.size(), _baseVertices.data());
+    }
+    glBindVertexArray(0);
+}
+
+void GeometryPool::_growBuffer(const GLenum target, GLuint& buffer, const GLsizeiptr oldBytes, const GLsizeiptr newBytes)
+{
+    GLuint grown;
+    glGenBuffers(1, &grown);
+    glBindBuffer(target, grown);
+    glBufferData(target, newBytes, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0, oldBytes);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
@@ -0,0 +1,109 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include "RangeAllocator.h"
+#include "VertexFormat.h"
+
+#include <glad/gl.h>
+
+#include <vector>
+
+/// \class GeometryPool
+/// \desc Shared vertex and index buffers for static meshes.  Meshes take ranges of one large
+/// PackedVertex buffer and one GL_UNSIGNED_SHORT index buffer through a RangeAllocator, so any
+/// number of them draw from a single VAO, and a full buffer is doubled in place with the
+/// meshes already in it copied over on the GPU.  Indices are relative to the first vertex of a
+/// draw, so meshes of the same shape can share one index range.  Draws are queued as indirect
+/// commands and submitted together: with GL 4.3 or ARB_multi_draw_indirect the commands go
+/// to an indirect buffer and out in one glMultiDrawElementsIndirect, on a GL 4.1 context the
+/// same list goes out in one glMultiDrawElementsBaseVertex
+class GeometryPool {
+public:
+    typedef RangeAllocator::Range Range;
+
+    /// \desc creates an empty pool, call setup() once a context is current
+    GeometryPool();
+    /// \desc releases the buffers
+    ~GeometryPool();
+
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    /// \desc allocates the buffers
+    /// \param vertexCapacity vertices to allocate up front
+    /// \param indexCapacity indices to allocate up front
+    /// \param positionLocation attribute location for the vertex position
+    /// \param normalLocation attribute location for the vertex normal
+    /// \param texCoordLocation attribute location for the texture coordinate
+    /// \param allowMultiDrawIndirect false to always submit through the GL 4.1 path
+    void setup(GLuint vertexCapacity, GLuint indexCapacity,
+               GLint positionLocation, GLint normalLocation, GLint texCoordLocation,
+               bool allowMultiDrawIndirect = true);
+
+    /// \desc allocates vertices, growing the vertex buffer if no free range is large enough
+    Range allocateVertices(GLuint count);
+    /// \desc allocates indices, growing the index buffer if no free range is large enough
+    Range allocateIndices(GLuint count);
+    void freeVertices(Range range) { _vertexRanges.free(range); }
+    void freeIndices(Range range) { _indexRanges.free(range); }
+
+    /// \desc copies vertices into an allocated range
+    void uploadVertices(Range range, const PackedVertex* vertices) const;
+    /// \desc copies indices, relative to the draw's base vertex, into an allocated range
+    void uploadIndices(Range range, const GLushort* indices) const;
+
+    /// \desc VAO every mesh in the pool draws from
+    [[nodiscard]] GLuint getVAO() const { return _vao; }
+    /// \desc true if submitDraws() uses glMultiDrawElementsIndirect
+    [[nodiscard]] bool isMultiDrawIndirect() const { return _multiDrawIndirect; }
+
+    /// \desc empties the draw queue
+    void clearDraws() { _commands.clear(); }
+    /// \desc queues a draw of an index range against a vertex range
+    /// \param indices triangle indices to draw
+    /// \param baseVertex first vertex of the mesh the indices count from
+    void addDraw(Range indices, GLuint baseVertex);
+    /// \desc draws everything queued since clearDraws() with the active shader and uniforms
+    void submitDraws();
+    /// \desc draws queued since clearDraws()
+    [[nodiscard]] GLuint getNumDraws() const { return _commands.size(); }
+
+private:
+    /// \desc layout glMultiDrawElementsIndirect reads from the indirect buffer
+    struct DrawCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    /// \desc replaces a buffer with one of a larger size holding the same data
+    /// \param target binding point the buffer is copied through
+    /// \param buffer buffer to grow, replaced by the new one
+    /// \param oldBytes size of the current buffer
+    /// \param newBytes size of the new buffer
+    static void _growBuffer(GLenum target, GLuint& buffer, GLsizeiptr oldBytes, GLsizeiptr newBytes);
+
+    RangeAllocator _vertexRanges;
+    RangeAllocator _indexRanges;
+    GLint _positionLocation;
+    GLint _normalLocation;
+    GLint _texCoordLocation;
+
+    GLuint _vao;
+    GLuint _vbo;
+    GLuint _ibo;
+
+    bool _multiDrawIndirect;
+    std::vector<DrawCommand> _commands;
+    GLuint _indirectBuffer;
+    /// \desc size of the indirect buffer in commands
+    GLuint _indirectCapacity;
+    /// \desc the queue unpacked into the arrays glMultiDrawElementsBaseVertex takes
+    std::vector<GLsizei> _counts;
+    std::vector<const void*> _indexOffsets;
+    std::vector<GLint> _baseVertices;
+};
+
+#endif // GEOMETRY_POOL_H
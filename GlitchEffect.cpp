@@ -0,0 +1,171 @@
+#include "GlitchEffect.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+GlitchEffect::GlitchEffect()
+    : _scale(0.5f),
+      _targetWidth(0),
+      _targetHeight(0),
+      _noiseTexture(0),
+      _sceneFramebuffer(0),
+      _sceneTexture(0),
+      _glitchFramebuffer(0),
+      _glitchTexture(0),
+      _glitchProgram(nullptr),
+      _sceneTextureLocation(-1),
+      _noiseTextureLocation(-1),
+      _grainScaleLocation(-1),
+      _bandScaleLocation(-1),
+      _noiseOffsetLocation(-1),
+      _compositeProgram(nullptr),
+      _glitchTextureLocation(-1),
+      _vao(0)
+{
+}
+
+GlitchEffect::~GlitchEffect()
+{
+    glDeleteFramebuffers(1, &_sceneFramebuffer);
+    glDeleteFramebuffers(1, &_glitchFramebuffer);
+    glDeleteTextures(1, &_sceneTexture);
+    glDeleteTextures(1, &_glitchTexture);
+    glDeleteTextures(1, &_noiseTexture);
+    glDeleteVertexArrays(1, &_vao);
+    delete _glitchProgram;
+    delete _compositeProgram;
+}
+
+bool GlitchEffect::setup()
+{
+    _glitchProgram = new CSCI441::ShaderProgram("shaders/fp-fullscreen.v.glsl", "shaders/fp-glitch.f.glsl");
+    _sceneTextureLocation = _glitchProgram->getUniformLocation("sceneTexture");
+    _noiseTextureLocation = _glitchProgram->getUniformLocation("noiseTexture");
+    _grainScaleLocation = _glitchProgram->getUniformLocation("grainScale");
+    _bandScaleLocation = _glitchProgram->getUniformLocation("bandScale");
+    _noiseOffsetLocation = _glitchProgram->getUniformLocation("noiseOffset");
+
+    _compositeProgram = new CSCI441::ShaderProgram("shaders/fp-fullscreen.v.glsl", "shaders/fp-glitch-composite.f.glsl");
+    _glitchTextureLocation = _compositeProgram->getUniformLocation("glitchTexture");
+
+    if (_sceneTextureLocation < 0 || _noiseTextureLocation < 0 || _glitchTextureLocation < 0) {
+        fprintf(stderr, "[ERROR]: Could not build the glitch shader programs\n");
+        return false;
+    }
+
+    glGenVertexArrays(1, &_vao);
+    glGenFramebuffers(1, &_sceneFramebuffer);
+    glGenFramebuffers(1, &_glitchFramebuffer);
+    glGenTextures(1, &_sceneTexture);
+    glGenTextures(1, &_glitchTexture);
+    glGenTextures(1, &_noiseTexture);
+    _buildNoiseTexture();
+    return true;
+}
+
+void GlitchEffect::setResolutionScale(const GLfloat scale)
+{
+    _scale = std::clamp(scale, MIN_SCALE, 1.0f);
+}
+
+void GlitchEffect::apply(const GLuint framebuffer, const GLint width, const GLint height, const GLfloat time)
+{
+    if (width <= 0 || height <= 0) return;
+
+    const GLint targetWidth = std::max(1, static_cast<GLint>(lroundf(width * _scale)));
+    const GLint targetHeight = std::max(1, static_cast<GLint>(lroundf(height * _scale)));
+    if (targetWidth != _targetWidth || targetHeight != _targetHeight) {
+        _resizeTargets(targetWidth, targetHeight);
+    }
+
+    // filtered copy of the frame down to the glitch resolution
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, _sceneFramebuffer);
+    glBlitFramebuffer(0, 0, width, height, 0, 0, _targetWidth, _targetHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    // the pattern only changes on glitch steps; each step reads the noise from somewhere else,
+    // picked on the CPU from the step number so replays and offline renders glitch identically.
+    // The top 24 bits of the generator map to [0, 1) the same way on every standard library,
+    // unlike std::uniform_real_distribution
+    std::mt19937 stepRandom(static_cast<std::mt19937::result_type>(floorf(time * GLITCH_RATE)) + 1);
+    const GLfloat noiseOffsetX = (stepRandom() >> 8) * (1.0f / 16777216.0f);
+    const GLfloat noiseOffsetY = (stepRandom() >> 8) * (1.0f / 16777216.0f);
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glBindVertexArray(_vao);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, _glitchFramebuffer);
+    glViewport(0, 0, _targetWidth, _targetHeight);
+    _glitchProgram->useProgram();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _sceneTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, _noiseTexture);
+    _glitchProgram->setProgramUniform(_sceneTextureLocation, 0);
+    _glitchProgram->setProgramUniform(_noiseTextureLocation, 1);
+    _glitchProgram->setProgramUniform(_grainScaleLocation,
+                                      glm::vec2(width / (GRAIN_PIXELS * NOISE_SIZE), height / (GRAIN_PIXELS * NOISE_SIZE)));
+    _glitchProgram->setProgramUniform(_bandScaleLocation, height / (BAND_PIXELS * NOISE_SIZE));
+    _glitchProgram->setProgramUniform(_noiseOffsetLocation, glm::vec2(noiseOffsetX, noiseOffsetY));
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    // torn bands are opaque and replace the frame, the grain has no coverage and adds to it
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glViewport(0, 0, width, height);
+    _compositeProgram->useProgram();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _glitchTexture);
+    _compositeProgram->setProgramUniform(_glitchTextureLocation, 0);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void GlitchEffect::_resizeTargets(const GLint width, const GLint height)
+{
+    _targetWidth = width;
+    _targetHeight = height;
+
+    const GLuint framebuffers[2] = {_sceneFramebuffer, _glitchFramebuffer};
+    const GLuint textures[2] = {_sceneTexture, _glitchTexture};
+    for (GLuint i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            fprintf(stderr, "[ERROR]: Glitch target %dx%d is incomplete\n", width, height);
+        }
+    }
+}
+
+void GlitchEffect::_buildNoiseTexture()
+{
+    // independent texels, so the texture repeats without a seam.  Each is the generator's top
+    // byte, which unlike std::uniform_int_distribution is the same on every standard library
+    std::mt19937 random(441);
+    std::vector<GLubyte> texels(static_cast<size_t>(NOISE_SIZE) * NOISE_SIZE * 4);
+    for (GLubyte& texel : texels) {
+        texel = static_cast<GLubyte>(random() >> 24);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, _noiseTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, NOISE_SIZE, NOISE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+    // nearest keeps the grain and bands blocky
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
@@ -0,0 +1,83 @@
+#ifndef GLITCH_EFFECT_H
+#define GLITCH_EFFECT_H
+
+#include <CSCI441/ShaderProgram.hpp>
+
+#include <glad/gl.h>
+
+/// \class GlitchEffect
+/// \desc Full screen glitch applied to a finished frame.  The frame is copied down to a
+/// reduced resolution, where horizontal bands are torn sideways, split into their color
+/// channels and covered in grain.  The grain and tearing come from a small tiling noise texture
+/// built once on the CPU; each glitch step only moves where it is sampled from.  Torn bands
+/// replace the full resolution frame while the grain is added over it, so everything outside
+/// the tears keeps its full resolution
+class GlitchEffect {
+public:
+    /// \desc creates the effect, call setup() once a context is current
+    GlitchEffect();
+    /// \desc releases the noise texture, targets and programs
+    ~GlitchEffect();
+
+    GlitchEffect(const GlitchEffect&) = delete;
+    GlitchEffect& operator=(const GlitchEffect&) = delete;
+
+    /// \desc compiles the glitch programs and builds the noise texture
+    /// \returns false if the GL objects could not be created
+    bool setup();
+
+    /// \desc sets the resolution the glitch is computed at
+    /// \param scale fraction of the frame resolution per axis, clamped to [MIN_SCALE, 1]
+    void setResolutionScale(GLfloat scale);
+
+    /// \desc glitches the color buffer of a framebuffer in place, which is left bound
+    /// \param framebuffer framebuffer holding the finished frame, 0 for the window's back buffer
+    /// \param width framebuffer width
+    /// \param height framebuffer height
+    /// \param time simulation time, the glitch pattern changes GLITCH_RATE times a second
+    void apply(GLuint framebuffer, GLint width, GLint height, GLfloat time);
+
+    /// \desc lowest resolution scale, per axis
+    static constexpr GLfloat MIN_SCALE = 0.125f;
+
+private:
+    /// \desc (re)allocates the reduced resolution targets
+    void _resizeTargets(GLint width, GLint height);
+    /// \desc fills the noise texture with seeded white noise, which tiles seamlessly
+    void _buildNoiseTexture();
+
+    /// \desc texels along each side of the noise texture
+    static constexpr GLint NOISE_SIZE = 64;
+    /// \desc new glitch patterns per second of simulation time
+    static constexpr GLfloat GLITCH_RATE = 24.0f;
+    /// \desc frame pixels covered by one grain texel and one torn band, at full resolution
+    static constexpr GLfloat GRAIN_PIXELS = 2.0f;
+    static constexpr GLfloat BAND_PIXELS = 12.0f;
+
+    GLfloat _scale;
+    /// \desc size of the reduced resolution targets
+    GLint _targetWidth;
+    GLint _targetHeight;
+
+    GLuint _noiseTexture;
+    /// \desc reduced resolution copy of the frame
+    GLuint _sceneFramebuffer;
+    GLuint _sceneTexture;
+    /// \desc reduced resolution glitch, premultiplied by how much it covers the frame
+    GLuint _glitchFramebuffer;
+    GLuint _glitchTexture;
+
+    CSCI441::ShaderProgram* _glitchProgram;
+    GLint _sceneTextureLocation;
+    GLint _noiseTextureLocation;
+    GLint _grainScaleLocation;
+    GLint _bandScaleLocation;
+    GLint _noiseOffsetLocation;
+
+    CSCI441::ShaderProgram* _compositeProgram;
+    GLint _glitchTextureLocation;
+    /// \desc empty VAO for the bufferless fullscreen triangle
+    GLuint _vao;
+};
+
+#endif // GLITCH_EFFECT_H
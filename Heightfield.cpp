@@ -0,0 +1,101 @@
+#include "Heightfield.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /// \desc well mixed 32 bits from a lattice point, the same on every platform
+    GLuint hashLattice(const GLint x, const GLint z, const GLuint seed) {
+        GLuint h = seed * 0x9E3779B9u;
+        h ^= static_cast<GLuint>(x) * 0x85EBCA6Bu;
+        h = (h ^ (h >> 13)) * 0xC2B2AE35u;
+        h ^= static_cast<GLuint>(z) * 0x27D4EB2Fu;
+        h = (h ^ (h >> 15)) * 0x85EBCA6Bu;
+        return h ^ (h >> 16);
+    }
+
+    /// \desc 0 below edge0, 1 above edge1 and a smooth ramp between
+    GLfloat smoothStep(const GLfloat edge0, const GLfloat edge1, const GLfloat x) {
+        const GLfloat t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+}
+
+Heightfield::Heightfield() = default;
+
+GLfloat Heightfield::getHeight(const GLfloat x, const GLfloat z) const
+{
+    GLfloat noise = 0.0f;
+    GLfloat weight = 1.0f;
+    GLfloat totalWeight = 0.0f;
+    GLfloat frequency = 1.0f / _settings.featureSize;
+    for (GLuint octave = 0; octave < _settings.octaves; octave++) {
+        noise += weight * _valueNoise(x * frequency, z * frequency, octave);
+        totalWeight += weight;
+        weight *= 0.5f;
+        frequency *= 2.0f;
+    }
+    if (totalWeight > 0.0f) noise /= totalWeight;
+
+    // rolling inside the park, hills outside it
+    const GLfloat distance = sqrtf(x * x + z * z);
+    const GLfloat hills = smoothStep(_settings.parkRadius, 4.0f * _settings.parkRadius, distance);
+    return noise * (_settings.parkAmplitude + hills * (_settings.amplitude - _settings.parkAmplitude));
+}
+
+glm::vec3 Heightfield::getNormal(const GLfloat x, const GLfloat z, const GLfloat spacing) const
+{
+    const GLfloat dx = getHeight(x + spacing, z) - getHeight(x - spacing, z);
+    const GLfloat dz = getHeight(x, z + spacing) - getHeight(x, z - spacing);
+    return glm::normalize(glm::vec3(-dx, 2.0f * spacing, -dz));
+}
+
+void Heightfield::sampleChunk(const glm::vec2 origin, const GLfloat size, const GLuint cells, const GLfloat skirtDepth,
+                              glm::vec3* positions, glm::vec3* normals) const
+{
+    const GLfloat spacing = size / cells;
+    for (GLuint row = 0; row <= cells; row++) {
+        for (GLuint column = 0; column <= cells; column++) {
+            const GLfloat x = origin.x + column * spacing;
+            const GLfloat z = origin.y + row * spacing;
+            const GLuint v = row * (cells + 1) + column;
+            positions[v] = glm::vec3(x, getHeight(x, z), z);
+            normals[v] = getNormal(x, z, spacing);
+        }
+    }
+
+    // skirt sides in the order bottom row, top row, left column, right column
+    const GLuint gridVertices = (cells + 1) * (cells + 1);
+    for (GLuint i = 0; i <= cells; i++) {
+        const GLuint border[4] = {i, cells * (cells + 1) + i, i * (cells + 1), i * (cells + 1) + cells};
+        for (GLuint side = 0; side < 4; side++) {
+            const GLuint v = gridVertices + side * (cells + 1) + i;
+            positions[v] = positions[border[side]] - glm::vec3(0.0f, skirtDepth, 0.0f);
+            normals[v] = normals[border[side]];
+        }
+    }
+}
+
+GLfloat Heightfield::_valueNoise(const GLfloat x, const GLfloat z, const GLuint octave) const
+{
+    const GLfloat cellX = floorf(x);
+    const GLfloat cellZ = floorf(z);
+    const GLint ix = static_cast<GLint>(cellX);
+    const GLint iz = static_cast<GLint>(cellZ);
+    const GLuint seed = _settings.seed + octave * 0x632BE5ABu;
+
+    // lattice values in [-1, 1] from the top 24 bits of their hashes
+    GLfloat corners[4];
+    for (GLuint c = 0; c < 4; c++) {
+        corners[c] = (hashLattice(ix + (c & 1), iz + (c >> 1), seed) >> 8) * (2.0f / 16777216.0f) - 1.0f;
+    }
+
+    // quintic fade keeps the slope continuous across lattice cells, so normals have no creases
+    const GLfloat fx = x - cellX;
+    const GLfloat fz = z - cellZ;
+    const GLfloat u = fx * fx * fx * (fx * (fx * 6.0f - 15.0f) + 10.0f);
+    const GLfloat w = fz * fz * fz * (fz * (fz * 6.0f - 15.0f) + 10.0f);
+    const GLfloat bottom = corners[0] + (corners[1] - corners[0]) * u;
+    const GLfloat top = corners[2] + (corners[3] - corners[2]) * u;
+    return bottom + (top - bottom) * w;
+}
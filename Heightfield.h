@@ -0,0 +1,68 @@
+#ifndef HEIGHTFIELD_H
+#define HEIGHTFIELD_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+/// \class Heightfield
+/// \desc Procedural ground height over the whole world.  Heights are fractal value noise
+/// evaluated on demand, so any part of the world can be sampled at any density without
+/// storing more than the chunks being drawn: the terrain streams its chunks from here and the
+/// support beams stand on it.  The park around the origin is kept gently rolling so the track
+/// keeps its clearance, and the hills rise beyond it.  Nothing here touches OpenGL
+class Heightfield {
+public:
+    /// \desc knobs controlling the shape of the ground
+    struct Settings {
+        /// \desc random seed, the same settings and seed always give the same ground
+        GLuint seed = 441;
+        /// \desc the ground covers [-worldSize / 2, worldSize / 2] on x and z
+        GLfloat worldSize = 2048.0f;
+        /// \desc height of the tallest hills above and below zero
+        GLfloat amplitude = 80.0f;
+        /// \desc height of the undulation inside the park
+        GLfloat parkAmplitude = 0.5f;
+        /// \desc radius of the park, the hills rise over the next three radii
+        GLfloat parkRadius = 55.0f;
+        /// \desc width of the largest hills
+        GLfloat featureSize = 400.0f;
+        /// \desc number of noise octaves, each half the width and height of the one before
+        GLuint octaves = 6;
+    };
+
+    /// \desc creates the ground with default settings
+    Heightfield();
+
+    /// \desc replaces the settings
+    void setSettings(const Settings& settings) { _settings = settings; }
+    [[nodiscard]] const Settings& getSettings() const { return _settings; }
+
+    /// \desc ground height at a point
+    [[nodiscard]] GLfloat getHeight(GLfloat x, GLfloat z) const;
+    /// \desc ground normal at a point, from central differences a spacing apart
+    /// \param spacing distance between the samples, the vertex spacing of the mesh being lit
+    [[nodiscard]] glm::vec3 getNormal(GLfloat x, GLfloat z, GLfloat spacing) const;
+
+    /// \desc samples a square of the ground as a grid with a skirt.  The skirt is a copy of the
+    /// grid's border dropped by skirtDepth, which hides the cracks where a chunk meets a
+    /// neighbour at another level of detail
+    /// \param origin minimum x and z corner of the square
+    /// \param size length of the square's sides
+    /// \param cells cells along each side
+    /// \param skirtDepth distance the skirt hangs below the border
+    /// \param [out] positions getNumChunkVertices(cells) positions, the grid row by row then the skirt
+    /// \param [out] normals matching normals
+    void sampleChunk(glm::vec2 origin, GLfloat size, GLuint cells, GLfloat skirtDepth,
+                     glm::vec3* positions, glm::vec3* normals) const;
+    /// \desc vertices sampleChunk() writes
+    static GLuint getNumChunkVertices(GLuint cells) { return (cells + 1) * (cells + 1) + 4 * (cells + 1); }
+
+private:
+    /// \desc smoothly interpolated random lattice values in [-1, 1]
+    [[nodiscard]] GLfloat _valueNoise(GLfloat x, GLfloat z, GLuint octave) const;
+
+    Settings _settings;
+};
+
+#endif // HEIGHTFIELD_H
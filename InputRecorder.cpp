@@ -0,0 +1,191 @@
+#include "InputRecorder.h"
+
+#include <cstring>
+
+InputRecorder::InputRecorder()
+    : _mode(Mode::OFF),
+      _pLogFile(nullptr),
+      _pFrameTimeFile(nullptr),
+      _header{{'F', 'P', 'I', 'R'}, LOG_VERSION, 0, 0},
+      _nextEvent(0),
+      _endFrame(0)
+{
+}
+
+InputRecorder::~InputRecorder()
+{
+    if (_pLogFile) fclose(_pLogFile);
+    if (_pFrameTimeFile) fclose(_pFrameTimeFile);
+}
+
+bool InputRecorder::startRecording(const char* FILENAME)
+{
+    _pLogFile = fopen(FILENAME, "wb");
+    if (!_pLogFile)
+    {
+        fprintf(stderr, "[ERROR]: Could not create input log \"%s\"\n", FILENAME);
+        return false;
+    }
+
+    // the header is rewritten with the window size once it is known
+    fwrite(&_header, sizeof(Header), 1, _pLogFile);
+    _mode = Mode::RECORD;
+    fprintf(stdout, "[INFO]: recording input to \"%s\"\n", FILENAME);
+    return true;
+}
+
+bool InputRecorder::startReplay(const char* FILENAME)
+{
+    FILE* file = fopen(FILENAME, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "[ERROR]: Could not open input log \"%s\"\n", FILENAME);
+        return false;
+    }
+
+    Header header;
+    bool valid = fread(&header, sizeof(Header), 1, file) == 1
+                 && memcmp(header.magic, _header.magic, sizeof(header.magic)) == 0
+                 && header.version == LOG_VERSION;
+    if (valid)
+    {
+        InputEvent event;
+        while (fread(&event, sizeof(InputEvent), 1, file) == 1)
+        {
+            _events.push_back(event);
+        }
+    }
+    fclose(file);
+
+    if (!valid)
+    {
+        fprintf(stderr, "[ERROR]: \"%s\" is not an input log of version %u\n", FILENAME, LOG_VERSION);
+        return false;
+    }
+
+    // the end marker holds the number of frames recorded; a session that did not shut down
+    // cleanly has none, so stop on the frame of its last event
+    _header = header;
+    if (!_events.empty() && _events.back().type == END_EVENT)
+    {
+        _endFrame = _events.back().frame;
+        _events.pop_back();
+    }
+    else
+    {
+        _endFrame = _events.empty() ? 0 : _events.back().frame + 1;
+    }
+    _nextEvent = 0;
+    _mode = Mode::REPLAY;
+    fprintf(stdout, "[INFO]: replaying %zu input events over %u frames from \"%s\"\n", _events.size(), _endFrame, FILENAME);
+    return true;
+}
+
+bool InputRecorder::startFrameTimeLog(const char* FILENAME)
+{
+    _pFrameTimeFile = fopen(FILENAME, "w");
+    if (!_pFrameTimeFile)
+    {
+        fprintf(stderr, "[ERROR]: Could not create frame time log \"%s\"\n", FILENAME);
+        return false;
+    }
+    fprintf(_pFrameTimeFile, "frame,milliseconds,latency_milliseconds\n");
+    return true;
+}
+
+void InputRecorder::setWindowSize(GLint width, GLint height)
+{
+    _header.windowWidth = width;
+    _header.windowHeight = height;
+    if (_mode != Mode::RECORD) return;
+
+    long position = ftell(_pLogFile);
+    fseek(_pLogFile, 0, SEEK_SET);
+    fwrite(&_header, sizeof(Header), 1, _pLogFile);
+    fseek(_pLogFile, position, SEEK_SET);
+}
+
+void InputRecorder::getWindowSize(GLint& width, GLint& height) const
+{
+    width = _header.windowWidth;
+    height = _header.windowHeight;
+}
+
+void InputRecorder::recordInput(GLuint frame, EventType type, GLint code, GLint action)
+{
+    if (_mode != Mode::RECORD) return;
+
+    InputEvent event;
+    event.frame = frame;
+    event.type = type;
+    event.input[0] = code;
+    event.input[1] = action;
+    fwrite(&event, sizeof(InputEvent), 1, _pLogFile);
+}
+
+void InputRecorder::recordCursor(GLuint frame, GLfloat x, GLfloat y)
+{
+    if (_mode != Mode::RECORD) return;
+
+    InputEvent event;
+    event.frame = frame;
+    event.type = CURSOR_POSITION_EVENT;
+    event.position[0] = x;
+    event.position[1] = y;
+    fwrite(&event, sizeof(InputEvent), 1, _pLogFile);
+}
+
+void InputRecorder::recordFrame(GLuint frame, GLfloat simulationTime, GLfloat step)
+{
+    if (_mode != Mode::RECORD) return;
+
+    InputEvent event;
+    event.frame = frame;
+    event.type = FRAME_EVENT;
+    event.timing[0] = simulationTime;
+    event.timing[1] = step;
+    fwrite(&event, sizeof(InputEvent), 1, _pLogFile);
+}
+
+bool InputRecorder::nextEvent(GLuint frame, InputEvent& event)
+{
+    if (_mode != Mode::REPLAY) return false;
+
+    if (_nextEvent >= _events.size() || _events[_nextEvent].frame > frame) return false;
+
+    event = _events[_nextEvent++];
+    return true;
+}
+
+bool InputRecorder::isReplayFinished(GLuint frame) const
+{
+    return _mode == Mode::REPLAY && _nextEvent >= _events.size() && frame + 1 >= _endFrame;
+}
+
+void InputRecorder::recordFrameTime(GLuint frame, double seconds, double latencySeconds)
+{
+    if (!_pFrameTimeFile) return;
+    fprintf(_pFrameTimeFile, "%u,%.3f,%.3f\n", frame, seconds * 1000.0, latencySeconds * 1000.0);
+}
+
+void InputRecorder::finish(GLuint frame)
+{
+    if (_mode == Mode::RECORD)
+    {
+        InputEvent event;
+        event.frame = frame;
+        event.type = END_EVENT;
+        event.input[0] = 0;
+        event.input[1] = 0;
+        fwrite(&event, sizeof(InputEvent), 1, _pLogFile);
+        fclose(_pLogFile);
+        _pLogFile = nullptr;
+        fprintf(stdout, "[INFO]: input recording ended on frame %u\n", frame);
+    }
+    if (_pFrameTimeFile)
+    {
+        fclose(_pFrameTimeFile);
+        _pFrameTimeFile = nullptr;
+    }
+    _mode = Mode::OFF;
+}
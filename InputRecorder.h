@@ -0,0 +1,137 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <glad/gl.h>
+
+#include <cstdio>
+#include <vector>
+
+/// \class InputRecorder
+/// \desc Records every input event the engine handles to a compact binary log, and plays a log
+/// back.  Events are stamped with the simulation frame they arrived on rather than wall clock
+/// time, and every frame's simulation time and step are logged with them, so a replay drives
+/// the simulation through exactly the same states however fast it runs.
+/// Optionally writes the duration of every frame to a CSV file so replays of the same session
+/// can be compared frame for frame across builds
+class InputRecorder {
+public:
+    /// \desc what the recorder is doing this session
+    enum class Mode {
+        /// \desc input is neither logged nor replayed
+        OFF,
+        /// \desc live input is logged
+        RECORD,
+        /// \desc live input is ignored and the log is played back
+        REPLAY
+    };
+
+    /// \desc kind of input an event carries
+    enum EventType : GLuint {
+        KEY_EVENT = 0,
+        MOUSE_BUTTON_EVENT = 1,
+        CURSOR_POSITION_EVENT = 2,
+        /// \desc last entry of a finished log, its frame is the number of frames recorded
+        END_EVENT = 3,
+        /// \desc simulation time and step of a frame, logged after the frame's input
+        FRAME_EVENT = 4
+    };
+
+    /// \desc one 16 byte log entry
+    struct InputEvent {
+        /// \desc simulation frame the event arrived on
+        GLuint frame;
+        /// \desc one of EventType
+        GLuint type;
+        union {
+            /// \desc key or mouse button and its GLFW action
+            GLint input[2];
+            /// \desc cursor position in window coordinates
+            GLfloat position[2];
+            /// \desc seconds since the ride started and seconds since the previous frame
+            GLfloat timing[2];
+        };
+    };
+
+    InputRecorder();
+    /// \desc finishes any recording and closes open files
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    /// \desc starts logging input to a file
+    /// \param FILENAME log file to create
+    /// \returns false if the file could not be created
+    bool startRecording(const char* FILENAME);
+    /// \desc loads a log to play back
+    /// \param FILENAME log file to read
+    /// \returns false if the file is missing or not an input log
+    bool startReplay(const char* FILENAME);
+    /// \desc starts writing per frame timings to a CSV file
+    /// \param FILENAME CSV file to create
+    /// \returns false if the file could not be created
+    bool startFrameTimeLog(const char* FILENAME);
+
+    /// \desc window size the log was recorded at, written when recording starts
+    /// \param width window width in screen coordinates
+    /// \param height window height in screen coordinates
+    void setWindowSize(GLint width, GLint height);
+    /// \desc window size stored in the log being replayed
+    void getWindowSize(GLint& width, GLint& height) const;
+
+    /// \desc logs a key or mouse button event
+    void recordInput(GLuint frame, EventType type, GLint code, GLint action);
+    /// \desc logs a cursor movement
+    void recordCursor(GLuint frame, GLfloat x, GLfloat y);
+    /// \desc logs the clock a frame is simulated with, which a replay uses instead of its own
+    /// \param frame simulation frame
+    /// \param simulationTime seconds since the ride started
+    /// \param step seconds since the previous frame
+    void recordFrame(GLuint frame, GLfloat simulationTime, GLfloat step);
+
+    /// \desc takes the next replayed event due on or before a frame
+    /// \param frame current simulation frame
+    /// \param [out] event next event
+    /// \returns false once every event due this frame has been returned
+    bool nextEvent(GLuint frame, InputEvent& event);
+    /// \desc true once a replay has reached the frame its recording ended on
+    [[nodiscard]] bool isReplayFinished(GLuint frame) const;
+
+    /// \desc appends a frame's duration to the frame time log, if one is open
+    /// \param frame simulation frame that finished
+    /// \param seconds wall clock time the frame took
+    /// \param latencySeconds time from sampling the frame's input until it was drawn
+    void recordFrameTime(GLuint frame, double seconds, double latencySeconds);
+
+    /// \desc ends a recording, marking the final frame
+    /// \param frame simulation frame the session ended on
+    void finish(GLuint frame);
+
+    [[nodiscard]] Mode getMode() const { return _mode; }
+
+private:
+    /// \desc layout of the log file header, followed by InputEvent records
+    struct Header {
+        char magic[4];
+        GLuint version;
+        GLint windowWidth;
+        GLint windowHeight;
+    };
+    /// \desc bump whenever the log layout changes, or the frame an event takes effect on.
+    /// Version 2 applies events before the simulation step of the frame they arrive on, version 3
+    /// logs every frame's simulation time and step
+    static constexpr GLuint LOG_VERSION = 3;
+
+    Mode _mode;
+    FILE* _pLogFile;
+    FILE* _pFrameTimeFile;
+    Header _header;
+
+    /// \desc events loaded for replay and the next one to hand out
+    std::vector<InputEvent> _events;
+    size_t _nextEvent;
+    /// \desc frame the replayed recording ended on
+    GLuint _endFrame;
+};
+
+#endif // INPUT_RECORDER_H
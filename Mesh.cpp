@@ -0,0 +1,481 @@
+#include "Mesh.h"
+
+#include <sys/stat.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+//*************************************************************************************
+//
+// Helper Functions
+
+namespace {
+    /// \desc size of the simulated FIFO/LRU post-transform cache used to score vertices
+    constexpr int VERTEX_CACHE_SIZE = 32;
+
+    /// \desc Forsyth vertex score: favors vertices recently used and vertices with few remaining triangles
+    /// \param cachePosition position of the vertex in the simulated cache, -1 if not in the cache
+    /// \param remainingTriangles number of triangles still to be emitted that use the vertex
+    float forsythVertexScore(const int cachePosition, const int remainingTriangles) {
+        if (remainingTriangles == 0) return -1.0f;
+
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                // the last triangle's vertices get a fixed score so it is not simply repeated
+                score = 0.75f;
+            } else {
+                const float scaler = 1.0f - (float)(cachePosition - 3) / (float)(VERTEX_CACHE_SIZE - 3);
+                score = powf(scaler, 1.5f);
+            }
+        }
+        // bonus for vertices with few triangles left so they are finished off early
+        score += 2.0f * powf((float)remainingTriangles, -0.5f);
+        return score;
+    }
+
+    /// \desc key used to weld OBJ face corners into unique vertices
+    struct WeldKey {
+        float values[5];
+        bool operator==(const WeldKey& other) const { return memcmp(values, other.values, sizeof(values)) == 0; }
+    };
+    struct WeldKeyHash {
+        size_t operator()(const WeldKey& key) const {
+            size_t hash = 14695981039346656037ull;
+            const auto* bytes = reinterpret_cast<const unsigned char*>(key.values);
+            for (size_t i = 0; i < sizeof(key.values); i++) {
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+            }
+            return hash;
+        }
+    };
+
+    /// \desc resolves a 1-based (or negative, relative) OBJ index to a 0-based index
+    long resolveOBJIndex(const long index, const size_t count) {
+        return index < 0 ? (long)count + index : index - 1;
+    }
+
+    /// \desc last modification time of a file in nanoseconds, or -1 if it does not exist.  Where
+    /// the platform only reports whole seconds the nanoseconds are 0
+    long long fileModificationTime(const char* FILENAME) {
+        struct stat fileStats{};
+        if (stat(FILENAME, &fileStats) != 0) return -1;
+#if defined(__APPLE__)
+        return (long long)fileStats.st_mtimespec.tv_sec * 1000000000LL + fileStats.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+        return (long long)fileStats.st_mtim.tv_sec * 1000000000LL + fileStats.st_mtim.tv_nsec;
+#else
+        return (long long)fileStats.st_mtime * 1000000000LL;
+#endif
+    }
+}
+
+//*************************************************************************************
+//
+// Public Interface
+
+Mesh::Mesh()
+    : _vao(0), _vbo(0), _ibo(0),
+      _numVertices(0), _numIndices(0),
+      _indexType(GL_UNSIGNED_INT) {
+
+}
+
+Mesh::~Mesh() {
+    if (_vao != 0) {
+        glDeleteVertexArrays(1, &_vao);
+        glDeleteBuffers(1, &_vbo);
+        glDeleteBuffers(1, &_ibo);
+    }
+}
+
+bool Mesh::loadModelFile(const char* FILENAME) {
+    const std::string cacheFilename = std::string(FILENAME) + ".mesh";
+
+    // use the cache if it was written after the source OBJ was last touched.  Strictly after, so
+    // an OBJ saved within the same tick as its cache, which whole second clocks make likely, is
+    // imported again rather than trusted
+    const long long objTime = fileModificationTime(FILENAME);
+    const long long cacheTime = fileModificationTime(cacheFilename.c_str());
+    if (cacheTime >= 0 && cacheTime > objTime) {
+        if (_loadCache(cacheFilename.c_str())) {
+            fprintf(stdout, "[INFO]: Loaded mesh cache \"%s\" with %d vertices & %d indices\n", cacheFilename.c_str(), _numVertices, _numIndices);
+            return true;
+        }
+        fprintf(stderr, "[WARN]: Mesh cache \"%s\" is invalid, re-importing \"%s\"\n", cacheFilename.c_str(), FILENAME);
+    }
+
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    if (!importOBJ(FILENAME, vertices, indices)) {
+        return false;
+    }
+    optimizeVertexCache(indices, (GLuint)vertices.size());
+    optimizeVertexFetch(vertices, indices);
+
+    _bounds = VertexFormat::computeBounds(&vertices[0].position, vertices.size(), sizeof(Vertex));
+    std::vector<PackedVertex> packedVertices;
+    packedVertices.reserve(vertices.size());
+    for (const Vertex& vertex : vertices) {
+        packedVertices.push_back(VertexFormat::pack(vertex.position, vertex.normal, vertex.texCoord, _bounds));
+    }
+
+    if (!_writeCache(cacheFilename.c_str(), packedVertices, indices, _bounds)) {
+        fprintf(stderr, "[WARN]: Could not write mesh cache \"%s\"\n", cacheFilename.c_str());
+    }
+
+    if (packedVertices.size() <= 0xFFFF) {
+        std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+        _upload(packedVertices.data(), (GLsizei)packedVertices.size(), shortIndices.data(), (GLsizei)shortIndices.size(), sizeof(GLushort));
+    } else {
+        _upload(packedVertices.data(), (GLsizei)packedVertices.size(), indices.data(), (GLsizei)indices.size(), sizeof(GLuint));
+    }
+    fprintf(stdout, "[INFO]: Imported \"%s\" with %d vertices & %d indices\n", FILENAME, _numVertices, _numIndices);
+    return true;
+}
+
+void Mesh::setAttributeLocations(const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation) const {
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    VertexFormat::setAttributeLocations(positionLocation, normalLocation, texCoordLocation);
+}
+
+bool Mesh::draw() const {
+    if (_vao == 0) return false;
+
+    glBindVertexArray(_vao);
+    glDrawElements(GL_TRIANGLES, _numIndices, _indexType, (void*)0);
+    return true;
+}
+
+//*************************************************************************************
+//
+// Import Pipeline
+
+bool Mesh::importOBJ(const char* FILENAME, std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    FILE* file = fopen(FILENAME, "r");
+    if (!file) {
+        fprintf(stderr, "[ERROR]: Could not open \"%s\"\n", FILENAME);
+        return false;
+    }
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> texCoords;
+    std::unordered_map<WeldKey, GLuint, WeldKeyHash> weldedVertices;
+    // every unique vertex remembers which position it came from so normals are shared across UV seams
+    std::vector<GLuint> vertexPositionIndex;
+
+    vertices.clear();
+    indices.clear();
+
+    char line[1024];
+    std::vector<GLuint> faceCorners;
+    while (fgets(line, sizeof(line), file)) {
+        if (line[0] == 'v' && line[1] == ' ') {
+            glm::vec3 position;
+            if (sscanf(line + 2, "%f %f %f", &position.x, &position.y, &position.z) == 3) {
+                positions.push_back(position);
+            }
+        } else if (line[0] == 'v' && line[1] == 't') {
+            glm::vec2 texCoord;
+            if (sscanf(line + 3, "%f %f", &texCoord.x, &texCoord.y) == 2) {
+                texCoords.push_back(texCoord);
+            }
+        } else if (line[0] == 'f' && line[1] == ' ') {
+            faceCorners.clear();
+            char* cursor = line + 2;
+            while (*cursor != '\0') {
+                char* end;
+                const long positionIndex = strtol(cursor, &end, 10);
+                if (end == cursor) break;
+                cursor = end;
+
+                long texCoordIndex = 0;
+                if (*cursor == '/') {
+                    cursor++;
+                    texCoordIndex = strtol(cursor, &end, 10);
+                    cursor = end;
+                    // skip the normal index, normals are regenerated
+                    if (*cursor == '/') {
+                        strtol(cursor + 1, &end, 10);
+                        cursor = end;
+                    }
+                }
+                while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n') cursor++;
+
+                const long p = resolveOBJIndex(positionIndex, positions.size());
+                const long t = texCoordIndex == 0 ? -1 : resolveOBJIndex(texCoordIndex, texCoords.size());
+                if (p < 0 || p >= (long)positions.size() || t >= (long)texCoords.size()) {
+                    fprintf(stderr, "[ERROR]: Invalid face index in \"%s\"\n", FILENAME);
+                    fclose(file);
+                    return false;
+                }
+
+                WeldKey key{};
+                key.values[0] = positions[p].x;
+                key.values[1] = positions[p].y;
+                key.values[2] = positions[p].z;
+                key.values[3] = t < 0 ? 0.0f : texCoords[t].x;
+                key.values[4] = t < 0 ? 0.0f : texCoords[t].y;
+
+                auto welded = weldedVertices.find(key);
+                if (welded == weldedVertices.end()) {
+                    const GLuint newIndex = (GLuint)vertices.size();
+                    vertices.push_back({positions[p], glm::vec3(0.0f), glm::vec2(key.values[3], key.values[4])});
+                    vertexPositionIndex.push_back((GLuint)p);
+                    welded = weldedVertices.emplace(key, newIndex).first;
+                }
+                faceCorners.push_back(welded->second);
+            }
+
+            // triangulate the polygon as a fan
+            for (size_t i = 2; i < faceCorners.size(); i++) {
+                indices.push_back(faceCorners[0]);
+                indices.push_back(faceCorners[i - 1]);
+                indices.push_back(faceCorners[i]);
+            }
+        }
+    }
+    fclose(file);
+
+    if (indices.empty()) {
+        fprintf(stderr, "[ERROR]: \"%s\" contains no faces\n", FILENAME);
+        return false;
+    }
+
+    // accumulate area weighted face normals per source position, then normalize per vertex
+    std::vector<glm::vec3> positionNormals(positions.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        const glm::vec3& a = vertices[indices[i]].position;
+        const glm::vec3& b = vertices[indices[i + 1]].position;
+        const glm::vec3& c = vertices[indices[i + 2]].position;
+        const glm::vec3 faceNormal = glm::cross(b - a, c - a);
+        for (size_t j = 0; j < 3; j++) {
+            positionNormals[vertexPositionIndex[indices[i + j]]] += faceNormal;
+        }
+    }
+    for (size_t i = 0; i < vertices.size(); i++) {
+        const glm::vec3 normal = positionNormals[vertexPositionIndex[i]];
+        const float length = glm::length(normal);
+        vertices[i].normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    return true;
+}
+
+void Mesh::optimizeVertexCache(std::vector<GLuint>& indices, const GLuint numVertices) {
+    const size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0) return;
+
+    // build vertex -> triangle adjacency in a single flat array
+    std::vector<GLuint> remainingValence(numVertices, 0);
+    for (const GLuint index : indices) remainingValence[index]++;
+
+    std::vector<GLuint> adjacencyOffset(numVertices + 1, 0);
+    for (GLuint v = 0; v < numVertices; v++) adjacencyOffset[v + 1] = adjacencyOffset[v] + remainingValence[v];
+
+    std::vector<GLuint> adjacency(indices.size());
+    std::vector<GLuint> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = (GLuint)(i / 3);
+
+    std::vector<int> cachePosition(numVertices, -1);
+    std::vector<float> vertexScore(numVertices);
+    for (GLuint v = 0; v < numVertices; v++) vertexScore[v] = forsythVertexScore(-1, (int)remainingValence[v]);
+
+    std::vector<float> triangleScore(numTriangles);
+    std::vector<bool> triangleEmitted(numTriangles, false);
+    for (size_t t = 0; t < numTriangles; t++) {
+        triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+    }
+
+    std::vector<GLuint> cache;
+    std::vector<GLuint> newCache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    newCache.reserve(VERTEX_CACHE_SIZE + 3);
+
+    std::vector<GLuint> optimized;
+    optimized.reserve(indices.size());
+
+    long bestTriangle = -1;
+    size_t scanStart = 0;
+    for (size_t emitted = 0; emitted < numTriangles; emitted++) {
+        if (bestTriangle < 0) {
+            // nothing in the cache touches a remaining triangle; fall back to a scan
+            float bestScore = -1.0f;
+            for (size_t t = scanStart; t < numTriangles; t++) {
+                if (triangleEmitted[t]) {
+                    if (t == scanStart) scanStart++;
+                    continue;
+                }
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = (long)t;
+                }
+            }
+        }
+
+        const size_t triangle = (size_t)bestTriangle;
+        triangleEmitted[triangle] = true;
+
+        // emit the triangle and remove it from its vertices' adjacency lists
+        newCache.clear();
+        for (size_t i = 0; i < 3; i++) {
+            const GLuint v = indices[3 * triangle + i];
+            optimized.push_back(v);
+            newCache.push_back(v);
+
+            const GLuint begin = adjacencyOffset[v];
+            const GLuint end = begin + remainingValence[v];
+            for (GLuint j = begin; j < end; j++) {
+                if (adjacency[j] == triangle) {
+                    adjacency[j] = adjacency[end - 1];
+                    break;
+                }
+            }
+            remainingValence[v]--;
+        }
+
+        // the emitted triangle's vertices move to the front of the LRU cache
+        for (const GLuint v : cache) {
+            if (v != newCache[0] && v != newCache[1] && v != newCache[2]) newCache.push_back(v);
+        }
+        for (size_t i = 0; i < newCache.size(); i++) {
+            cachePosition[newCache[i]] = i < (size_t)VERTEX_CACHE_SIZE ? (int)i : -1;
+        }
+        for (const GLuint v : newCache) {
+            vertexScore[v] = forsythVertexScore(cachePosition[v], (int)remainingValence[v]);
+        }
+
+        // rescore only the triangles touching cached vertices and pick the next best among them
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (const GLuint v : newCache) {
+            const GLuint begin = adjacencyOffset[v];
+            const GLuint end = begin + remainingValence[v];
+            for (GLuint j = begin; j < end; j++) {
+                const GLuint t = adjacency[j];
+                triangleScore[t] = vertexScore[indices[3 * t]] + vertexScore[indices[3 * t + 1]] + vertexScore[indices[3 * t + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = (long)t;
+                }
+            }
+        }
+
+        if (newCache.size() > (size_t)VERTEX_CACHE_SIZE) newCache.resize(VERTEX_CACHE_SIZE);
+        cache.swap(newCache);
+    }
+
+    indices.swap(optimized);
+}
+
+void Mesh::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    constexpr GLuint UNMAPPED = 0xFFFFFFFFu;
+    std::vector<GLuint> remap(vertices.size(), UNMAPPED);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (GLuint& index : indices) {
+        if (remap[index] == UNMAPPED) {
+            remap[index] = (GLuint)reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    // unreferenced vertices are dropped
+    vertices.swap(reordered);
+}
+
+//*************************************************************************************
+//
+// Binary Cache
+
+bool Mesh::_writeCache(const char* FILENAME, const std::vector<PackedVertex>& vertices, const std::vector<GLuint>& indices, const PositionBounds& bounds) {
+    FILE* file = fopen(FILENAME, "wb");
+    if (!file) return false;
+
+    const bool shortIndices = vertices.size() <= 0xFFFF;
+    const CacheHeader header = {
+        {'F', 'P', 'M', 'S'}, CACHE_VERSION,
+        (GLuint)vertices.size(), (GLuint)indices.size(),
+        (GLuint)(shortIndices ? sizeof(GLushort) : sizeof(GLuint)),
+        {bounds.origin.x, bounds.origin.y, bounds.origin.z},
+        {bounds.extent.x, bounds.extent.y, bounds.extent.z}
+    };
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    success = success && fwrite(vertices.data(), sizeof(PackedVertex), vertices.size(), file) == vertices.size();
+    if (shortIndices) {
+        const std::vector<GLushort> packed(indices.begin(), indices.end());
+        success = success && fwrite(packed.data(), sizeof(GLushort), packed.size(), file) == packed.size();
+    } else {
+        success = success && fwrite(indices.data(), sizeof(GLuint), indices.size(), file) == indices.size();
+    }
+    fclose(file);
+
+    if (!success) remove(FILENAME);
+    return success;
+}
+
+bool Mesh::_loadCache(const char* FILENAME) {
+    FILE* file = fopen(FILENAME, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    const long fileSize = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fileSize < (long)sizeof(CacheHeader)) {
+        fclose(file);
+        return false;
+    }
+
+    // the whole file comes in with one read; vertices and indices are uploaded straight from it
+    std::vector<char> contents((size_t)fileSize);
+    const bool readAll = fread(contents.data(), 1, contents.size(), file) == contents.size();
+    fclose(file);
+    if (!readAll) return false;
+
+    CacheHeader header{};
+    memcpy(&header, contents.data(), sizeof(header));
+    const size_t vertexBytes = (size_t)header.numVertices * sizeof(PackedVertex);
+    const size_t indexBytes = (size_t)header.numIndices * header.indexSize;
+    if (memcmp(header.magic, "FPMS", 4) != 0
+        || header.version != CACHE_VERSION
+        || (header.indexSize != sizeof(GLushort) && header.indexSize != sizeof(GLuint))
+        || sizeof(CacheHeader) + vertexBytes + indexBytes != contents.size()) {
+        return false;
+    }
+
+    _bounds.origin = glm::vec3(header.boundsOrigin[0], header.boundsOrigin[1], header.boundsOrigin[2]);
+    _bounds.extent = glm::vec3(header.boundsExtent[0], header.boundsExtent[1], header.boundsExtent[2]);
+
+    const char* vertexData = contents.data() + sizeof(CacheHeader);
+    _upload(reinterpret_cast<const PackedVertex*>(vertexData), (GLsizei)header.numVertices,
+            vertexData + vertexBytes, (GLsizei)header.numIndices, (GLsizei)header.indexSize);
+    return true;
+}
+
+void Mesh::_upload(const PackedVertex* vertexData, const GLsizei numVertices, const void* indexData, const GLsizei numIndices, const GLsizei indexSize) {
+    if (_vao == 0) {
+        glGenVertexArrays(1, &_vao);
+        glGenBuffers(1, &_vbo);
+        glGenBuffers(1, &_ibo);
+    }
+
+    glBindVertexArray(_vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)numVertices * (GLsizeiptr)sizeof(PackedVertex), vertexData, GL_STATIC_DRAW);
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)numIndices * indexSize, indexData, GL_STATIC_DRAW);
+
+    _numVertices = numVertices;
+    _numIndices = numIndices;
+    _indexType = indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
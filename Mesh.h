@@ -0,0 +1,107 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include "VertexFormat.h"
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class Mesh
+/// \desc Indexed triangle mesh imported from an OBJ file.  The import pipeline welds
+/// duplicate vertices, generates smooth normals, reorders triangles for the post-transform
+/// vertex cache and reorders vertices for fetch locality.  The result is written to a
+/// binary cache next to the OBJ so later launches load it with a single read.  Vertices are
+/// stored on disk and on the GPU as PackedVertex relative to the mesh bounds.
+class Mesh {
+public:
+    /// \desc full precision vertex layout used while importing
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+    };
+
+    /// \desc creates an empty mesh with no GPU resources
+    Mesh();
+    /// \desc releases the GPU resources owned by the mesh
+    ~Mesh();
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    /// \desc loads a model, preferring the binary cache when it is at least as new as the OBJ
+    /// \param FILENAME OBJ file to load
+    /// \returns true if the mesh was loaded and uploaded to the GPU
+    bool loadModelFile(const char* FILENAME);
+
+    /// \desc points the mesh VAO at the given shader attribute locations
+    /// \param positionLocation attribute location for the vertex position
+    /// \param normalLocation attribute location for the vertex normal (-1 to skip)
+    /// \param texCoordLocation attribute location for the texture coordinate (-1 to skip)
+    void setAttributeLocations(GLint positionLocation, GLint normalLocation = -1, GLint texCoordLocation = -1) const;
+
+    /// \desc draws the mesh with the currently bound shader program
+    /// \note the caller must send getPositionBounds() as the position decode first
+    /// \returns false if the mesh has not been loaded
+    bool draw() const;
+
+    /// \desc number of unique vertices after welding
+    [[nodiscard]] GLsizei getNumVertices() const { return _numVertices; }
+    /// \desc number of indices making up the triangle list
+    [[nodiscard]] GLsizei getNumIndices() const { return _numIndices; }
+    /// \desc box the packed vertex positions are quantized against
+    [[nodiscard]] const PositionBounds& getPositionBounds() const { return _bounds; }
+
+    /// \desc parses an OBJ file into a welded, indexed triangle list with generated normals
+    /// \param FILENAME OBJ file to parse
+    /// \param [out] vertices unique vertices
+    /// \param [out] indices triangle list indices
+    /// \returns true on success
+    static bool importOBJ(const char* FILENAME, std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+    /// \desc reorders triangles to maximize post-transform vertex cache hits (Forsyth's linear-speed algorithm)
+    /// \param [in,out] indices triangle list indices
+    /// \param numVertices number of vertices referenced by the index list
+    static void optimizeVertexCache(std::vector<GLuint>& indices, GLuint numVertices);
+
+    /// \desc reorders vertices into the order they are first referenced by the index list
+    /// \param [in,out] vertices vertex array to reorder
+    /// \param [in,out] indices triangle list indices to remap
+    static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+private:
+    /// \desc layout of the binary cache file header, followed by packed vertices then indices
+    struct CacheHeader {
+        char magic[4];
+        GLuint version;
+        GLuint numVertices;
+        GLuint numIndices;
+        GLuint indexSize;
+        GLfloat boundsOrigin[3];
+        GLfloat boundsExtent[3];
+    };
+    /// \desc bump whenever the cache layout or import pipeline changes
+    static constexpr GLuint CACHE_VERSION = 2;
+
+    /// \desc writes packed vertices and indices to a binary cache file
+    static bool _writeCache(const char* FILENAME, const std::vector<PackedVertex>& vertices, const std::vector<GLuint>& indices, const PositionBounds& bounds);
+    /// \desc reads a binary cache file with one read and uploads it
+    bool _loadCache(const char* FILENAME);
+    /// \desc uploads packed vertices and indices to the GPU
+    void _upload(const PackedVertex* vertexData, GLsizei numVertices, const void* indexData, GLsizei numIndices, GLsizei indexSize);
+
+    GLuint _vao;
+    GLuint _vbo;
+    GLuint _ibo;
+    GLsizei _numVertices;
+    GLsizei _numIndices;
+    /// \desc GL_UNSIGNED_SHORT when every index fits in 16 bits, otherwise GL_UNSIGNED_INT
+    GLenum _indexType;
+    /// \desc decode box for the packed positions
+    PositionBounds _bounds;
+};
+
+#endif // MESH_H
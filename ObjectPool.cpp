@@ -0,0 +1,59 @@
+#include "ObjectPool.h"
+
+#include <algorithm>
+
+ObjectPool::ObjectPool(const size_t blockSize)
+    : _blockSize(blockSize),
+      _used(0),
+      _capacity(0),
+      _reservedBytes(0)
+{
+}
+
+ObjectPool::~ObjectPool()
+{
+    clear();
+}
+
+void ObjectPool::destroy(const void* pObject)
+{
+    if (!pObject) return;
+    for (Entry& entry : _objects) {
+        if (entry.pObject == pObject) {
+            entry.destroy(entry.pObject);
+            entry.pObject = nullptr;
+            return;
+        }
+    }
+}
+
+void ObjectPool::clear()
+{
+    for (auto it = _objects.rbegin(); it != _objects.rend(); ++it) {
+        if (it->pObject) it->destroy(it->pObject);
+    }
+    _objects.clear();
+    _blocks.clear();
+    _used = 0;
+    _capacity = 0;
+    _reservedBytes = 0;
+}
+
+size_t ObjectPool::getNumObjects() const
+{
+    return std::count_if(_objects.begin(), _objects.end(), [](const Entry& entry) { return entry.pObject != nullptr; });
+}
+
+void* ObjectPool::_allocate(const size_t bytes, const size_t alignment)
+{
+    // new[] aligns each block for any fundamental type, offsets inside it only need rounding up
+    size_t offset = (_used + alignment - 1) & ~(alignment - 1);
+    if (_blocks.empty() || offset + bytes > _capacity) {
+        _capacity = std::max(_blockSize, bytes);
+        _blocks.emplace_back(new unsigned char[_capacity]);
+        _reservedBytes += _capacity;
+        offset = 0;
+    }
+    _used = offset + bytes;
+    return _blocks.back().get() + offset;
+}
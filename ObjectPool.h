@@ -0,0 +1,69 @@
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/// \class ObjectPool
+/// \desc Home for objects that live as long as the engine, such as its cameras and render
+/// subsystems.  Objects of any type are constructed in place in large blocks instead of each
+/// getting its own heap allocation, and every object still alive when the pool is cleared or
+/// destroyed is destroyed in the reverse order it was created, so nothing the engine created
+/// can leak.  Destroying an object early runs its destructor, its storage is only reclaimed
+/// with the rest of the pool
+class ObjectPool {
+public:
+    /// \desc creates an empty pool, its first block is allocated by the first create()
+    /// \param blockSize bytes per block, larger objects get a block of their own
+    explicit ObjectPool(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    /// \desc destroys every object still alive
+    ~ObjectPool();
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    /// \desc constructs an object in the pool
+    /// \returns the object, owned by the pool
+    template<typename T, typename... Args>
+    T* create(Args&&... args) {
+        void* pStorage = _allocate(sizeof(T), alignof(T));
+        T* pObject = new (pStorage) T(std::forward<Args>(args)...);
+        _objects.push_back({ pObject, [](void* p) { static_cast<T*>(p)->~T(); } });
+        return pObject;
+    }
+    /// \desc destroys an object created by this pool before the pool is cleared, null is ignored
+    /// \param pObject object to destroy
+    void destroy(const void* pObject);
+    /// \desc destroys every object still alive, newest first, and releases the blocks
+    void clear();
+
+    /// \desc number of objects alive
+    [[nodiscard]] size_t getNumObjects() const;
+    /// \desc bytes of every block the pool holds
+    [[nodiscard]] size_t getReservedBytes() const { return _reservedBytes; }
+
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 16 * 1024;
+
+private:
+    /// \desc an object and how to destroy it, destroyed objects keep their entry with a null object
+    struct Entry {
+        void* pObject;
+        void (*destroy)(void*);
+    };
+
+    void* _allocate(size_t bytes, size_t alignment);
+
+    size_t _blockSize;
+    std::vector<std::unique_ptr<unsigned char[]>> _blocks;
+    /// \desc bytes used of the newest block
+    size_t _used;
+    /// \desc capacity of the newest block
+    size_t _capacity;
+    size_t _reservedBytes;
+    std::vector<Entry> _objects;
+};
+
+#endif // OBJECT_POOL_H
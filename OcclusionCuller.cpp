@@ -0,0 +1,182 @@
+#include "OcclusionCuller.h"
+
+#include <algorithm>
+#include <cmath>
+
+OcclusionCuller::OcclusionCuller()
+    : _viewProjMtx(1.0f),
+      _levelOffsets{},
+      _numTested(0),
+      _numCulled(0)
+{
+    GLuint size = 0;
+    for (GLuint level = 0; level < NUM_LEVELS; level++) {
+        _levelOffsets[level] = size;
+        size += (WIDTH >> level) * (HEIGHT >> level);
+    }
+    _depths.assign(size, 1.0f);
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjMtx)
+{
+    _viewProjMtx = viewProjMtx;
+    std::fill(_depths.begin(), _depths.begin() + WIDTH * HEIGHT, 1.0f);
+    _numTested = 0;
+    _numCulled = 0;
+}
+
+void OcclusionCuller::rasterizeTriangle(const glm::vec3 a, const glm::vec3 b, const glm::vec3 c)
+{
+    // clip against the near plane, z >= -w, which leaves at most a quad
+    const glm::vec4 triangle[3] = {_viewProjMtx * glm::vec4(a, 1.0f), _viewProjMtx * glm::vec4(b, 1.0f), _viewProjMtx * glm::vec4(c, 1.0f)};
+    glm::vec4 clipped[4];
+    GLuint numClipped = 0;
+    for (GLuint i = 0; i < 3; i++) {
+        const glm::vec4& current = triangle[i];
+        const glm::vec4& next = triangle[(i + 1) % 3];
+        const GLfloat currentDistance = current.z + current.w;
+        const GLfloat nextDistance = next.z + next.w;
+        if (currentDistance >= 0.0f) clipped[numClipped++] = current;
+        if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f)) {
+            clipped[numClipped++] = glm::mix(current, next, currentDistance / (currentDistance - nextDistance));
+        }
+    }
+    if (numClipped < 3) return;
+
+    glm::vec3 screen[4];
+    for (GLuint i = 0; i < numClipped; i++) {
+        if (clipped[i].w <= 0.0f) return;
+        const glm::vec3 ndc = glm::vec3(clipped[i]) / clipped[i].w;
+        screen[i] = glm::vec3((ndc.x * 0.5f + 0.5f) * WIDTH, (ndc.y * 0.5f + 0.5f) * HEIGHT, ndc.z * 0.5f + 0.5f);
+    }
+    _fillTriangle(screen[0], screen[1], screen[2]);
+    if (numClipped == 4) _fillTriangle(screen[0], screen[2], screen[3]);
+}
+
+void OcclusionCuller::rasterizeHeightGrid(const glm::vec2 origin, const GLfloat size, const GLuint cells, const GLfloat* heights)
+{
+    const GLfloat spacing = size / cells;
+    for (GLuint row = 0; row < cells; row++) {
+        for (GLuint column = 0; column < cells; column++) {
+            const GLuint v = row * (cells + 1) + column;
+            const GLfloat x = origin.x + column * spacing;
+            const GLfloat z = origin.y + row * spacing;
+            const glm::vec3 corners[4] = {
+                {x, heights[v], z}, {x + spacing, heights[v + 1], z},
+                {x, heights[v + cells + 1], z + spacing}, {x + spacing, heights[v + cells + 2], z + spacing}
+            };
+            rasterizeTriangle(corners[0], corners[2], corners[1]);
+            rasterizeTriangle(corners[1], corners[2], corners[3]);
+        }
+    }
+}
+
+void OcclusionCuller::buildPyramid()
+{
+    for (GLuint level = 1; level < NUM_LEVELS; level++) {
+        const GLuint width = WIDTH >> level;
+        const GLuint height = HEIGHT >> level;
+        const GLfloat* below = _depths.data() + _levelOffsets[level - 1];
+        GLfloat* above = _depths.data() + _levelOffsets[level];
+        for (GLuint y = 0; y < height; y++) {
+            for (GLuint x = 0; x < width; x++) {
+                const GLfloat* texels = below + 2 * y * (2 * width) + 2 * x;
+                above[y * width + x] = std::max(std::max(texels[0], texels[1]), std::max(texels[2 * width], texels[2 * width + 1]));
+            }
+        }
+    }
+}
+
+bool OcclusionCuller::isVisible(const glm::vec3 boxMin, const glm::vec3 boxMax) const
+{
+    _numTested++;
+
+    glm::vec4 corners[8];
+    GLuint outside[6] = {0, 0, 0, 0, 0, 0};
+    for (GLuint corner = 0; corner < 8; corner++) {
+        const glm::vec4 clip = _viewProjMtx * glm::vec4(corner & 1 ? boxMax.x : boxMin.x,
+                                                        corner & 2 ? boxMax.y : boxMin.y,
+                                                        corner & 4 ? boxMax.z : boxMin.z, 1.0f);
+        corners[corner] = clip;
+        outside[0] += clip.x < -clip.w;
+        outside[1] += clip.x > clip.w;
+        outside[2] += clip.y < -clip.w;
+        outside[3] += clip.y > clip.w;
+        outside[4] += clip.z < -clip.w;
+        outside[5] += clip.z > clip.w;
+    }
+
+    // outside the view if every corner is beyond the same clip plane
+    for (const GLuint numOutside : outside) {
+        if (numOutside == 8) {
+            _numCulled++;
+            return false;
+        }
+    }
+    // a box reaching behind the near plane surrounds the camera and is always drawn
+    if (outside[4] > 0) return true;
+
+    // screen rectangle and nearest depth of the corners
+    glm::vec2 screenMin(INFINITY), screenMax(-INFINITY);
+    GLfloat nearestDepth = INFINITY;
+    for (const glm::vec4& clip : corners) {
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        screenMin = glm::min(screenMin, glm::vec2(ndc.x, ndc.y));
+        screenMax = glm::max(screenMax, glm::vec2(ndc.x, ndc.y));
+        nearestDepth = std::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+    }
+
+    // pixels the box touches, grown by one to allow for occluder edges sampled at pixel centres
+    GLint left = std::max(static_cast<GLint>(floorf((screenMin.x * 0.5f + 0.5f) * WIDTH)) - 1, 0);
+    GLint bottom = std::max(static_cast<GLint>(floorf((screenMin.y * 0.5f + 0.5f) * HEIGHT)) - 1, 0);
+    GLint right = std::min(static_cast<GLint>(floorf((screenMax.x * 0.5f + 0.5f) * WIDTH)) + 1, static_cast<GLint>(WIDTH) - 1);
+    GLint top = std::min(static_cast<GLint>(floorf((screenMax.y * 0.5f + 0.5f) * HEIGHT)) + 1, static_cast<GLint>(HEIGHT) - 1);
+
+    GLuint level = 0;
+    while (level + 1 < NUM_LEVELS && (right - left >= MAX_TEST_TEXELS || top - bottom >= MAX_TEST_TEXELS)) {
+        level++;
+        left >>= 1;
+        bottom >>= 1;
+        right >>= 1;
+        top >>= 1;
+    }
+
+    const GLuint width = WIDTH >> level;
+    const GLfloat* depths = _depths.data() + _levelOffsets[level];
+    for (GLint y = bottom; y <= top; y++) {
+        for (GLint x = left; x <= right; x++) {
+            if (nearestDepth <= depths[y * width + x]) return true;
+        }
+    }
+    _numCulled++;
+    return false;
+}
+
+void OcclusionCuller::_fillTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+    const GLfloat area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    if (fabsf(area) < 1e-8f) return;
+
+    const GLint left = std::max(static_cast<GLint>(floorf(std::min({a.x, b.x, c.x}))), 0);
+    const GLint right = std::min(static_cast<GLint>(ceilf(std::max({a.x, b.x, c.x}))), static_cast<GLint>(WIDTH) - 1);
+    const GLint bottom = std::max(static_cast<GLint>(floorf(std::min({a.y, b.y, c.y}))), 0);
+    const GLint top = std::min(static_cast<GLint>(ceilf(std::max({a.y, b.y, c.y}))), static_cast<GLint>(HEIGHT) - 1);
+
+    // barycentric weights from edge functions, either winding
+    const GLfloat inverseArea = 1.0f / area;
+    for (GLint y = bottom; y <= top; y++) {
+        const GLfloat py = y + 0.5f;
+        for (GLint x = left; x <= right; x++) {
+            const GLfloat px = x + 0.5f;
+            const GLfloat wa = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) * inverseArea;
+            const GLfloat wb = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) * inverseArea;
+            const GLfloat wc = 1.0f - wa - wb;
+            if (wa < 0.0f || wb < 0.0f || wc < 0.0f) continue;
+
+            // depth beyond the far plane occludes nothing
+            const GLfloat depth = wa * a.z + wb * b.z + wc * c.z;
+            GLfloat& texel = _depths[y * WIDTH + x];
+            if (depth < texel) texel = depth;
+        }
+    }
+}
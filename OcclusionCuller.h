@@ -0,0 +1,69 @@
+#ifndef OCCLUSION_CULLER_H
+#define OCCLUSION_CULLER_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class OcclusionCuller
+/// \desc Software occlusion culling against a hierarchical Z pyramid.  Each frame the large
+/// occluders are rasterized on the CPU into a small depth buffer, keeping the nearest depth per
+/// pixel, and every level of the pyramid above it keeps the farthest depth of the 2x2 texels
+/// below.  A bounding box is hidden if its nearest point lies behind the pyramid everywhere its
+/// screen rectangle covers, which a level with at most a few texels across the rectangle
+/// answers in a handful of reads.  Boxes outside the view are rejected by the same test.
+/// Occluders must never be larger than what is drawn, or visible objects get culled.  Nothing
+/// here touches OpenGL, so the same results come out of replays and offline renders
+class OcclusionCuller {
+public:
+    /// \desc size of the depth buffer the occluders are rasterized into
+    static constexpr GLuint WIDTH = 256;
+    static constexpr GLuint HEIGHT = 128;
+
+    /// \desc allocates the pyramid
+    OcclusionCuller();
+
+    /// \desc clears the depth buffer for a new camera
+    /// \param viewProjMtx projection * view matrix of the camera to cull for
+    void beginFrame(const glm::mat4& viewProjMtx);
+    /// \desc rasterizes one world space occluder triangle, clipped against the near plane
+    void rasterizeTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c);
+    /// \desc rasterizes a square height grid as two triangles per cell
+    /// \param origin minimum x and z corner of the square
+    /// \param size length of the square's sides
+    /// \param cells cells along each side
+    /// \param heights (cells + 1) * (cells + 1) heights, row by row along x
+    void rasterizeHeightGrid(glm::vec2 origin, GLfloat size, GLuint cells, const GLfloat* heights);
+    /// \desc builds the pyramid from the rasterized occluders, call before testing
+    void buildPyramid();
+
+    /// \desc tests a world space axis aligned box against the occluders
+    /// \returns false if the box is outside the view or entirely behind the occluders
+    [[nodiscard]] bool isVisible(glm::vec3 boxMin, glm::vec3 boxMax) const;
+
+    /// \desc boxes tested and found hidden since beginFrame()
+    [[nodiscard]] GLuint getNumTested() const { return _numTested; }
+    [[nodiscard]] GLuint getNumCulled() const { return _numCulled; }
+
+private:
+    /// \desc fills the pixels whose centres a screen space triangle covers, keeping the nearest depth
+    /// \param a x and y in pixels, z the depth in [0, 1]
+    void _fillTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+    /// \desc levels down to 2 x 1 texels
+    static constexpr GLuint NUM_LEVELS = 8;
+    /// \desc a screen rectangle is tested at the first level it spans at most this many texels of
+    static constexpr GLint MAX_TEST_TEXELS = 4;
+
+    glm::mat4 _viewProjMtx;
+    /// \desc every level of the pyramid one after the other, level 0 at full resolution
+    std::vector<GLfloat> _depths;
+    GLuint _levelOffsets[NUM_LEVELS];
+
+    mutable GLuint _numTested;
+    mutable GLuint _numCulled;
+};
+
+#endif // OCCLUSION_CULLER_H
@@ -0,0 +1,145 @@
+#include "OfflineRender.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    bool isVideo(const std::string& filename) {
+        return filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".y4m") == 0;
+    }
+
+    /// \desc file a worker writes its frames of a video to
+    std::string segmentFilename(const std::string& output, const GLuint worker) {
+        return output + ".part" + std::to_string(worker);
+    }
+
+    /// \desc interleaves the workers' video segments back into frame order.  Segment w holds
+    /// frames w, w + numWorkers, ..., so frame k is the next frame of segment k % numWorkers
+    bool mergeSegments(const std::string& output, const GLuint numWorkers) {
+        std::vector<FILE*> segments(numWorkers, nullptr);
+        bool valid = true;
+        char header[256] = "";
+        GLuint numRendered = 0;
+        for (GLuint w = 0; w < numWorkers; w++) {
+            segments[w] = fopen(segmentFilename(output, w).c_str(), "rb");
+            valid = valid && segments[w];
+            if (!valid) continue;
+            // every segment starts with the same stream header, except that a lap shorter than
+            // the worker count leaves the last workers without a frame and their segments empty
+            char segmentHeader[256];
+            if (!fgets(segmentHeader, sizeof(segmentHeader), segments[w])) continue;
+            valid = numRendered == w;
+            if (w == 0) strcpy(header, segmentHeader);
+            valid = valid && strcmp(header, segmentHeader) == 0;
+            numRendered++;
+        }
+
+        GLint width = 0, height = 0;
+        const char* widthToken = strstr(header, " W");
+        const char* heightToken = strstr(header, " H");
+        valid = valid && widthToken && heightToken
+                && sscanf(widthToken, " W%d", &width) == 1 && sscanf(heightToken, " H%d", &height) == 1;
+
+        FILE* video = valid ? fopen(output.c_str(), "wb") : nullptr;
+        GLuint numFrames = 0;
+        if (video) {
+            const size_t frameSize = strlen("FRAME\n") + static_cast<size_t>(width) * height
+                                     + 2 * static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+            std::vector<char> frame(frameSize);
+            fputs(header, video);
+            while (fread(frame.data(), 1, frameSize, segments[numFrames % numRendered]) == frameSize) {
+                fwrite(frame.data(), 1, frameSize, video);
+                numFrames++;
+            }
+            valid = fclose(video) == 0;
+        } else {
+            fprintf(stderr, "[ERROR]: Could not merge the video segments of \"%s\"\n", output.c_str());
+            valid = false;
+        }
+
+        for (GLuint w = 0; w < numWorkers; w++) {
+            if (segments[w]) fclose(segments[w]);
+            if (valid) remove(segmentFilename(output, w).c_str());
+        }
+        if (valid) fprintf(stdout, "[INFO]: merged %u frames into \"%s\"\n", numFrames, output.c_str());
+        return valid;
+    }
+}
+
+bool OfflineRender::render(const Settings& settings, const RenderJob& renderJob)
+{
+    GLuint numWorkers = settings.numWorkers > 0 ? settings.numWorkers : std::thread::hardware_concurrency();
+    if (numWorkers == 0) numWorkers = 1;
+    if (settings.numFrames > 0 && numWorkers > settings.numFrames) numWorkers = settings.numFrames;
+#ifdef _WIN32
+    // no fork, render in this process
+    numWorkers = 1;
+#endif
+    const bool video = isVideo(settings.output);
+
+    std::vector<Job> jobs(numWorkers);
+    for (GLuint w = 0; w < numWorkers; w++) {
+        jobs[w].worker = w;
+        jobs[w].numWorkers = numWorkers;
+        jobs[w].numFrames = settings.numFrames;
+        jobs[w].width = settings.width;
+        jobs[w].height = settings.height;
+        jobs[w].framesPerSecond = settings.framesPerSecond;
+        jobs[w].output = video ? segmentFilename(settings.output, w) : settings.output;
+    }
+
+    fprintf(stdout, "[INFO]: rendering \"%s\" at %dx%d with %u worker%s\n", settings.output.c_str(),
+            settings.width, settings.height, numWorkers, numWorkers == 1 ? "" : "s");
+    const auto start = std::chrono::steady_clock::now();
+
+    bool succeeded = true;
+#ifdef _WIN32
+    succeeded = renderJob(jobs[0]);
+#else
+    // anything still buffered would otherwise be written once by every worker too
+    fflush(nullptr);
+    std::vector<pid_t> workers;
+    for (const Job& job : jobs) {
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // each worker gets one core; a multithreaded software rasterizer would otherwise
+            // start a thread per core in every worker
+            setenv("LP_NUM_THREADS", "1", 0);
+            const bool rendered = renderJob(job);
+            fflush(nullptr);
+            _exit(rendered ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+        if (pid < 0) {
+            fprintf(stderr, "[ERROR]: Could not start render worker %u\n", job.worker);
+            succeeded = false;
+            break;
+        }
+        workers.push_back(pid);
+    }
+    for (const pid_t pid : workers) {
+        int status = 0;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+            succeeded = false;
+        }
+    }
+#endif
+
+    if (!succeeded) {
+        fprintf(stderr, "[ERROR]: A render worker failed, \"%s\" is incomplete\n", settings.output.c_str());
+        return false;
+    }
+    if (video && !mergeSegments(settings.output, numWorkers)) return false;
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "[INFO]: offline render finished in %.2f s\n", seconds);
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef OFFLINE_RENDER_H
+#define OFFLINE_RENDER_H
+
+#include <glad/gl.h>
+
+#include <functional>
+#include <string>
+
+/// \desc Splits an offline render of the ride across worker processes.  Every worker is a
+/// fork of the launching process made before any GL context exists, so each creates its own
+/// hidden window and context and shares nothing with the others.  Frames are dealt out round
+/// robin, keeping the expensive stretches of the track spread over every worker.  A numbered
+/// PNG sequence is merged by its file names; a Y4M video is written as one segment per worker
+/// and interleaved back into frame order once every worker has finished
+namespace OfflineRender {
+    /// \desc what to render
+    struct Settings {
+        /// \desc a .y4m video, or a PNG name with a printf style frame number
+        std::string output;
+        /// \desc output resolution
+        GLint width = 1920;
+        GLint height = 1080;
+        /// \desc number of frames to render, 0 renders exactly one lap
+        GLuint numFrames = 0;
+        /// \desc worker processes to start, 0 starts one per core
+        GLuint numWorkers = 0;
+        /// \desc simulated frames per second, also the frame rate of a Y4M video
+        GLuint framesPerSecond = 60;
+    };
+
+    /// \desc the share of the frames one worker renders: worker, worker + numWorkers, ...
+    struct Job {
+        GLuint worker = 0;
+        GLuint numWorkers = 1;
+        /// \desc total frames across all workers, 0 for one lap
+        GLuint numFrames = 0;
+        GLint width = 1920;
+        GLint height = 1080;
+        GLuint framesPerSecond = 60;
+        /// \desc file the worker writes, its own segment when rendering a video
+        std::string output;
+    };
+
+    /// \desc renders one job in the calling process
+    /// \returns true if every frame of the job was written
+    typedef std::function<bool(const Job&)> RenderJob;
+
+    /// \desc runs the jobs in worker processes, waits for them and merges their output
+    /// \param settings what to render
+    /// \param renderJob called once in each worker with its job
+    /// \returns true if every worker succeeded and the output was merged
+    bool render(const Settings& settings, const RenderJob& renderJob);
+}
+
+#endif // OFFLINE_RENDER_H
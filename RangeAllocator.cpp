@@ -0,0 +1,78 @@
+#include "RangeAllocator.h"
+
+#include <algorithm>
+
+RangeAllocator::RangeAllocator()
+    : _capacity(0),
+      _used(0)
+{
+}
+
+void RangeAllocator::reset(const GLuint capacity)
+{
+    _capacity = capacity;
+    _used = 0;
+    _freeRanges.clear();
+    if (capacity > 0) _freeRanges.push_back({0, capacity});
+}
+
+void RangeAllocator::grow(const GLuint capacity)
+{
+    if (capacity <= _capacity) return;
+    if (!_freeRanges.empty() && _freeRanges.back().first + _freeRanges.back().count == _capacity) {
+        _freeRanges.back().count += capacity - _capacity;
+    } else {
+        _freeRanges.push_back({_capacity, capacity - _capacity});
+    }
+    _capacity = capacity;
+}
+
+RangeAllocator::Range RangeAllocator::allocate(const GLuint count)
+{
+    if (count == 0) return {0, 0};
+    for (auto it = _freeRanges.begin(); it != _freeRanges.end(); ++it) {
+        if (it->count < count) continue;
+        const Range range = {it->first, count};
+        if (it->count == count) {
+            _freeRanges.erase(it);
+        } else {
+            it->first += count;
+            it->count -= count;
+        }
+        _used += count;
+        return range;
+    }
+    return {0, 0};
+}
+
+void RangeAllocator::free(const Range range)
+{
+    if (range.count == 0) return;
+    _used -= range.count;
+
+    // first free range after the one being freed, which may merge with it and with the one before
+    auto next = std::lower_bound(_freeRanges.begin(), _freeRanges.end(), range.first,
+                                 [](const Range& free, const GLuint first) { return free.first < first; });
+    const bool mergePrevious = next != _freeRanges.begin() && (next - 1)->first + (next - 1)->count == range.first;
+    const bool mergeNext = next != _freeRanges.end() && range.first + range.count == next->first;
+    if (mergePrevious && mergeNext) {
+        (next - 1)->count += range.count + next->count;
+        _freeRanges.erase(next);
+    } else if (mergePrevious) {
+        (next - 1)->count += range.count;
+    } else if (mergeNext) {
+        next->first = range.first;
+        next->count += range.count;
+    } else {
+        _freeRanges.insert(next, range);
+    }
+}
+
+GLuint RangeAllocator::getLargestFree() const
+{
+    GLuint largest = 0;
+    for (const Range& range : _freeRanges) {
+        largest = std::max(largest, range.count);
+    }
+    return largest;
+}
@@ -0,0 +1,52 @@
+#ifndef RANGE_ALLOCATOR_H
+#define RANGE_ALLOCATOR_H
+
+#include <glad/gl.h>
+
+#include <vector>
+
+/// \class RangeAllocator
+/// \desc Hands out ranges of a fixed size array, such as the vertices or indices of a shared
+/// buffer.  Free space is kept as a list of ranges sorted by offset; allocating takes the first
+/// range large enough, and freeing merges the range back with its free neighbours, so the
+/// space left after objects of different sizes come and go stays in as few pieces as possible.
+/// Only offsets are tracked, the storage itself belongs to the caller
+class RangeAllocator {
+public:
+    /// \desc a contiguous run of elements, count 0 if nothing was allocated
+    struct Range {
+        GLuint first;
+        GLuint count;
+    };
+
+    /// \desc creates an allocator with nothing to hand out, call reset()
+    RangeAllocator();
+
+    /// \desc frees everything and sets the number of elements managed
+    void reset(GLuint capacity);
+    /// \desc adds elements past the current end, which become free
+    /// \param capacity new number of elements, at least the current one
+    void grow(GLuint capacity);
+
+    /// \desc allocates a range from the first free range large enough
+    /// \param count number of elements, at least 1
+    /// \returns the range, with count 0 if no free range is large enough
+    Range allocate(GLuint count);
+    /// \desc returns a range to the free list, a range with count 0 is ignored
+    void free(Range range);
+
+    /// \desc number of elements managed
+    [[nodiscard]] GLuint getCapacity() const { return _capacity; }
+    /// \desc number of elements handed out
+    [[nodiscard]] GLuint getUsed() const { return _used; }
+    /// \desc largest range allocate() can currently succeed with
+    [[nodiscard]] GLuint getLargestFree() const;
+
+private:
+    GLuint _capacity;
+    GLuint _used;
+    /// \desc free ranges in order of offset, never adjacent to each other
+    std::vector<Range> _freeRanges;
+};
+
+#endif // RANGE_ALLOCATOR_H
@@ -0,0 +1,118 @@
+#include "SceneRegistry.h"
+
+#include "Transform.h"
+
+#include <cmath>
+
+namespace {
+    /// \desc keeps a flattened axis invertible for the normal matrix, e.g. a support beam
+    /// standing on the ground, without changing its sign
+    GLfloat invertibleScale(const GLfloat scale) {
+        constexpr GLfloat MIN_SCALE = 1e-6f;
+        if (fabsf(scale) >= MIN_SCALE) return scale;
+        return scale < 0.0f ? -MIN_SCALE : MIN_SCALE;
+    }
+}
+
+SceneRegistry::Entity SceneRegistry::create(const glm::vec3 translation, const glm::mat3& rotation, const glm::vec3 scale)
+{
+    const Entity entity = _translations.size();
+    _translations.push_back(translation);
+    _rotations.push_back(rotation);
+    _scales.push_back(scale);
+    _modelMatrices.emplace_back(1.0f);
+    _normalMatrices.emplace_back(1.0f);
+    _dirty.push_back(false);
+    _markDirty(entity);
+    return entity;
+}
+
+SceneRegistry::Range SceneRegistry::createRange(const GLuint count)
+{
+    Range range;
+    range.first = _translations.size();
+    range.count = count;
+    for (GLuint i = 0; i < count; i++) {
+        create(glm::vec3(0.0f));
+    }
+    return range;
+}
+
+void SceneRegistry::truncate(const GLuint numEntities)
+{
+    if (numEntities >= _translations.size()) return;
+
+    _translations.resize(numEntities);
+    _rotations.resize(numEntities);
+    _scales.resize(numEntities);
+    _modelMatrices.resize(numEntities);
+    _normalMatrices.resize(numEntities);
+    _dirty.resize(numEntities);
+
+    // forget queued entities that no longer exist
+    GLuint numDirty = 0;
+    for (const Entity entity : _dirtyEntities) {
+        if (entity < numEntities) _dirtyEntities[numDirty++] = entity;
+    }
+    _dirtyEntities.resize(numDirty);
+}
+
+void SceneRegistry::setTranslation(const Entity entity, const glm::vec3 translation)
+{
+    if (_translations[entity] == translation) return;
+    _translations[entity] = translation;
+    _markDirty(entity);
+}
+
+void SceneRegistry::setRotation(const Entity entity, const glm::mat3& rotation)
+{
+    if (_rotations[entity] == rotation) return;
+    _rotations[entity] = rotation;
+    _markDirty(entity);
+}
+
+void SceneRegistry::setScale(const Entity entity, const glm::vec3 scale)
+{
+    if (_scales[entity] == scale) return;
+    _scales[entity] = scale;
+    _markDirty(entity);
+}
+
+void SceneRegistry::setTransform(const Entity entity, const glm::vec3 translation, const glm::mat3& rotation, const glm::vec3 scale)
+{
+    setTranslation(entity, translation);
+    setRotation(entity, rotation);
+    setScale(entity, scale);
+}
+
+GLuint SceneRegistry::update()
+{
+    for (const Entity entity : _dirtyEntities) {
+        const glm::mat3& rotation = _rotations[entity];
+        const glm::vec3& scale = _scales[entity];
+
+        // translate * rotate * scale, written out column by column
+        glm::mat4& modelMtx = _modelMatrices[entity];
+        for (int axis = 0; axis < 3; axis++) {
+            const glm::vec3 column = rotation[axis] * scale[axis];
+            modelMtx[axis] = glm::vec4(column.x, column.y, column.z, 0.0f);
+        }
+        const glm::vec3& translation = _translations[entity];
+        modelMtx[3] = glm::vec4(translation.x, translation.y, translation.z, 1.0f);
+
+        _normalMatrices[entity] = Transform::normalMatrix(rotation,
+            glm::vec3(invertibleScale(scale.x), invertibleScale(scale.y), invertibleScale(scale.z)));
+        _dirty[entity] = false;
+    }
+
+    const GLuint numUpdated = _dirtyEntities.size();
+    _dirtyEntities.clear();
+    return numUpdated;
+}
+
+void SceneRegistry::_markDirty(const Entity entity)
+{
+    if (_dirty[entity]) return;
+    _dirty[entity] = true;
+    _dirtyEntities.push_back(entity);
+}
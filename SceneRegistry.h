@@ -0,0 +1,73 @@
+#ifndef SCENE_REGISTRY_H
+#define SCENE_REGISTRY_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \desc Transforms of everything drawn in the scene, stored as parallel arrays indexed by
+/// entity.  Each entity is a translate * rotate * scale composition; its model and normal
+/// matrices are cached and only recomputed after one of its parts changes, so the per frame
+/// cost of update() follows the number of moving entities rather than the size of the scene.
+/// Entities created together are contiguous, letting a renderer walk a whole group at once
+class SceneRegistry {
+public:
+    /// \desc handle of an entity, its index into the packed arrays
+    typedef GLuint Entity;
+
+    /// \desc contiguous run of entities that are drawn the same way
+    struct Range {
+        Entity first = 0;
+        GLuint count = 0;
+    };
+
+    /// \desc adds an entity
+    /// \param translation world position
+    /// \param rotation orthonormal rotation
+    /// \param scale per axis scale, applied before the rotation
+    /// \returns the new entity
+    Entity create(glm::vec3 translation, const glm::mat3& rotation = glm::mat3(1.0f), glm::vec3 scale = glm::vec3(1.0f));
+    /// \desc adds count entities at the origin, to be placed with the setters
+    Range createRange(GLuint count);
+    /// \desc removes every entity created after the first numEntities
+    void truncate(GLuint numEntities);
+
+    /// \desc setters mark the entity dirty only if the value actually changes
+    void setTranslation(Entity entity, glm::vec3 translation);
+    void setRotation(Entity entity, const glm::mat3& rotation);
+    void setScale(Entity entity, glm::vec3 scale);
+    void setTransform(Entity entity, glm::vec3 translation, const glm::mat3& rotation, glm::vec3 scale);
+
+    /// \desc recomputes the cached matrices of every entity changed since the last update
+    /// \returns number of entities recomputed
+    GLuint update();
+
+    GLuint getNumEntities() const { return _translations.size(); }
+    glm::vec3 getTranslation(const Entity entity) const { return _translations[entity]; }
+    const glm::mat4& getModelMatrix(const Entity entity) const { return _modelMatrices[entity]; }
+    const glm::mat3& getNormalMatrix(const Entity entity) const { return _normalMatrices[entity]; }
+    /// \desc packed model matrices of every entity, valid after update()
+    const glm::mat4* getModelMatrices() const { return _modelMatrices.data(); }
+    /// \desc packed normal matrices of every entity, valid after update()
+    const glm::mat3* getNormalMatrices() const { return _normalMatrices.data(); }
+
+private:
+    void _markDirty(Entity entity);
+
+    std::vector<glm::vec3> _translations;
+    std::vector<glm::mat3> _rotations;
+    std::vector<glm::vec3> _scales;
+
+    /// \desc cached world matrices, rebuilt from the parts above by update()
+    std::vector<glm::mat4> _modelMatrices;
+    std::vector<glm::mat3> _normalMatrices;
+
+    /// \desc per entity flag, so an entity changed twice is only queued once
+    std::vector<GLubyte> _dirty;
+    /// \desc entities waiting for update()
+    std::vector<Entity> _dirtyEntities;
+};
+
+#endif // SCENE_REGISTRY_H
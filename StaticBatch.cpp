@@ -0,0 +1,185 @@
+#include "StaticBatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+StaticBatch::Shape StaticBatch::makeBox(const glm::vec3 size)
+{
+    Shape shape;
+    const glm::vec3 half = 0.5f * size;
+    // four corners per face so each face keeps its own normal
+    for (GLuint axis = 0; axis < 3; axis++) {
+        for (GLint sign = -1; sign <= 1; sign += 2) {
+            glm::vec3 normal(0.0f);
+            normal[axis] = static_cast<GLfloat>(sign);
+            const GLuint u = (axis + 1) % 3;
+            const GLuint v = (axis + 2) % 3;
+            const GLushort first = shape.positions.size();
+            for (GLuint corner = 0; corner < 4; corner++) {
+                glm::vec3 position = normal * half;
+                position[u] = (corner & 1 ? 1.0f : -1.0f) * half[u];
+                position[v] = (corner & 2 ? 1.0f : -1.0f) * half[v];
+                shape.positions.push_back(position);
+                shape.normals.push_back(normal);
+            }
+            // counter clockwise seen from outside, which flips with the side of the axis
+            if (sign > 0) {
+                shape.indices.insert(shape.indices.end(), {first, static_cast<GLushort>(first + 1), static_cast<GLushort>(first + 3),
+                                                           first, static_cast<GLushort>(first + 3), static_cast<GLushort>(first + 2)});
+            } else {
+                shape.indices.insert(shape.indices.end(), {first, static_cast<GLushort>(first + 3), static_cast<GLushort>(first + 1),
+                                                           first, static_cast<GLushort>(first + 2), static_cast<GLushort>(first + 3)});
+            }
+        }
+    }
+    return shape;
+}
+
+StaticBatch::Shape StaticBatch::makeSphere(const GLfloat radius, const GLuint stacks, const GLuint slices)
+{
+    Shape shape;
+    for (GLuint stack = 0; stack <= stacks; stack++) {
+        const GLfloat phi = static_cast<GLfloat>(M_PI) * stack / stacks;
+        for (GLuint slice = 0; slice <= slices; slice++) {
+            const GLfloat theta = 2.0f * static_cast<GLfloat>(M_PI) * slice / slices;
+            const glm::vec3 normal(sinf(phi) * cosf(theta), cosf(phi), -sinf(phi) * sinf(theta));
+            shape.positions.push_back(radius * normal);
+            shape.normals.push_back(normal);
+        }
+    }
+    const GLuint rowLength = slices + 1;
+    for (GLuint stack = 0; stack < stacks; stack++) {
+        for (GLuint slice = 0; slice < slices; slice++) {
+            const GLushort corner = stack * rowLength + slice;
+            shape.indices.insert(shape.indices.end(), {corner, static_cast<GLushort>(corner + rowLength), static_cast<GLushort>(corner + 1),
+                                                       static_cast<GLushort>(corner + 1), static_cast<GLushort>(corner + rowLength),
+                                                       static_cast<GLushort>(corner + rowLength + 1)});
+        }
+    }
+    return shape;
+}
+
+StaticBatch::StaticBatch()
+    : _pPool(nullptr),
+      _shapeMin(0.0f),
+      _shapeMax(0.0f),
+      _indices{0, 0}
+{
+}
+
+StaticBatch::~StaticBatch()
+{
+    if (!_pPool) return;
+    for (const GeometryPool::Range& copy : _copies) {
+        _pPool->freeVertices(copy);
+    }
+    _pPool->freeIndices(_indices);
+}
+
+void StaticBatch::setup(GeometryPool* pPool, const Shape& shape)
+{
+    _pPool = pPool;
+    _positions = shape.positions;
+    _normals = shape.normals;
+    _packedVertices.resize(_positions.size());
+
+    const PositionBounds shapeBounds = VertexFormat::computeBounds(_positions.data(), _positions.size());
+    _shapeMin = shapeBounds.origin;
+    _shapeMax = shapeBounds.origin + shapeBounds.extent;
+
+    _indices = _pPool->allocateIndices(shape.indices.size());
+    _pPool->uploadIndices(_indices, shape.indices.data());
+}
+
+void StaticBatch::resize(const GLuint numCopies)
+{
+    if (!_pPool) return;
+
+    // a new set of copies packs itself into the pool from scratch
+    for (const GeometryPool::Range& copy : _copies) {
+        _pPool->freeVertices(copy);
+    }
+    _copies.resize(numCopies);
+    for (GeometryPool::Range& copy : _copies) {
+        copy = _pPool->allocateVertices(_positions.size());
+    }
+
+    _dirty.assign(numCopies, 1);
+    _dirtyCopies.resize(numCopies);
+    for (GLuint copy = 0; copy < numCopies; copy++) {
+        _dirtyCopies[copy] = copy;
+    }
+    // the box has to be recomputed for the new copies
+    _bounds = VertexFormat::IDENTITY_BOUNDS;
+    _bounds.extent = glm::vec3(0.0f);
+}
+
+void StaticBatch::markDirty(const GLuint copy)
+{
+    if (copy >= _copies.size() || _dirty[copy]) return;
+    _dirty[copy] = 1;
+    _dirtyCopies.push_back(copy);
+}
+
+void StaticBatch::update(const glm::mat4* modelMatrices, const glm::mat3* normalMatrices)
+{
+    if (_dirtyCopies.empty()) return;
+
+    // a copy leaving the decode box means every copy is packed against a new one
+    const glm::vec3 boundsMax = _bounds.origin + _bounds.extent;
+    bool repack = false;
+    for (const GLuint copy : _dirtyCopies) {
+        glm::vec3 boxMin, boxMax;
+        _transformedBox(modelMatrices[copy], boxMin, boxMax);
+        for (GLuint axis = 0; axis < 3; axis++) {
+            repack = repack || boxMin[axis] < _bounds.origin[axis] || boxMax[axis] > boundsMax[axis];
+        }
+    }
+
+    if (repack) {
+        glm::vec3 batchMin(INFINITY), batchMax(-INFINITY);
+        for (GLuint copy = 0; copy < _copies.size(); copy++) {
+            glm::vec3 boxMin, boxMax;
+            _transformedBox(modelMatrices[copy], boxMin, boxMax);
+            batchMin = glm::min(batchMin, boxMin);
+            batchMax = glm::max(batchMax, boxMax);
+        }
+        // room for copies to be dragged around before the next repack
+        const glm::vec3 margin = 0.25f * (batchMax - batchMin) + glm::vec3(1.0f);
+        _bounds.origin = batchMin - margin;
+        _bounds.extent = batchMax - batchMin + 2.0f * margin;
+        for (GLuint copy = 0; copy < _copies.size(); copy++) {
+            _writeCopy(copy, modelMatrices[copy], normalMatrices[copy]);
+        }
+    } else {
+        for (const GLuint copy : _dirtyCopies) {
+            _writeCopy(copy, modelMatrices[copy], normalMatrices[copy]);
+        }
+    }
+
+    for (const GLuint copy : _dirtyCopies) {
+        _dirty[copy] = 0;
+    }
+    _dirtyCopies.clear();
+}
+
+void StaticBatch::_transformedBox(const glm::mat4& modelMtx, glm::vec3& boxMin, glm::vec3& boxMax) const
+{
+    // each axis gathers the extents it is rotated onto
+    const glm::vec3 center = glm::vec3(modelMtx * glm::vec4(0.5f * (_shapeMin + _shapeMax), 1.0f));
+    const glm::vec3 halfExtent = glm::abs(glm::vec3(modelMtx[0])) * (0.5f * (_shapeMax.x - _shapeMin.x))
+                               + glm::abs(glm::vec3(modelMtx[1])) * (0.5f * (_shapeMax.y - _shapeMin.y))
+                               + glm::abs(glm::vec3(modelMtx[2])) * (0.5f * (_shapeMax.z - _shapeMin.z));
+    boxMin = center - halfExtent;
+    boxMax = center + halfExtent;
+}
+
+void StaticBatch::_writeCopy(const GLuint copy, const glm::mat4& modelMtx, const glm::mat3& normalMtx)
+{
+    for (GLuint v = 0; v < _positions.size(); v++) {
+        const glm::vec3 position = glm::vec3(modelMtx * glm::vec4(_positions[v], 1.0f));
+        const glm::vec3 normal = glm::normalize(normalMtx * _normals[v]);
+        _packedVertices[v] = VertexFormat::pack(position, normal, glm::vec2(0.0f), _bounds);
+    }
+    _pPool->uploadVertices(_copies[copy], _packedVertices.data());
+}
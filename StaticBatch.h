@@ -0,0 +1,88 @@
+#ifndef STATIC_BATCH_H
+#define STATIC_BATCH_H
+
+#include "GeometryPool.h"
+#include "VertexFormat.h"
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class StaticBatch
+/// \desc Many copies of one shape drawn with one material, such as the support beams.  Each
+/// copy is stored in a GeometryPool already transformed into world space, so the whole batch
+/// draws with the view's matrices and one position decode, as a single multi-draw of the
+/// copies that are visible.  Every copy shares the shape's index range and has a vertex range
+/// of its own, which is rewritten only when its entity moves.  Positions are quantized against
+/// a box around every copy with some room to spare; a copy moved outside it grows the box and
+/// re-packs the batch
+class StaticBatch {
+public:
+    /// \desc triangles of a shape in its own space
+    struct Shape {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<GLushort> indices;
+    };
+    /// \desc axis aligned box centred on the origin
+    /// \param size length of the box along each axis
+    static Shape makeBox(glm::vec3 size);
+    /// \desc sphere centred on the origin
+    /// \param radius radius of the sphere
+    /// \param stacks rings from pole to pole
+    /// \param slices segments around each ring
+    static Shape makeSphere(GLfloat radius, GLuint stacks, GLuint slices);
+
+    /// \desc creates an empty batch, call setup()
+    StaticBatch();
+    /// \desc returns the batch's ranges to the pool
+    ~StaticBatch();
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+
+    /// \desc sets the shape and uploads its indices
+    /// \param pPool pool the batch lives in, must outlive the batch
+    /// \param shape shape every copy is made of
+    void setup(GeometryPool* pPool, const Shape& shape);
+
+    /// \desc sets the number of copies, every copy is rewritten by the next update()
+    void resize(GLuint numCopies);
+    /// \desc marks a copy as moved, so the next update() rewrites it
+    void markDirty(GLuint copy);
+    /// \desc rewrites the copies that moved since the last update()
+    /// \param modelMatrices model matrix of each copy
+    /// \param normalMatrices normal matrix of each copy
+    void update(const glm::mat4* modelMatrices, const glm::mat3* normalMatrices);
+
+    /// \desc decode box of the batch's packed positions
+    [[nodiscard]] const PositionBounds& getBounds() const { return _bounds; }
+    [[nodiscard]] GLuint getNumCopies() const { return _copies.size(); }
+    /// \desc queues a draw of one copy with the pool
+    void addDraw(GLuint copy) const { _pPool->addDraw(_indices, _copies[copy].first); }
+
+private:
+    /// \desc world box of the shape under a model matrix
+    void _transformedBox(const glm::mat4& modelMtx, glm::vec3& boxMin, glm::vec3& boxMax) const;
+    /// \desc transforms, packs and uploads one copy
+    void _writeCopy(GLuint copy, const glm::mat4& modelMtx, const glm::mat3& normalMtx);
+
+    GeometryPool* _pPool;
+    std::vector<glm::vec3> _positions;
+    std::vector<glm::vec3> _normals;
+    glm::vec3 _shapeMin;
+    glm::vec3 _shapeMax;
+    GeometryPool::Range _indices;
+
+    /// \desc vertex range of each copy
+    std::vector<GeometryPool::Range> _copies;
+    std::vector<GLubyte> _dirty;
+    std::vector<GLuint> _dirtyCopies;
+    PositionBounds _bounds;
+    /// \desc scratch for one copy's vertices
+    std::vector<PackedVertex> _packedVertices;
+};
+
+#endif // STATIC_BATCH_H
@@ -0,0 +1,259 @@
+#include "Terrain.h"
+
+#include <algorithm>
+#include <cstdio>
+
+Terrain::Terrain(const Heightfield& heightfield)
+    : _heightfield(heightfield),
+      _maxLevel(0),
+      _verticesPerChunk(Heightfield::getNumChunkVertices(CHUNK_CELLS)),
+      _numIndices(0),
+      _cameraPosition(0.0f),
+      _frame(0),
+      _buildsThisFrame(0),
+      _vao(0),
+      _vbo(0),
+      _ibo(0)
+{
+}
+
+Terrain::~Terrain()
+{
+    glDeleteBuffers(1, &_vbo);
+    glDeleteBuffers(1, &_ibo);
+    glDeleteVertexArrays(1, &_vao);
+}
+
+bool Terrain::setup(const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation)
+{
+    const GLfloat worldSize = _heightfield.getSettings().worldSize;
+    if (worldSize <= 0.0f) {
+        fprintf(stderr, "[ERROR]: terrain needs a positive world size\n");
+        return false;
+    }
+    while (worldSize / static_cast<GLfloat>(1u << (_maxLevel + 1)) >= MIN_CHUNK_SIZE) {
+        _maxLevel++;
+    }
+
+    // every chunk shares one grid with a skirt around it
+    const GLuint rowLength = CHUNK_CELLS + 1;
+    const GLuint gridVertices = rowLength * rowLength;
+    std::vector<GLushort> indices;
+    indices.reserve(6 * CHUNK_CELLS * (CHUNK_CELLS + 4));
+    for (GLuint row = 0; row < CHUNK_CELLS; row++) {
+        for (GLuint column = 0; column < CHUNK_CELLS; column++) {
+            const GLushort corner = row * rowLength + column;
+            indices.insert(indices.end(), {corner, static_cast<GLushort>(corner + rowLength), static_cast<GLushort>(corner + 1),
+                                           static_cast<GLushort>(corner + 1), static_cast<GLushort>(corner + rowLength),
+                                           static_cast<GLushort>(corner + rowLength + 1)});
+        }
+    }
+    for (GLuint side = 0; side < 4; side++) {
+        for (GLuint i = 0; i < CHUNK_CELLS; i++) {
+            // same side order as Heightfield::sampleChunk()
+            const GLuint border[4] = {i, CHUNK_CELLS * rowLength + i, i * rowLength, i * rowLength + CHUNK_CELLS};
+            const GLuint step[4] = {1, 1, rowLength, rowLength};
+            const GLushort top = border[side];
+            const GLushort skirt = gridVertices + side * rowLength + i;
+            indices.insert(indices.end(), {top, skirt, static_cast<GLushort>(top + step[side]),
+                                           static_cast<GLushort>(top + step[side]), skirt, static_cast<GLushort>(skirt + 1)});
+        }
+    }
+    _numIndices = indices.size();
+
+    _slots.assign(NUM_SLOTS, Slot{{0, 0, 0}, false, 0, VertexFormat::IDENTITY_BOUNDS, {}});
+    _buckets.assign(NUM_BUCKETS, NUM_SLOTS);
+    _visibleChunks.reserve(NUM_SLOTS);
+    _positions.resize(_verticesPerChunk);
+    _normals.resize(_verticesPerChunk);
+    _packedVertices.resize(_verticesPerChunk);
+
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+
+    glGenBuffers(1, &_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(NUM_SLOTS) * _verticesPerChunk * sizeof(PackedVertex), nullptr, GL_DYNAMIC_DRAW);
+    VertexFormat::setAttributeLocations(positionLocation, normalLocation, texCoordLocation);
+
+    glGenBuffers(1, &_ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    // the root is never evicted, so there is always something to draw
+    _build({0, 0, 0});
+
+    fprintf(stdout, "[INFO]: terrain of %.0f units in %u levels, %u chunk slots of %u vertices (%zu bytes)\n",
+            worldSize, _maxLevel + 1, NUM_SLOTS, _verticesPerChunk, NUM_SLOTS * _verticesPerChunk * sizeof(PackedVertex));
+    return true;
+}
+
+void Terrain::update(const glm::vec3 cameraPosition)
+{
+    _cameraPosition = cameraPosition;
+    _frame++;
+    _buildsThisFrame = 0;
+    _visibleChunks.clear();
+    if (_vao == 0) return;
+
+    _select({0, 0, 0});
+}
+
+void Terrain::_select(const NodeKey node)
+{
+    const GLuint slot = _findSlot(node);
+    _slots[slot].lastUsed = _frame;
+
+    if (node.level < _maxLevel && _shouldSplit(node)) {
+        // the children replace the node only once all four are in, the rest may follow next frame
+        bool childrenResident = true;
+        for (GLuint child = 0; child < 4; child++) {
+            const NodeKey childKey = {node.level + 1, 2 * node.x + (child & 1), 2 * node.z + (child >> 1)};
+            const GLuint childSlot = _findSlot(childKey);
+            if (childSlot < NUM_SLOTS) {
+                _slots[childSlot].lastUsed = _frame;
+            } else if (_build(childKey) == NUM_SLOTS) {
+                childrenResident = false;
+            }
+        }
+        if (childrenResident) {
+            for (GLuint child = 0; child < 4; child++) {
+                _select({node.level + 1, 2 * node.x + (child & 1), 2 * node.z + (child >> 1)});
+            }
+            return;
+        }
+    }
+
+    Chunk chunk;
+    chunk.baseVertex = slot * _verticesPerChunk;
+    chunk.bounds = _slots[slot].bounds;
+    _nodeArea(node, chunk.origin, chunk.size);
+    chunk.occluderHeights = _slots[slot].occluderHeights;
+    _visibleChunks.push_back(chunk);
+}
+
+bool Terrain::_shouldSplit(const NodeKey node) const
+{
+    // distance from the camera to the node's box, heights bounded by the hills
+    glm::vec2 origin;
+    GLfloat size;
+    _nodeArea(node, origin, size);
+    const GLfloat amplitude = _heightfield.getSettings().amplitude;
+    const glm::vec3 boxMin(origin.x, -amplitude, origin.y);
+    const glm::vec3 boxMax(origin.x + size, amplitude, origin.y + size);
+    const glm::vec3 nearest = glm::clamp(_cameraPosition, boxMin, boxMax);
+    return glm::length(_cameraPosition - nearest) < SPLIT_DISTANCE * size;
+}
+
+void Terrain::_nodeArea(const NodeKey node, glm::vec2& origin, GLfloat& size) const
+{
+    const GLfloat worldSize = _heightfield.getSettings().worldSize;
+    size = worldSize / static_cast<GLfloat>(1u << node.level);
+    origin = glm::vec2(-0.5f * worldSize + node.x * size, -0.5f * worldSize + node.z * size);
+}
+
+GLuint Terrain::_build(const NodeKey node)
+{
+    if (_buildsThisFrame >= MAX_BUILDS_PER_FRAME) return NUM_SLOTS;
+
+    // an empty slot, else the least recently used one not needed this frame; never the root
+    GLuint slot = NUM_SLOTS;
+    for (GLuint s = 0; s < NUM_SLOTS; s++) {
+        if (!_slots[s].resident) {
+            slot = s;
+            break;
+        }
+        if (_slots[s].key.level > 0 && _slots[s].lastUsed < _frame
+            && (slot == NUM_SLOTS || _slots[s].lastUsed < _slots[slot].lastUsed)) {
+            slot = s;
+        }
+    }
+    if (slot == NUM_SLOTS) return NUM_SLOTS;
+    if (_slots[slot].resident) _eraseSlot(slot);
+    _buildsThisFrame++;
+
+    glm::vec2 origin;
+    GLfloat size;
+    _nodeArea(node, origin, size);
+    const GLfloat spacing = size / CHUNK_CELLS;
+    _heightfield.sampleChunk(origin, size, CHUNK_CELLS, 4.0f * spacing, _positions.data(), _normals.data());
+
+    // texture coordinates count whole tiles from a tile corner near the chunk, so they stay small
+    // enough for half floats and still line up with the neighbours
+    const glm::vec2 textureOrigin = glm::floor(origin / TEXTURE_TILE) * TEXTURE_TILE;
+    const PositionBounds bounds = VertexFormat::computeBounds(_positions.data(), _verticesPerChunk);
+    for (GLuint v = 0; v < _verticesPerChunk; v++) {
+        const glm::vec2 texCoord = (glm::vec2(_positions[v].x, _positions[v].z) - textureOrigin) / TEXTURE_TILE;
+        _packedVertices[v] = VertexFormat::pack(_positions[v], _normals[v], texCoord, bounds);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(slot) * _verticesPerChunk * sizeof(PackedVertex),
+                    _verticesPerChunk * sizeof(PackedVertex), _packedVertices.data());
+    Slot& built = _slots[slot];
+    built.key = node;
+    built.resident = true;
+    built.lastUsed = _frame;
+    built.bounds = bounds;
+
+    // each occluder vertex takes the lowest drawn height in the occluder cells around it, so
+    // the occluder's triangles stay under the drawn triangles everywhere
+    const GLuint step = CHUNK_CELLS / OCCLUDER_CELLS;
+    for (GLuint row = 0; row <= OCCLUDER_CELLS; row++) {
+        for (GLuint column = 0; column <= OCCLUDER_CELLS; column++) {
+            GLfloat lowest = _positions[row * step * (CHUNK_CELLS + 1) + column * step].y;
+            for (GLuint r = (row > 0 ? row - 1 : 0) * step; r <= std::min(row + 1, OCCLUDER_CELLS) * step; r++) {
+                for (GLuint c = (column > 0 ? column - 1 : 0) * step; c <= std::min(column + 1, OCCLUDER_CELLS) * step; c++) {
+                    lowest = std::min(lowest, _positions[r * (CHUNK_CELLS + 1) + c].y);
+                }
+            }
+            built.occluderHeights[row * (OCCLUDER_CELLS + 1) + column] = lowest;
+        }
+    }
+    _insertSlot(slot);
+    return slot;
+}
+
+GLuint Terrain::_findSlot(const NodeKey node) const
+{
+    for (GLuint bucket = _hashBucket(node); _buckets[bucket] < NUM_SLOTS; bucket = (bucket + 1) & (NUM_BUCKETS - 1)) {
+        if (_slots[_buckets[bucket]].key == node) return _buckets[bucket];
+    }
+    return NUM_SLOTS;
+}
+
+void Terrain::_insertSlot(const GLuint slot)
+{
+    GLuint bucket = _hashBucket(_slots[slot].key);
+    while (_buckets[bucket] < NUM_SLOTS) bucket = (bucket + 1) & (NUM_BUCKETS - 1);
+    _buckets[bucket] = slot;
+}
+
+void Terrain::_eraseSlot(const GLuint slot)
+{
+    GLuint bucket = _hashBucket(_slots[slot].key);
+    while (_buckets[bucket] != slot) bucket = (bucket + 1) & (NUM_BUCKETS - 1);
+    _buckets[bucket] = NUM_SLOTS;
+    _slots[slot].resident = false;
+
+    // shift later entries of the probe run back so lookups never stop at the hole
+    GLuint hole = bucket;
+    for (GLuint next = (hole + 1) & (NUM_BUCKETS - 1); _buckets[next] < NUM_SLOTS; next = (next + 1) & (NUM_BUCKETS - 1)) {
+        const GLuint home = _hashBucket(_slots[_buckets[next]].key);
+        // the entry may move into the hole unless its home lies cyclically in (hole, next]
+        const bool homeBetween = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+        if (!homeBetween) {
+            _buckets[hole] = _buckets[next];
+            _buckets[next] = NUM_SLOTS;
+            hole = next;
+        }
+    }
+}
+
+GLuint Terrain::_hashBucket(const NodeKey node) const
+{
+    GLuint h = node.level * 0x9E3779B9u ^ node.x * 0x85EBCA6Bu ^ node.z * 0xC2B2AE35u;
+    h ^= h >> 15;
+    return h & (NUM_BUCKETS - 1);
+}
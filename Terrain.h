@@ -0,0 +1,146 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include "Heightfield.h"
+#include "VertexFormat.h"
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class Terrain
+/// \desc Draws a Heightfield as a chunked quadtree.  Every node of the tree is a chunk with the
+/// same grid of CHUNK_CELLS x CHUNK_CELLS cells, so a node four times the area has a quarter of
+/// the vertex density.  Nodes near the camera split into their children and distant ones do
+/// not, which keeps the number of chunks drawn about the same however large the world is: the
+/// tree only gets deeper.  Chunks are sampled from the heightfield on demand into a fixed pool
+/// of slots in one vertex buffer, a few per frame, evicting the least recently used.  Until all
+/// four children of a node are resident the node is drawn in their place, so streaming never
+/// leaves a hole.  Skirts hide the cracks between neighbours at different levels of detail
+class Terrain {
+public:
+    /// \desc cells along each side of a chunk's occluder grid
+    static constexpr GLuint OCCLUDER_CELLS = 4;
+    static constexpr GLuint NUM_OCCLUDER_HEIGHTS = (OCCLUDER_CELLS + 1) * (OCCLUDER_CELLS + 1);
+
+    /// \desc a resident chunk to draw this frame
+    struct Chunk {
+        /// \desc first vertex of the chunk in the vertex buffer
+        GLint baseVertex;
+        /// \desc decode box of the chunk's packed positions, which is also its bounding box
+        PositionBounds bounds;
+        /// \desc minimum x and z corner of the chunk
+        glm::vec2 origin;
+        /// \desc length of the chunk's sides
+        GLfloat size;
+        /// \desc NUM_OCCLUDER_HEIGHTS heights of a coarse grid that never rises above the drawn
+        /// surface, for occlusion culling
+        const GLfloat* occluderHeights;
+    };
+
+    /// \desc creates the terrain, call setup() once a context is current
+    /// \param heightfield ground to draw, must outlive the terrain
+    explicit Terrain(const Heightfield& heightfield);
+    /// \desc releases the vertex and index buffers
+    ~Terrain();
+
+    Terrain(const Terrain&) = delete;
+    Terrain& operator=(const Terrain&) = delete;
+
+    /// \desc allocates the chunk pool and builds the root chunk
+    /// \param positionLocation attribute location for the vertex position
+    /// \param normalLocation attribute location for the vertex normal
+    /// \param texCoordLocation attribute location for the texture coordinate
+    /// \returns false if the heightfield covers no area
+    bool setup(GLint positionLocation, GLint normalLocation, GLint texCoordLocation);
+
+    /// \desc picks this frame's chunks for a camera and streams in what they are missing
+    /// \param cameraPosition world position the level of detail is chosen for
+    void update(glm::vec3 cameraPosition);
+
+    /// \desc VAO of the chunk pool
+    [[nodiscard]] GLuint getVAO() const { return _vao; }
+    /// \desc GL_UNSIGNED_SHORT triangle indices every chunk is drawn with, from offset 0
+    [[nodiscard]] GLsizei getNumIndices() const { return _numIndices; }
+    /// \desc chunks picked by the last update(), they cover the world exactly once
+    [[nodiscard]] const std::vector<Chunk>& getVisibleChunks() const { return _visibleChunks; }
+
+    /// \desc cells along each side of every chunk
+    static constexpr GLuint CHUNK_CELLS = 32;
+    /// \desc side of the finest chunks, the tree stops splitting there
+    static constexpr GLfloat MIN_CHUNK_SIZE = 8.0f;
+    /// \desc texture repeats every this many world units
+    static constexpr GLfloat TEXTURE_TILE = 27.5f;
+
+private:
+    /// \desc a node of the quadtree, level 0 is the whole world and level l has 2^l x 2^l nodes
+    struct NodeKey {
+        GLuint level;
+        GLuint x;
+        GLuint z;
+        bool operator==(const NodeKey& other) const { return level == other.level && x == other.x && z == other.z; }
+    };
+
+    /// \desc a chunk's worth of the vertex buffer
+    struct Slot {
+        NodeKey key;
+        bool resident;
+        /// \desc update() that last visited the chunk, the least recent is evicted first
+        GLuint lastUsed;
+        PositionBounds bounds;
+        GLfloat occluderHeights[NUM_OCCLUDER_HEIGHTS];
+    };
+
+    /// \desc visits a resident node, drawing it or descending into its children
+    void _select(NodeKey node);
+    /// \desc true if the camera is close enough to the node that its children should be drawn
+    [[nodiscard]] bool _shouldSplit(NodeKey node) const;
+    /// \desc minimum x and z corner and side length of a node
+    void _nodeArea(NodeKey node, glm::vec2& origin, GLfloat& size) const;
+    /// \desc samples a node into the least recently used slot
+    /// \returns the slot, or NUM_SLOTS if every slot is in use this frame
+    GLuint _build(NodeKey node);
+
+    /// \desc slot holding a node, NUM_SLOTS if it is not resident.  Resident nodes are found
+    /// through an open addressed table so each lookup is O(1) however many slots there are
+    [[nodiscard]] GLuint _findSlot(NodeKey node) const;
+    void _insertSlot(GLuint slot);
+    void _eraseSlot(GLuint slot);
+    [[nodiscard]] GLuint _hashBucket(NodeKey node) const;
+
+    /// \desc chunks resident at once, enough for every level near the camera plus streaming headroom
+    static constexpr GLuint NUM_SLOTS = 512;
+    /// \desc buckets of the slot table, a power of two at least twice NUM_SLOTS
+    static constexpr GLuint NUM_BUCKETS = 1024;
+    /// \desc chunks sampled per update(), bounding the cost of a camera jump
+    static constexpr GLuint MAX_BUILDS_PER_FRAME = 8;
+    /// \desc a node splits when the camera is closer than this many of its sides
+    static constexpr GLfloat SPLIT_DISTANCE = 1.0f;
+
+    const Heightfield& _heightfield;
+    GLuint _maxLevel;
+    GLuint _verticesPerChunk;
+    GLsizei _numIndices;
+
+    std::vector<Slot> _slots;
+    /// \desc slot of each bucket, NUM_SLOTS if empty
+    std::vector<GLuint> _buckets;
+    std::vector<Chunk> _visibleChunks;
+
+    glm::vec3 _cameraPosition;
+    GLuint _frame;
+    GLuint _buildsThisFrame;
+
+    /// \desc scratch for building a chunk, sized once in setup()
+    std::vector<glm::vec3> _positions;
+    std::vector<glm::vec3> _normals;
+    std::vector<PackedVertex> _packedVertices;
+
+    GLuint _vao;
+    GLuint _vbo;
+    GLuint _ibo;
+};
+
+#endif // TERRAIN_H
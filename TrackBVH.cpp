@@ -0,0 +1,291 @@
+#include "TrackBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    /// \desc traversal stack depth, enough for any balanced tree addressable by 32-bit indices
+    constexpr int STACK_SIZE = 64;
+
+    /// \desc squared distance from a point to an axis aligned box, zero inside
+    GLfloat boxDistance2(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::vec3& point) {
+        const glm::vec3 below = glm::max(boundsMin - point, glm::vec3(0.0f));
+        const glm::vec3 above = glm::max(point - boundsMax, glm::vec3(0.0f));
+        const glm::vec3 outside = glm::max(below, above);
+        return glm::dot(outside, outside);
+    }
+
+    /// \desc slab test returning the entry distance, or FLT_MAX if the box is missed before maxT
+    GLfloat rayBox(const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+                   const glm::vec3& origin, const glm::vec3& inverseDirection, const GLfloat maxT) {
+        const glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+        const glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        const GLfloat enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const GLfloat exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxT));
+        return enter <= exit ? enter : FLT_MAX;
+    }
+
+    /// \desc parameter of the point on segment ab closest to p
+    GLfloat closestSegmentT(const glm::vec3& a, const glm::vec3& b, const glm::vec3& p) {
+        const glm::vec3 ab = b - a;
+        const GLfloat length2 = glm::dot(ab, ab);
+        if (length2 <= 0.0f) return 0.0f;
+        return glm::clamp(glm::dot(p - a, ab) / length2, 0.0f, 1.0f);
+    }
+
+    /// \desc distance along a ray to a sphere, negative on a miss or when starting inside
+    GLfloat raySphere(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, const GLfloat radius) {
+        const glm::vec3 oc = origin - center;
+        const GLfloat b = glm::dot(direction, oc);
+        const GLfloat c = glm::dot(oc, oc) - radius * radius;
+        const GLfloat h = b * b - c;
+        if (h < 0.0f) return -1.0f;
+        return -b - sqrtf(h);
+    }
+
+    /// \desc distance along a ray to a capsule around segment ab, negative on a miss
+    GLfloat rayCapsule(const glm::vec3& origin, const glm::vec3& direction,
+                       const glm::vec3& a, const glm::vec3& b, const GLfloat radius) {
+        const glm::vec3 ba = b - a;
+        const GLfloat baba = glm::dot(ba, ba);
+        if (baba <= 1e-12f) return raySphere(origin, direction, a, radius);
+
+        GLfloat best = -1.0f;
+        auto consider = [&best](const GLfloat t) { if (t >= 0.0f && (best < 0.0f || t < best)) best = t; };
+
+        // infinite cylinder, accepted only between the end caps
+        const glm::vec3 oa = origin - a;
+        const GLfloat bard = glm::dot(ba, direction);
+        const GLfloat baoa = glm::dot(ba, oa);
+        const GLfloat qa = baba - bard * bard;
+        if (qa > 1e-12f) {
+            const GLfloat qb = baba * glm::dot(direction, oa) - baoa * bard;
+            const GLfloat qc = baba * glm::dot(oa, oa) - baoa * baoa - radius * radius * baba;
+            const GLfloat h = qb * qb - qa * qc;
+            if (h >= 0.0f) {
+                const GLfloat t = (-qb - sqrtf(h)) / qa;
+                const GLfloat y = baoa + t * bard;
+                if (y > 0.0f && y < baba) consider(t);
+            }
+        }
+
+        // hemispherical caps
+        consider(raySphere(origin, direction, a, radius));
+        consider(raySphere(origin, direction, b, radius));
+        return best;
+    }
+}
+
+TrackBVH::TrackBVH()
+    : _points(nullptr),
+      _radius(0.0f),
+      _segments(true)
+{
+}
+
+void TrackBVH::buildSegments(const glm::vec3* points, const GLuint numPoints, const GLfloat radius) {
+    _build(points, numPoints > 1 ? numPoints - 1 : 0, radius, true);
+}
+
+void TrackBVH::buildPoints(const glm::vec3* points, const GLuint numPoints, const GLfloat radius) {
+    _build(points, numPoints, radius, false);
+}
+
+void TrackBVH::_build(const glm::vec3* points, const GLuint numPrimitives, const GLfloat radius, const bool segments) {
+    _points = points;
+    _radius = radius;
+    _segments = segments;
+
+    _nodes.clear();
+    _primitives.resize(numPrimitives);
+    std::iota(_primitives.begin(), _primitives.end(), 0);
+    _primitiveLeaf.assign(numPrimitives, 0);
+    if (numPrimitives == 0) return;
+
+    std::vector<glm::vec3> centroids(numPrimitives);
+    for (GLuint i = 0; i < numPrimitives; i++) {
+        glm::vec3 a, b;
+        _endPoints(i, a, b);
+        centroids[i] = (a + b) * 0.5f;
+    }
+
+    _nodes.reserve(2 * (numPrimitives / (LEAF_SIZE / 2) + 1));
+    _nodes.push_back({glm::vec3(0.0f), glm::vec3(0.0f), 0, numPrimitives, NO_PARENT});
+    _split(0, centroids);
+}
+
+void TrackBVH::_split(const GLuint nodeIndex, std::vector<glm::vec3>& centroids) {
+    _fitLeaf(_nodes[nodeIndex]);
+
+    const GLuint first = _nodes[nodeIndex].first;
+    const GLuint count = _nodes[nodeIndex].count;
+    if (count <= LEAF_SIZE) {
+        for (GLuint i = first; i < first + count; i++) {
+            _primitiveLeaf[_primitives[i]] = nodeIndex;
+        }
+        return;
+    }
+
+    // median split along the longest axis of the centroids
+    glm::vec3 centroidMin = centroids[_primitives[first]];
+    glm::vec3 centroidMax = centroidMin;
+    for (GLuint i = first + 1; i < first + count; i++) {
+        centroidMin = glm::min(centroidMin, centroids[_primitives[i]]);
+        centroidMax = glm::max(centroidMax, centroids[_primitives[i]]);
+    }
+    const glm::vec3 extent = centroidMax - centroidMin;
+    const int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+    const GLuint middle = first + count / 2;
+    std::nth_element(_primitives.begin() + first, _primitives.begin() + middle, _primitives.begin() + first + count,
+                     [&centroids, axis](const GLuint lhs, const GLuint rhs) { return centroids[lhs][axis] < centroids[rhs][axis]; });
+
+    const GLuint leftChild = _nodes.size();
+    _nodes.push_back({glm::vec3(0.0f), glm::vec3(0.0f), first, middle - first, nodeIndex});
+    _nodes.push_back({glm::vec3(0.0f), glm::vec3(0.0f), middle, first + count - middle, nodeIndex});
+    _nodes[nodeIndex].first = leftChild;
+    _nodes[nodeIndex].count = 0;
+
+    _split(leftChild, centroids);
+    _split(leftChild + 1, centroids);
+}
+
+void TrackBVH::_fitLeaf(Node& node) const {
+    glm::vec3 a, b;
+    _endPoints(_primitives[node.first], a, b);
+    node.boundsMin = glm::min(a, b);
+    node.boundsMax = glm::max(a, b);
+    for (GLuint i = node.first + 1; i < node.first + node.count; i++) {
+        _endPoints(_primitives[i], a, b);
+        node.boundsMin = glm::min(node.boundsMin, glm::min(a, b));
+        node.boundsMax = glm::max(node.boundsMax, glm::max(a, b));
+    }
+    node.boundsMin -= glm::vec3(_radius);
+    node.boundsMax += glm::vec3(_radius);
+}
+
+void TrackBVH::_endPoints(const GLuint primitive, glm::vec3& a, glm::vec3& b) const {
+    a = _points[primitive];
+    b = _segments ? _points[primitive + 1] : a;
+}
+
+void TrackBVH::refit(const glm::vec3* points, const GLuint firstPrimitive, GLuint lastPrimitive) {
+    _points = points;
+    if (_nodes.empty() || firstPrimitive >= _primitives.size()) return;
+    lastPrimitive = std::min(lastPrimitive, (GLuint)_primitives.size() - 1);
+
+    // neighbouring track segments mostly share leaves, so collect each leaf once
+    std::vector<GLuint> leaves;
+    for (GLuint i = firstPrimitive; i <= lastPrimitive; i++) {
+        leaves.push_back(_primitiveLeaf[i]);
+    }
+    std::sort(leaves.begin(), leaves.end());
+    leaves.erase(std::unique(leaves.begin(), leaves.end()), leaves.end());
+
+    for (const GLuint leaf : leaves) {
+        _fitLeaf(_nodes[leaf]);
+        for (GLuint node = _nodes[leaf].parent; node != NO_PARENT; node = _nodes[node].parent) {
+            const Node& left = _nodes[_nodes[node].first];
+            const Node& right = _nodes[_nodes[node].first + 1];
+            _nodes[node].boundsMin = glm::min(left.boundsMin, right.boundsMin);
+            _nodes[node].boundsMax = glm::max(left.boundsMax, right.boundsMax);
+        }
+    }
+}
+
+bool TrackBVH::nearestPoint(const glm::vec3 query, Hit& hit) const {
+    if (_nodes.empty()) return false;
+
+    GLfloat bestDistance2 = FLT_MAX;
+    GLuint stack[STACK_SIZE];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = _nodes[stack[--stackSize]];
+        if (boxDistance2(node.boundsMin, node.boundsMax, query) >= bestDistance2) continue;
+
+        if (node.count > 0) {
+            for (GLuint i = node.first; i < node.first + node.count; i++) {
+                glm::vec3 a, b;
+                _endPoints(_primitives[i], a, b);
+                const GLfloat t = closestSegmentT(a, b, query);
+                const glm::vec3 closest = a + t * (b - a);
+                const GLfloat distance2 = glm::dot(query - closest, query - closest);
+                if (distance2 < bestDistance2) {
+                    bestDistance2 = distance2;
+                    hit.primitive = _primitives[i];
+                    hit.segmentT = t;
+                    hit.point = closest;
+                }
+            }
+        } else {
+            // visit the nearer child first so the farther one is more likely to be pruned
+            const GLuint left = node.first;
+            const GLfloat leftDistance2 = boxDistance2(_nodes[left].boundsMin, _nodes[left].boundsMax, query);
+            const GLfloat rightDistance2 = boxDistance2(_nodes[left + 1].boundsMin, _nodes[left + 1].boundsMax, query);
+            if (leftDistance2 < rightDistance2) {
+                stack[stackSize++] = left + 1;
+                stack[stackSize++] = left;
+            } else {
+                stack[stackSize++] = left;
+                stack[stackSize++] = left + 1;
+            }
+        }
+    }
+
+    hit.distance = sqrtf(bestDistance2);
+    return true;
+}
+
+bool TrackBVH::intersectRay(const glm::vec3 origin, const glm::vec3 direction, Hit& hit) const {
+    if (_nodes.empty()) return false;
+
+    const glm::vec3 inverseDirection = 1.0f / direction;
+    GLfloat bestT = FLT_MAX;
+    GLuint stack[STACK_SIZE];
+    int stackSize = 0;
+    if (rayBox(_nodes[0].boundsMin, _nodes[0].boundsMax, origin, inverseDirection, bestT) != FLT_MAX) {
+        stack[stackSize++] = 0;
+    }
+
+    while (stackSize > 0) {
+        const Node& node = _nodes[stack[--stackSize]];
+
+        if (node.count > 0) {
+            for (GLuint i = node.first; i < node.first + node.count; i++) {
+                glm::vec3 a, b;
+                _endPoints(_primitives[i], a, b);
+                const GLfloat t = rayCapsule(origin, direction, a, b, _radius);
+                if (t >= 0.0f && t < bestT) {
+                    bestT = t;
+                    hit.primitive = _primitives[i];
+                }
+            }
+        } else {
+            // boxes entered after the current best hit cannot contain a closer one
+            const GLuint left = node.first;
+            const GLfloat leftT = rayBox(_nodes[left].boundsMin, _nodes[left].boundsMax, origin, inverseDirection, bestT);
+            const GLfloat rightT = rayBox(_nodes[left + 1].boundsMin, _nodes[left + 1].boundsMax, origin, inverseDirection, bestT);
+            if (leftT < rightT) {
+                if (rightT != FLT_MAX) stack[stackSize++] = left + 1;
+                stack[stackSize++] = left;
+            } else {
+                if (leftT != FLT_MAX) stack[stackSize++] = left;
+                if (rightT != FLT_MAX) stack[stackSize++] = left + 1;
+            }
+        }
+    }
+    if (bestT == FLT_MAX) return false;
+
+    glm::vec3 a, b;
+    _endPoints(hit.primitive, a, b);
+    hit.distance = bestT;
+    hit.point = origin + bestT * direction;
+    hit.segmentT = closestSegmentT(a, b, hit.point);
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef TRACK_BVH_H
+#define TRACK_BVH_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class TrackBVH
+/// \desc Bounding volume hierarchy over track primitives.  A primitive is either the segment
+/// between two consecutive curve samples or a single point, both swept by a fixed radius, so
+/// the same tree answers queries against the monorail tube and against the control point
+/// spheres.  The tree references the caller's point array rather than copying it; the array
+/// must stay alive and in place until the next build or refit
+class TrackBVH {
+public:
+    /// \desc result of a query against the tree
+    struct Hit {
+        /// \desc segment or point index that was hit
+        GLuint primitive = 0;
+        /// \desc parameter of the closest centerline point along the segment, in [0,1]
+        GLfloat segmentT = 0.0f;
+        /// \desc distance from the query point, or along the ray to the hit
+        GLfloat distance = 0.0f;
+        /// \desc closest centerline point, or the point on the surface the ray hit
+        glm::vec3 point = glm::vec3(0.0f);
+    };
+
+    /// \desc creates an empty tree
+    TrackBVH();
+
+    /// \desc builds the tree over the segments between consecutive points, primitive i being
+    /// points[i] to points[i + 1]
+    /// \param points curve samples in track order
+    /// \param numPoints number of samples
+    /// \param radius radius swept around each segment
+    void buildSegments(const glm::vec3* points, GLuint numPoints, GLfloat radius);
+    /// \desc builds the tree over individual points, primitive i being a sphere at points[i]
+    /// \param points sphere centers
+    /// \param numPoints number of centers
+    /// \param radius radius of each sphere
+    void buildPoints(const glm::vec3* points, GLuint numPoints, GLfloat radius);
+
+    /// \desc updates the bounds of a range of primitives whose points moved and of every node
+    /// above them, keeping the tree topology
+    /// \param points point array, which may have been reallocated at the same size
+    /// \param firstPrimitive first primitive that moved
+    /// \param lastPrimitive last primitive that moved
+    void refit(const glm::vec3* points, GLuint firstPrimitive, GLuint lastPrimitive);
+
+    /// \desc finds the closest point on any primitive centerline
+    /// \param query point to search from
+    /// \param [out] hit closest primitive and point
+    /// \returns false if the tree is empty
+    bool nearestPoint(glm::vec3 query, Hit& hit) const;
+    /// \desc finds the first primitive surface hit by a ray
+    /// \param origin ray origin
+    /// \param direction normalized ray direction
+    /// \param [out] hit first primitive hit and the hit point
+    /// \returns false if the ray misses every primitive
+    bool intersectRay(glm::vec3 origin, glm::vec3 direction, Hit& hit) const;
+
+    /// \desc number of primitives in the tree
+    [[nodiscard]] GLuint getNumPrimitives() const { return _primitives.size(); }
+
+private:
+    /// \desc node of the flattened tree.  An interior node's children are stored at
+    /// firstChild and firstChild + 1, a leaf covers count entries of _primitives
+    struct Node {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        GLuint first;
+        GLuint count;
+        GLuint parent;
+    };
+    /// \desc maximum primitives stored in one leaf
+    static constexpr GLuint LEAF_SIZE = 4;
+    /// \desc marks the root's parent
+    static constexpr GLuint NO_PARENT = 0xFFFFFFFFu;
+
+    /// \desc shared build once the primitive type is set
+    void _build(const glm::vec3* points, GLuint numPrimitives, GLfloat radius, bool segments);
+    /// \desc recursively splits a node at the median centroid of its longest axis
+    void _split(GLuint nodeIndex, std::vector<glm::vec3>& centroids);
+    /// \desc recomputes a leaf's bounds from its primitives
+    void _fitLeaf(Node& node) const;
+    /// \desc end points of a primitive, equal for point primitives
+    void _endPoints(GLuint primitive, glm::vec3& a, glm::vec3& b) const;
+
+    const glm::vec3* _points;
+    GLfloat _radius;
+    bool _segments;
+    std::vector<Node> _nodes;
+    /// \desc primitive indices, grouped so each leaf covers a contiguous range
+    std::vector<GLuint> _primitives;
+    /// \desc leaf containing each primitive, used to refit from the bottom up
+    std::vector<GLuint> _primitiveLeaf;
+};
+
+#endif // TRACK_BVH_H
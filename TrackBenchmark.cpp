@@ -0,0 +1,575 @@
+/*
+ *  CSCI 441, Computer Graphics, Fall 2024
+ *
+ *  Project: fp
+ *  File: TrackBenchmark.cpp
+ *
+ *  Description:
+ *      fp-bench: microbenchmarks for the CPU side of the track pipeline.  Runs the
+ *      CPU stages the engine uses on synthetic tracks from 10 to 10 million control
+ *      points without creating a window or GL context, and
+ *      reports time, throughput and heap allocations per stage so scaling can be compared
+ *      across builds.
+ *
+ *      usage: fp-bench [--min N] [--max N] [--csv FILE]
+ */
+
+#include "Heightfield.h"
+#include "OcclusionCuller.h"
+#include "SceneRegistry.h"
+#include "TrackGenerator.h"
+#include "TrackGeometry.h"
+#include "TrackBVH.h"
+#include "TrackZones.h"
+#include "Transform.h"
+#include "VertexFormat.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <random>
+#include <vector>
+
+//*************************************************************************************
+//
+// Allocation Tracking
+
+namespace {
+    std::atomic<size_t> allocationCount(0);
+    std::atomic<size_t> allocationBytes(0);
+}
+
+void* operator new(size_t size)
+{
+    allocationCount++;
+    allocationBytes += size;
+    if (void* pMemory = malloc(size ? size : 1)) return pMemory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pMemory) noexcept { free(pMemory); }
+void operator delete(void* pMemory, size_t) noexcept { free(pMemory); }
+
+//*************************************************************************************
+//
+// Benchmark Helpers
+
+namespace {
+    /// \desc matches the engine's sampling, tube and chunk settings
+    constexpr GLuint CURVE_RESOLUTION = 100;
+    constexpr GLfloat MONORAIL_RADIUS = 0.2f;
+    constexpr GLint MONORAIL_SEGMENTS = 16;
+    constexpr GLuint MONORAIL_CHUNK_RINGS = 64;
+    constexpr GLuint BEAM_SPACING = 50;
+
+    /// \desc curves sampled at a time; large tracks are processed in blocks so 10M control
+    /// points do not need every sample in memory at once
+    constexpr GLuint BLOCK_CURVES = 4096;
+    /// \desc objects the matrix and scene stages run on; they grow with the track up to this
+    /// many so 10M control points do not need gigabytes of matrices
+    constexpr GLuint MAX_OBJECTS = 100000;
+
+    /// \desc short stages are repeated until they have run for at least this long
+    constexpr double MIN_SECONDS = 0.2;
+    constexpr int MAX_REPETITIONS = 100000;
+
+    /// \desc scratch files the load stages read, one per track format
+    const char* TRACK_FILENAMES[2] = { "fp-bench-track.csv", "fp-bench-track.trk" };
+    const char* LOAD_STAGES[2] = { "load-csv", "load-trk" };
+
+    /// \desc accumulates the time and allocations of the timed parts of one repetition
+    struct StageTimer {
+        double seconds = 0.0;
+        size_t allocations = 0;
+        size_t bytes = 0;
+
+        std::chrono::steady_clock::time_point startTime;
+        size_t startAllocations = 0;
+        size_t startBytes = 0;
+
+        void start() {
+            startAllocations = allocationCount;
+            startBytes = allocationBytes;
+            startTime = std::chrono::steady_clock::now();
+        }
+        void stop() {
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            allocations += allocationCount - startAllocations;
+            bytes += allocationBytes - startBytes;
+        }
+    };
+
+    /// \desc per run averages of one stage at one track size
+    struct StageResult {
+        const char* stage;
+        GLuint numControlPoints;
+        size_t items;
+        int repetitions;
+        double seconds;
+        double allocations;
+        double bytes;
+    };
+
+    /// \desc keeps the optimizer from discarding results
+    volatile GLfloat sink;
+
+    /// \desc repeats a stage until it has run long enough to time, then averages
+    template<typename Stage>
+    StageResult measure(const char* name, GLuint numControlPoints, size_t items, Stage stage) {
+        StageTimer timer;
+        int repetitions = 0;
+        do {
+            stage(timer);
+            repetitions++;
+        } while (timer.seconds < MIN_SECONDS && repetitions < MAX_REPETITIONS);
+
+        return { name, numControlPoints, items, repetitions,
+                 timer.seconds / repetitions, (double)timer.allocations / repetitions, (double)timer.bytes / repetitions };
+    }
+
+    /// \desc samples curves [firstCurve, firstCurve + numCurves) into a block
+    void sampleBlock(const std::vector<glm::vec3>& controlPoints, GLuint firstCurve, GLuint numCurves, std::vector<glm::vec3>& samples) {
+        samples.resize(numCurves * (CURVE_RESOLUTION + 1));
+        for (GLuint i = 0; i < numCurves; i++) {
+            TrackGeometry::sampleCurve(controlPoints.data(), firstCurve + i, CURVE_RESOLUTION, &samples[i * (CURVE_RESOLUTION + 1)]);
+        }
+    }
+
+    /// \desc smallest cosine allowed between a tube normal and the same vertex's normal on the
+    /// ring before, about 25 degrees
+    constexpr GLfloat MIN_RING_TURN_COS = 0.9f;
+
+    /// \desc sweeps a generated track of loops back to back, whose tangents point straight up
+    /// and down, and checks that every tube normal is finite and turns only a little from one
+    /// ring to the next
+    /// \returns false, after printing the first bad ring, if the tube breaks or twists
+    bool checkRingFrames() {
+        TrackGenerator::Settings settings;
+        settings.numCurves = 64;
+        settings.loopChance = 1.0f;
+        std::vector<glm::vec3> controlPoints;
+        TrackGenerator::generate(settings, controlPoints);
+
+        std::vector<glm::vec3> samples;
+        sampleBlock(controlPoints, 0, settings.numCurves, samples);
+        std::vector<glm::vec3> knotNormals(controlPoints.size());
+        TrackGeometry::computeKnotNormals(samples.data(), settings.numCurves, CURVE_RESOLUTION, knotNormals.data());
+
+        const GLuint numRings = samples.size();
+        std::vector<glm::vec3> positions(numRings * MONORAIL_SEGMENTS);
+        std::vector<glm::vec3> normals(positions.size());
+        TrackGeometry::sweepRings(samples.data(), numRings, knotNormals.data(), CURVE_RESOLUTION, 0, numRings - 1,
+                                  MONORAIL_RADIUS, MONORAIL_SEGMENTS, positions.data(), normals.data());
+
+        for (GLuint ring = 0; ring < numRings; ring++) {
+            for (GLint j = 0; j < MONORAIL_SEGMENTS; j++) {
+                const glm::vec3& normal = normals[ring * MONORAIL_SEGMENTS + j];
+                if (!std::isfinite(normal.x) || !std::isfinite(normal.y) || !std::isfinite(normal.z)) {
+                    fprintf(stderr, "[ERROR]: tube normal %d of ring %u is not finite\n", j, ring);
+                    return false;
+                }
+                if (ring > 0 && glm::dot(normal, normals[(ring - 1) * MONORAIL_SEGMENTS + j]) < MIN_RING_TURN_COS) {
+                    fprintf(stderr, "[ERROR]: tube normal %d turns too far between rings %u and %u\n", j, ring - 1, ring);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// \desc nearest point queries checked against every segment, at points scattered around the track
+    constexpr GLuint NUM_NEAREST_QUERIES = 1000;
+
+    /// \desc builds the segment tree over a generated track and checks that the nearest point
+    /// it finds is as close as the nearest of all segments, so pruning never skips the answer
+    /// \returns false, after printing the first wrong query, if the tree misses a closer segment
+    bool checkNearestPoints() {
+        TrackGenerator::Settings settings;
+        settings.numCurves = 64;
+        std::vector<glm::vec3> controlPoints;
+        TrackGenerator::generate(settings, controlPoints);
+        std::vector<glm::vec3> samples;
+        sampleBlock(controlPoints, 0, settings.numCurves, samples);
+
+        TrackBVH bvh;
+        bvh.buildSegments(samples.data(), samples.size(), MONORAIL_RADIUS);
+        glm::vec3 boundsMin = samples[0], boundsMax = samples[0];
+        for (const glm::vec3& sample : samples) {
+            boundsMin = glm::min(boundsMin, sample);
+            boundsMax = glm::max(boundsMax, sample);
+        }
+        // queries reach past the track so some start outside the root box
+        boundsMin -= glm::vec3(10.0f);
+        boundsMax += glm::vec3(10.0f);
+
+        std::mt19937 random(441);
+        for (GLuint q = 0; q < NUM_NEAREST_QUERIES; q++) {
+            glm::vec3 query;
+            for (int axis = 0; axis < 3; axis++) {
+                query[axis] = glm::mix(boundsMin[axis], boundsMax[axis], (random() >> 8) * (1.0f / 16777216.0f));
+            }
+
+            GLfloat closestDistance = FLT_MAX;
+            for (size_t i = 0; i + 1 < samples.size(); i++) {
+                const glm::vec3 segment = samples[i + 1] - samples[i];
+                const GLfloat length2 = glm::dot(segment, segment);
+                const GLfloat t = length2 > 0.0f ? glm::clamp(glm::dot(query - samples[i], segment) / length2, 0.0f, 1.0f) : 0.0f;
+                closestDistance = std::min(closestDistance, glm::length(query - (samples[i] + t * segment)));
+            }
+
+            TrackBVH::Hit hit;
+            if (!bvh.nearestPoint(query, hit) || hit.distance > closestDistance + 1e-4f * (1.0f + closestDistance)) {
+                fprintf(stderr, "[ERROR]: nearest point query %u found %f, the closest segment is %f away\n",
+                        q, hit.distance, closestDistance);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void printResult(const StageResult& result, FILE* pCSV) {
+        const double itemsPerSecond = result.items / result.seconds;
+        fprintf(stdout, "%-10s %10u %12zu %7d %12.3f %10.2f %10.1f %10.1f %8.2f\n",
+                result.stage, result.numControlPoints, result.items, result.repetitions,
+                result.seconds * 1000.0, itemsPerSecond / 1.0e6,
+                result.allocations, result.bytes / 1024.0,
+                result.seconds * 1.0e9 / result.items);
+        if (pCSV) {
+            fprintf(pCSV, "%s,%u,%zu,%d,%.6f,%.1f,%.1f,%.1f\n",
+                    result.stage, result.numControlPoints, result.items, result.repetitions,
+                    result.seconds * 1000.0, itemsPerSecond, result.allocations, result.bytes);
+        }
+    }
+
+    /// \desc smallest track, a single cubic curve
+    constexpr GLuint MIN_CONTROL_POINTS = 4;
+
+    /// \desc reads a --min or --max control point count
+    /// \returns false unless the whole value is a number from MIN_CONTROL_POINTS up
+    bool parseControlPoints(const char* value, GLuint& numControlPoints) {
+        char* end = nullptr;
+        const unsigned long count = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || count < MIN_CONTROL_POINTS || count > std::numeric_limits<GLuint>::max()) {
+            return false;
+        }
+        numControlPoints = static_cast<GLuint>(count);
+        return true;
+    }
+}
+
+//*************************************************************************************
+//
+// Stages
+
+/// \desc times every pipeline stage on a track of the given size
+static void benchmarkTrack(GLuint numControlPoints, FILE* pCSV) {
+    // a reproducible procedural track with loops and drops
+    TrackGenerator::Settings settings;
+    settings.numCurves = (numControlPoints - 1) / 3;
+    std::vector<glm::vec3> controlPoints;
+    TrackGenerator::generate(settings, controlPoints);
+    const GLuint numCurves = settings.numCurves;
+    const size_t numSamples = (size_t)numCurves * (CURVE_RESOLUTION + 1);
+
+    // read the track file, as at startup and on every hot reload
+    for (int format = 0; format < 2; format++) {
+        if (!TrackGeometry::saveControlPoints(TRACK_FILENAMES[format], controlPoints)) continue;
+        printResult(measure(LOAD_STAGES[format], numControlPoints, numControlPoints, [&](StageTimer& timer) {
+            std::vector<glm::vec3> loaded;
+            timer.start();
+            TrackGeometry::loadControlPoints(TRACK_FILENAMES[format], loaded);
+            timer.stop();
+        }), pCSV);
+        remove(TRACK_FILENAMES[format]);
+    }
+
+    // raw curve evaluation, without storing the samples
+    printResult(measure("evaluate", numControlPoints, numSamples, [&](StageTimer& timer) {
+        glm::vec3 total(0.0f);
+        timer.start();
+        for (GLuint i = 0; i < numCurves; i++) {
+            const glm::vec3* p = &controlPoints[3 * i];
+            for (GLuint j = 0; j <= CURVE_RESOLUTION; j++) {
+                total += TrackGeometry::evalBezierCurve(p[0], p[1], p[2], p[3], float(j) / CURVE_RESOLUTION);
+            }
+        }
+        timer.stop();
+        sink = total.x + total.y + total.z;
+    }), pCSV);
+
+    // sampling into curvePoints, as _createCurve and _applyTrackEdits do
+    printResult(measure("sample", numControlPoints, numSamples, [&](StageTimer& timer) {
+        std::vector<glm::vec3> samples;
+        for (GLuint firstCurve = 0; firstCurve < numCurves; firstCurve += BLOCK_CURVES) {
+            timer.start();
+            sampleBlock(controlPoints, firstCurve, std::min(BLOCK_CURVES, numCurves - firstCurve), samples);
+            timer.stop();
+        }
+        sink = samples.empty() ? 0.0f : samples.back().x;
+    }), pCSV);
+
+    // arc length table over the samples
+    printResult(measure("arclength", numControlPoints, numSamples, [&](StageTimer& timer) {
+        std::vector<glm::vec3> samples;
+        std::vector<GLfloat> arcLengths;
+        for (GLuint firstCurve = 0; firstCurve < numCurves; firstCurve += BLOCK_CURVES) {
+            sampleBlock(controlPoints, firstCurve, std::min(BLOCK_CURVES, numCurves - firstCurve), samples);
+            timer.start();
+            arcLengths.resize(samples.size());
+            TrackGeometry::computeArcLengths(samples.data(), samples.size(), 0, arcLengths.data());
+            timer.stop();
+        }
+        sink = arcLengths.empty() ? 0.0f : arcLengths.back();
+    }), pCSV);
+
+    // the cart riding sample by sample through a zone every ten curves, as _applyTrackZone does.
+    // Only the first block of the track, the zone count then grows with the track up to a block
+    const GLuint zoneCurves = std::min(BLOCK_CURVES, numCurves);
+    printResult(measure("zones", numControlPoints, (size_t)zoneCurves * (CURVE_RESOLUTION + 1), [&](StageTimer& timer) {
+        std::vector<glm::vec3> samples;
+        std::vector<GLfloat> arcLengths;
+        sampleBlock(controlPoints, 0, zoneCurves, samples);
+        arcLengths.resize(samples.size());
+        TrackGeometry::computeArcLengths(samples.data(), samples.size(), 0, arcLengths.data());
+
+        std::vector<TrackZones::Zone> zones;
+        for (GLuint curve = 0; curve < zoneCurves; curve += 10) {
+            const GLuint first = curve * (CURVE_RESOLUTION + 1);
+            const GLuint last = std::min(first + 5 * (CURVE_RESOLUTION + 1), (GLuint)samples.size() - 1);
+            if (arcLengths[first] < arcLengths[last]) {
+                zones.push_back({ arcLengths[first], arcLengths[last], static_cast<TrackZones::Action>(curve / 10 % TrackZones::NUM_ACTIONS), glm::vec3(0.0f) });
+            }
+        }
+        TrackZones trackZones;
+        trackZones.setZones(zones);
+        trackZones.setTrackLength(arcLengths.back());
+
+        GLuint numEvents = 0;
+        timer.start();
+        for (const GLfloat distance : arcLengths) {
+            trackZones.moveTo(distance);
+            numEvents += trackZones.getEvents().size();
+        }
+        timer.stop();
+        sink = (GLfloat)numEvents;
+    }), pCSV);
+
+    // tube sweep, per chunk bounds and packing, as _buildMonorailChunk does
+    const size_t numTubeVertices = numSamples * MONORAIL_SEGMENTS;
+    printResult(measure("sweep", numControlPoints, numTubeVertices, [&](StageTimer& timer) {
+        std::vector<glm::vec3> samples;
+        for (GLuint firstCurve = 0; firstCurve < numCurves; firstCurve += BLOCK_CURVES) {
+            sampleBlock(controlPoints, firstCurve, std::min(BLOCK_CURVES, numCurves - firstCurve), samples);
+            const GLuint numRings = samples.size();
+
+            timer.start();
+            // each block carries its own ring frame from its first sample
+            std::vector<glm::vec3> knotNormals(3 * (numRings / (CURVE_RESOLUTION + 1)) + 1);
+            TrackGeometry::computeKnotNormals(samples.data(), numRings / (CURVE_RESOLUTION + 1), CURVE_RESOLUTION, knotNormals.data());
+            std::vector<PackedVertex> vertices;
+            for (GLuint firstRing = 0; firstRing + 1 < numRings; firstRing += MONORAIL_CHUNK_RINGS) {
+                const GLuint lastRing = std::min(firstRing + MONORAIL_CHUNK_RINGS, numRings - 1);
+                std::vector<glm::vec3> positions((lastRing - firstRing + 1) * MONORAIL_SEGMENTS);
+                std::vector<glm::vec3> normals(positions.size());
+                TrackGeometry::sweepRings(samples.data(), numRings, knotNormals.data(), CURVE_RESOLUTION, firstRing, lastRing,
+                                          MONORAIL_RADIUS, MONORAIL_SEGMENTS, positions.data(), normals.data());
+
+                const PositionBounds bounds = VertexFormat::computeBounds(positions.data(), positions.size());
+                for (size_t v = 0; v < positions.size(); ++v) {
+                    vertices.push_back(VertexFormat::pack(positions[v], normals[v], glm::vec2(0.0f), bounds));
+                }
+            }
+            timer.stop();
+            sink = vertices.empty() ? 0.0f : vertices.back().position[0];
+        }
+    }), pCSV);
+
+    // ground height under every sample, the query that places the support beams
+    printResult(measure("ground", numControlPoints, numSamples, [&](StageTimer& timer) {
+        Heightfield heightfield;
+        std::vector<glm::vec3> samples;
+        GLfloat total = 0.0f;
+        for (GLuint firstCurve = 0; firstCurve < numCurves; firstCurve += BLOCK_CURVES) {
+            sampleBlock(controlPoints, firstCurve, std::min(BLOCK_CURVES, numCurves - firstCurve), samples);
+            timer.start();
+            for (const glm::vec3& sample : samples) {
+                total += heightfield.getHeight(sample.x, sample.z);
+            }
+            timer.stop();
+        }
+        sink = total;
+    }), pCSV);
+
+    // occlusion: rasterize the ground around the track start, then test a box per support beam
+    const size_t numBeams = (numSamples + BEAM_SPACING - 1) / BEAM_SPACING;
+    printResult(measure("occlusion", numControlPoints, numBeams, [&](StageTimer& timer) {
+        Heightfield heightfield;
+        const glm::vec3 eye = controlPoints[0] + glm::vec3(0.0f, 2.0f, 0.0f);
+        const glm::mat4 viewProjMtx = glm::perspective(45.0f, 2.0f, 0.1f, 1000.0f)
+                                    * glm::lookAt(eye, controlPoints[std::min<size_t>(3, controlPoints.size() - 1)], glm::vec3(0.0f, 1.0f, 0.0f));
+        constexpr GLuint GRID_CELLS = 4;
+        constexpr GLfloat GRID_SIZE = 32.0f;
+        GLfloat heights[(GRID_CELLS + 1) * (GRID_CELLS + 1)];
+        OcclusionCuller culler;
+        std::vector<glm::vec3> samples;
+        GLuint numVisible = 0;
+
+        timer.start();
+        culler.beginFrame(viewProjMtx);
+        for (GLfloat z = -256.0f; z < 256.0f; z += GRID_SIZE) {
+            for (GLfloat x = -256.0f; x < 256.0f; x += GRID_SIZE) {
+                for (GLuint v = 0; v < (GRID_CELLS + 1) * (GRID_CELLS + 1); v++) {
+                    heights[v] = heightfield.getHeight(x + v % (GRID_CELLS + 1) * (GRID_SIZE / GRID_CELLS),
+                                                       z + v / (GRID_CELLS + 1) * (GRID_SIZE / GRID_CELLS));
+                }
+                culler.rasterizeHeightGrid(glm::vec2(x, z), GRID_SIZE, GRID_CELLS, heights);
+            }
+        }
+        culler.buildPyramid();
+        timer.stop();
+
+        for (GLuint firstCurve = 0; firstCurve < numCurves; firstCurve += BLOCK_CURVES) {
+            sampleBlock(controlPoints, firstCurve, std::min(BLOCK_CURVES, numCurves - firstCurve), samples);
+            const size_t firstSample = (size_t)firstCurve * (CURVE_RESOLUTION + 1);
+            timer.start();
+            for (size_t s = (BEAM_SPACING - firstSample % BEAM_SPACING) % BEAM_SPACING; s < samples.size(); s += BEAM_SPACING) {
+                const glm::vec3& top = samples[s];
+                numVisible += culler.isVisible(glm::vec3(top.x - 0.25f, 0.0f, top.z - 0.25f), glm::vec3(top.x + 0.25f, top.y, top.z + 0.25f));
+            }
+            timer.stop();
+        }
+        sink = (GLfloat)numVisible;
+    }), pCSV);
+
+    // per object matrices, one object per control point like the control point spheres, up to MAX_OBJECTS
+    const GLuint numObjects = std::min(MAX_OBJECTS, numControlPoints);
+    const Transform::ViewTransform view = Transform::makeViewTransform(
+        glm::lookAt(glm::vec3(0.0f, 20.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+        glm::perspective(45.0f, 640.0f / 480.0f, 0.001f, 1000.0f));
+    std::vector<glm::mat4> modelMatrices(numObjects);
+    for (GLuint i = 0; i < numObjects; i++) {
+        modelMatrices[i] = glm::translate(glm::mat4(1.0f), controlPoints[i % controlPoints.size()]);
+    }
+
+    // reference: full product chain and 4x4 inverse per object
+    printResult(measure("matrix-ref", numControlPoints, numObjects, [&](StageTimer& timer) {
+        GLfloat total = 0.0f;
+        timer.start();
+        for (const glm::mat4& modelMtx : modelMatrices) {
+            const glm::mat4 mvpMtx = view.projMtx * view.viewMtx * modelMtx;
+            const glm::mat3 normalMtx = glm::mat3(glm::transpose(glm::inverse(modelMtx)));
+            total += mvpMtx[3][0] + normalMtx[0][0];
+        }
+        timer.stop();
+        sink = total;
+    }), pCSV);
+
+    // cached view-projection and 3x3 inverse-transpose, one object at a time
+    printResult(measure("matrices", numControlPoints, numObjects, [&](StageTimer& timer) {
+        glm::mat4 mvpMtx, modelViewMtx;
+        GLfloat total = 0.0f;
+        timer.start();
+        for (const glm::mat4& modelMtx : modelMatrices) {
+            Transform::computeMatrixUniforms(view, modelMtx, mvpMtx, modelViewMtx);
+            const glm::mat3 normalMtx = Transform::normalMatrix(modelMtx);
+            total += mvpMtx[3][0] + normalMtx[0][0];
+        }
+        timer.stop();
+        sink = total;
+    }), pCSV);
+
+    // view dependent products for the whole set as one batch, as the support beams are drawn
+    printResult(measure("matrix-batch", numControlPoints, numObjects, [&](StageTimer& timer) {
+        std::vector<glm::mat4> mvpMatrices(numObjects), modelViewMatrices(numObjects);
+        timer.start();
+        Transform::computeMatrixUniforms(view, modelMatrices.data(), modelMatrices.size(), mvpMatrices.data(), modelViewMatrices.data());
+        timer.stop();
+        sink = mvpMatrices.back()[3][0] + modelViewMatrices.back()[3][0];
+    }), pCSV);
+
+    // scene update with one object in a hundred moving, the cached matrices of the rest are kept
+    SceneRegistry scene;
+    for (GLuint i = 0; i < numObjects; i++) {
+        scene.create(controlPoints[i]);
+    }
+    scene.update();
+    const GLuint numMoving = std::max(1u, scene.getNumEntities() / 100);
+    GLfloat offset = 0.0f;
+    printResult(measure("scene", numControlPoints, numMoving, [&](StageTimer& timer) {
+        offset += 1.0f;
+        timer.start();
+        for (GLuint i = 0; i < numMoving; i++) {
+            const SceneRegistry::Entity entity = i * 100 % scene.getNumEntities();
+            scene.setTranslation(entity, controlPoints[entity] + glm::vec3(0.0f, offset, 0.0f));
+        }
+        scene.update();
+        timer.stop();
+        sink = scene.getModelMatrix(0)[3][1];
+    }), pCSV);
+}
+
+///*****************************************************************************
+//
+// Our main function
+int main(int argc, char* argv[]) {
+    GLuint minControlPoints = 10;
+    GLuint maxControlPoints = 10000000;
+    FILE* pCSV = nullptr;
+
+    bool validArguments = true;
+    for (int i = 1; i < argc && validArguments; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value && strcmp(argv[i], "--min") == 0) {
+            validArguments = parseControlPoints(value, minControlPoints);
+            i++;
+        } else if (value && strcmp(argv[i], "--max") == 0) {
+            validArguments = parseControlPoints(value, maxControlPoints);
+            i++;
+        } else if (value && strcmp(argv[i], "--csv") == 0) {
+            if (pCSV) fclose(pCSV);
+            pCSV = fopen(value, "w");
+            if (!pCSV) fprintf(stderr, "[ERROR]: Could not create \"%s\"\n", value);
+            i++;
+        } else {
+            validArguments = false;
+        }
+    }
+    // every decade needs at least one whole curve, and counting up from min must reach max
+    if (!validArguments || minControlPoints > maxControlPoints) {
+        fprintf(stderr, "usage: %s [--min N] [--max N] [--csv FILE]\n"
+                        "       %u <= min <= max control points\n", argv[0], MIN_CONTROL_POINTS);
+        if (pCSV) fclose(pCSV);
+        return EXIT_FAILURE;
+    }
+
+    // a tube that breaks on a loop or a tree that misses the nearest segment is a bug, not a timing
+    if (!checkRingFrames() || !checkNearestPoints()) {
+        if (pCSV) fclose(pCSV);
+        return EXIT_FAILURE;
+    }
+
+    if (pCSV) {
+        fprintf(pCSV, "stage,control_points,items,repetitions,ms_per_run,items_per_second,allocations_per_run,bytes_per_run\n");
+    }
+    fprintf(stdout, "%-10s %10s %12s %7s %12s %10s %10s %10s %8s\n",
+            "stage", "points", "items", "runs", "ms/run", "Mitems/s", "allocs", "KiB", "ns/item");
+
+    // decades of control points, each a whole number of cubic curves (10^k = 3n + 1)
+    for (GLuint numControlPoints = minControlPoints; numControlPoints <= maxControlPoints; numControlPoints *= 10) {
+        const GLuint wholeCurves = std::max<GLuint>(4, ((numControlPoints - 1) / 3) * 3 + 1);
+        benchmarkTrack(wholeCurves, pCSV);
+        if (numControlPoints > maxControlPoints / 10) break;
+    }
+
+    if (pCSV) fclose(pCSV);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,127 @@
+#include "TrackBuilder.h"
+
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <cstdio>
+
+TrackBuilder::TrackBuilder()
+    : _samplesPerCurve(0),
+      _segments(0),
+      _chunkRings(0),
+      _sampleProgram(nullptr),
+      _sampleOffsetLocation(-1),
+      _firstCurveLocation(-1),
+      _numSamplesLocation(-1),
+      _sweepProgram(nullptr),
+      _sweepOffsetLocation(-1),
+      _firstChunkLocation(-1),
+      _numVerticesLocation(-1),
+      _numRingsLocation(-1),
+      _boundsBuffer(0),
+      _boundsCapacity(0)
+{
+}
+
+TrackBuilder::~TrackBuilder()
+{
+    glDeleteBuffers(1, &_boundsBuffer);
+    delete _sampleProgram;
+    delete _sweepProgram;
+}
+
+bool TrackBuilder::setup(const GLuint resolution, const GLfloat radius, const GLint segments, const GLuint chunkRings)
+{
+    if (!GLStateCache::hasGL43()) {
+        fprintf(stderr, "[ERROR]: the GPU track builder needs compute shaders from GL 4.3\n");
+        return false;
+    }
+    _samplesPerCurve = resolution + 1;
+    _segments = segments;
+    _chunkRings = chunkRings;
+
+    _sampleProgram = new CSCI441::ComputeShaderProgram("shaders/fp-track-sample.c.glsl");
+    _sampleOffsetLocation = _sampleProgram->getUniformLocation("invocationOffset");
+    _firstCurveLocation = _sampleProgram->getUniformLocation("firstCurve");
+    _numSamplesLocation = _sampleProgram->getUniformLocation("numSamples");
+
+    _sweepProgram = new CSCI441::ComputeShaderProgram("shaders/fp-track-sweep.c.glsl");
+    _sweepOffsetLocation = _sweepProgram->getUniformLocation("invocationOffset");
+    _firstChunkLocation = _sweepProgram->getUniformLocation("firstChunk");
+    _numVerticesLocation = _sweepProgram->getUniformLocation("numVertices");
+    _numRingsLocation = _sweepProgram->getUniformLocation("numRings");
+
+    if (_numSamplesLocation < 0 || _numVerticesLocation < 0) {
+        fprintf(stderr, "[ERROR]: Could not build the track builder compute programs\n");
+        return false;
+    }
+
+    _sampleProgram->setProgramUniform("resolution", static_cast<GLint>(resolution));
+    _sweepProgram->setProgramUniform("radius", radius);
+    _sweepProgram->setProgramUniform("segments", segments);
+    _sweepProgram->setProgramUniform("chunkRings", static_cast<GLint>(chunkRings));
+    _sweepProgram->setProgramUniform("resolution", static_cast<GLint>(resolution));
+
+    glGenBuffers(1, &_boundsBuffer);
+    fprintf(stdout, "[INFO]: track geometry is built on the GPU\n");
+    return true;
+}
+
+void TrackBuilder::sampleCurves(const GLuint controlPointBuffer, const GLuint sampleBuffer, const GLuint firstCurve, const GLuint numCurves)
+{
+    if (numCurves == 0) return;
+
+    _sampleProgram->setProgramUniform(_firstCurveLocation, static_cast<GLint>(firstCurve));
+    _sampleProgram->setProgramUniform(_numSamplesLocation, static_cast<GLint>(numCurves * _samplesPerCurve));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, controlPointBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, sampleBuffer);
+    _dispatch(_sampleProgram, _sampleOffsetLocation, numCurves * _samplesPerCurve);
+
+    // the samples are swept next and drawn as the curve line
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void TrackBuilder::sweepChunks(const GLuint sampleBuffer, const GLuint numSamples, const GLuint knotNormalBuffer, const GLuint vertexBuffer,
+                               const GLuint firstChunk, const GLuint numChunks, const PositionBounds* bounds, const size_t stride)
+{
+    if (numChunks == 0) return;
+
+    // origin and extent as vec4 pairs, the std430 layout of a vec3 array pads each entry anyway
+    const auto* bytes = reinterpret_cast<const unsigned char*>(bounds);
+    _boundsData.resize(2 * numChunks);
+    for (GLuint c = 0; c < numChunks; c++) {
+        const PositionBounds& chunkBounds = *reinterpret_cast<const PositionBounds*>(bytes + c * stride);
+        _boundsData[2 * c] = glm::vec4(chunkBounds.origin, 0.0f);
+        _boundsData[2 * c + 1] = glm::vec4(chunkBounds.extent, 0.0f);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _boundsBuffer);
+    if (numChunks > _boundsCapacity) {
+        _boundsCapacity = std::max(numChunks, 2 * _boundsCapacity);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, 2 * _boundsCapacity * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _boundsData.size() * sizeof(glm::vec4), _boundsData.data());
+
+    const GLuint numVertices = numChunks * (_chunkRings + 1) * _segments;
+    _sweepProgram->setProgramUniform(_firstChunkLocation, static_cast<GLint>(firstChunk));
+    _sweepProgram->setProgramUniform(_numVerticesLocation, static_cast<GLint>(numVertices));
+    _sweepProgram->setProgramUniform(_numRingsLocation, static_cast<GLint>(numSamples));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, sampleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, vertexBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, _boundsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, knotNormalBuffer);
+    _dispatch(_sweepProgram, _sweepOffsetLocation, numVertices);
+
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void TrackBuilder::_dispatch(CSCI441::ComputeShaderProgram* pProgram, const GLint invocationOffsetLocation, const GLuint count) const
+{
+    // a track of millions of samples needs more work groups than one dispatch may have
+    pProgram->useProgram();
+    const GLuint maxInvocations = MAX_WORK_GROUPS * WORK_GROUP_SIZE;
+    for (GLuint offset = 0; offset < count; offset += maxInvocations) {
+        const GLuint invocations = std::min(count - offset, maxInvocations);
+        pProgram->setProgramUniform(invocationOffsetLocation, static_cast<GLint>(offset));
+        glDispatchCompute((invocations + WORK_GROUP_SIZE - 1) / WORK_GROUP_SIZE, 1, 1);
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef TRACK_BUILDER_H
+#define TRACK_BUILDER_H
+
+#include "VertexFormat.h"
+
+#include <CSCI441/ComputeShaderProgram.hpp>
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class TrackBuilder
+/// \desc Builds the track's vertex data on the GPU with compute shaders, writing straight into
+/// the buffers the renderer draws from.  The control points are read from the cage VBO bound as
+/// a shader storage buffer, one pass samples the curves into the curve VBO, and a second pass
+/// sweeps a ring frame around every sample and packs the tube vertices into the monorail VBO
+/// with the same layout the CPU builds.  Only the knot normals the ring frames are blended from
+/// come from the CPU, one per control point.  Needs GL 4.3
+class TrackBuilder {
+public:
+    /// \desc creates the builder, call setup() once a context is current
+    TrackBuilder();
+    /// \desc releases the programs and the chunk bounds buffer
+    ~TrackBuilder();
+
+    TrackBuilder(const TrackBuilder&) = delete;
+    TrackBuilder& operator=(const TrackBuilder&) = delete;
+
+    /// \desc compiles the compute programs
+    /// \param resolution segments each curve is sampled into, so resolution + 1 samples a curve
+    /// \param radius tube radius
+    /// \param segments vertices around each ring
+    /// \param chunkRings rings per monorail chunk, each chunk storing chunkRings + 1 rings
+    /// \returns false if the context has no compute shaders or the programs did not build
+    bool setup(GLuint resolution, GLfloat radius, GLint segments, GLuint chunkRings);
+
+    /// \desc samples a run of curves into a buffer of tightly packed vec3 samples
+    /// \param controlPointBuffer buffer of tightly packed vec3 control points
+    /// \param sampleBuffer buffer to write the samples of every curve to
+    /// \param firstCurve first curve to sample
+    /// \param numCurves number of curves to sample
+    void sampleCurves(GLuint controlPointBuffer, GLuint sampleBuffer, GLuint firstCurve, GLuint numCurves);
+
+    /// \desc sweeps and packs the rings of a run of monorail chunks
+    /// \param sampleBuffer buffer of tightly packed vec3 curve samples
+    /// \param numSamples number of samples in the buffer
+    /// \param knotNormalBuffer buffer of tightly packed vec3 knot normals, one per control point
+    /// as TrackGeometry::computeKnotNormals stores them
+    /// \param vertexBuffer buffer of PackedVertex to write the chunks to, chunk c starting at
+    /// vertex c * (chunkRings + 1) * segments
+    /// \param firstChunk first chunk to build
+    /// \param numChunks number of chunks to build
+    /// \param bounds decode box of each chunk built, which every vertex of the chunk must fit
+    /// \param stride distance in bytes between consecutive boxes
+    void sweepChunks(GLuint sampleBuffer, GLuint numSamples, GLuint knotNormalBuffer, GLuint vertexBuffer,
+                     GLuint firstChunk, GLuint numChunks, const PositionBounds* bounds, size_t stride = sizeof(PositionBounds));
+
+private:
+    /// \desc runs a program over count invocations, in as many dispatches as the work group
+    /// limit needs
+    void _dispatch(CSCI441::ComputeShaderProgram* pProgram, GLint invocationOffsetLocation, GLuint count) const;
+
+    /// \desc invocations per work group, must match local_size_x in the compute shaders
+    static constexpr GLuint WORK_GROUP_SIZE = 64;
+    /// \desc work groups per dispatch, the minimum every GL 4.3 driver allows
+    static constexpr GLuint MAX_WORK_GROUPS = 65535;
+
+    GLuint _samplesPerCurve;
+    GLint _segments;
+    GLuint _chunkRings;
+
+    CSCI441::ComputeShaderProgram* _sampleProgram;
+    GLint _sampleOffsetLocation;
+    GLint _firstCurveLocation;
+    GLint _numSamplesLocation;
+
+    CSCI441::ComputeShaderProgram* _sweepProgram;
+    GLint _sweepOffsetLocation;
+    GLint _firstChunkLocation;
+    GLint _numVerticesLocation;
+    GLint _numRingsLocation;
+
+    /// \desc origin and extent of each chunk being swept
+    GLuint _boundsBuffer;
+    GLuint _boundsCapacity;
+    std::vector<glm::vec4> _boundsData;
+};
+
+#endif // TRACK_BUILDER_H
@@ -0,0 +1,106 @@
+#include "TrackGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+    /// \desc arm length that makes a cubic Bezier quarter arc approximate a circle
+    constexpr GLfloat QUARTER_CIRCLE_ARM = 0.5523f;
+
+    /// \desc point the track passes through, with the tangent and arm length both curves
+    /// meeting there use
+    struct Knot {
+        glm::vec3 position;
+        glm::vec3 tangent;
+        GLfloat arm;
+    };
+
+    /// \desc uniform float in [0, 1) from the top 24 bits of the generator, which unlike
+    /// std::uniform_real_distribution is the same on every standard library
+    GLfloat uniform(std::mt19937& random) {
+        return (random() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    /// \desc uniform float in [-1, 1)
+    GLfloat signedUniform(std::mt19937& random) {
+        return uniform(random) * 2.0f - 1.0f;
+    }
+}
+
+void TrackGenerator::generate(const Settings& settings, std::vector<glm::vec3>& controlPoints) {
+    std::mt19937 random(settings.seed);
+    const glm::vec3 up(0.0f, 1.0f, 0.0f);
+
+    std::vector<Knot> knots;
+    knots.reserve(settings.numCurves + 1);
+
+    // start on the ground heading along +x, well inside the extent
+    GLfloat heading = 0.0f;
+    knots.push_back({glm::vec3(-0.5f * settings.extent, settings.minHeight, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), settings.curveLength / 3.0f});
+
+    while (knots.size() <= settings.numCurves) {
+        const GLuint remainingCurves = settings.numCurves + 1 - knots.size();
+        const glm::vec3 position = knots.back().position;
+        glm::vec3 direction(cosf(heading), 0.0f, sinf(heading));
+        const GLfloat event = uniform(random);
+
+        if (remainingCurves >= 4 && event < settings.loopChance) {
+            // vertical loop: enter level, quarter arcs up, over and back down, leaving beside the
+            // entry point so the track does not run through itself
+            const GLfloat radius = settings.loopRadius;
+            const glm::vec3 side = glm::normalize(glm::cross(direction, up));
+            const GLfloat offset = radius * 0.5f;
+            const GLfloat arm = QUARTER_CIRCLE_ARM * radius;
+
+            knots.back().tangent = direction;
+            knots.push_back({position + direction * radius + up * radius + side * (offset * 0.25f), up, arm});
+            knots.push_back({position + up * (2.0f * radius) + side * (offset * 0.5f), -direction, arm});
+            knots.push_back({position - direction * radius + up * radius + side * (offset * 0.75f), -up, arm});
+            knots.push_back({position + side * offset, direction, settings.curveLength / 3.0f});
+            continue;
+        }
+
+        // turn a little, and steer back towards the middle once near the edge of the extent
+        heading += signedUniform(random) * settings.maxTurn;
+        const glm::vec2 flat(position.x, position.z);
+        if (glm::length(flat) > 0.7f * settings.extent) {
+            const GLfloat toCenter = atan2f(-position.z, -position.x);
+            GLfloat difference = toCenter - heading;
+            difference = atan2f(sinf(difference), cosf(difference));
+            heading += 0.5f * difference;
+        }
+        direction = glm::vec3(cosf(heading), 0.0f, sinf(heading));
+
+        GLfloat height;
+        GLfloat length = settings.curveLength;
+        if (event < settings.loopChance + settings.dropChance && position.y - settings.minHeight > settings.curveLength) {
+            // steep drop to the ground, leveling out at the bottom
+            height = settings.minHeight;
+            length *= 1.2f;
+        } else {
+            height = position.y + signedUniform(random) * settings.curveLength * 0.4f;
+            // after a drop, climb back up on a lift hill
+            if (position.y <= settings.minHeight + 0.5f && event < 0.5f) {
+                height = position.y + settings.curveLength * 0.6f;
+            }
+            height = glm::clamp(height, settings.minHeight, settings.maxHeight);
+        }
+
+        glm::vec3 next = position + direction * length;
+        next.y = height;
+        const glm::vec3 tangent = height == settings.minHeight ? direction : glm::normalize(next - position);
+        knots.push_back({next, tangent, length / 3.0f});
+    }
+
+    // each curve runs between two knots, taking its inner control points from their arms
+    controlPoints.resize(3 * settings.numCurves + 1);
+    controlPoints[0] = knots[0].position;
+    for (GLuint i = 0; i < settings.numCurves; i++) {
+        const Knot& start = knots[i];
+        const Knot& end = knots[i + 1];
+        controlPoints[3 * i + 1] = start.position + start.tangent * start.arm;
+        controlPoints[3 * i + 2] = end.position - end.tangent * end.arm;
+        controlPoints[3 * i + 3] = end.position;
+    }
+}
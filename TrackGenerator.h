@@ -0,0 +1,45 @@
+#ifndef TRACK_GENERATOR_H
+#define TRACK_GENERATOR_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \desc Procedural roller coaster tracks for scale and stress testing.  Tracks are built from
+/// knots that each carry a position, a unit tangent and an arm length; every curve takes its
+/// inner control points from the arms of its two knots, so consecutive curves always share a
+/// tangent and the whole track is C1 continuous.  Generation uses its own uniform mapping of
+/// std::mt19937, so a seed produces the same track with any standard library
+namespace TrackGenerator {
+    /// \desc knobs controlling the shape of a generated track
+    struct Settings {
+        /// \desc number of cubic curves to emit, the track has 3 * numCurves + 1 control points
+        GLuint numCurves = 1000;
+        /// \desc random seed, the same settings and seed always give the same track
+        GLuint seed = 1;
+        /// \desc the track stays within [-extent, extent] on x and z
+        GLfloat extent = 100.0f;
+        /// \desc lowest and highest point the track runs at, loops excepted
+        GLfloat minHeight = 2.0f;
+        GLfloat maxHeight = 30.0f;
+        /// \desc horizontal length of an ordinary curve
+        GLfloat curveLength = 8.0f;
+        /// \desc largest change of heading across one ordinary curve, in radians
+        GLfloat maxTurn = 0.6f;
+        /// \desc chance that a curve starts a four curve vertical loop
+        GLfloat loopChance = 0.02f;
+        /// \desc radius of vertical loops
+        GLfloat loopRadius = 6.0f;
+        /// \desc chance that a curve is a steep drop to minHeight
+        GLfloat dropChance = 0.05f;
+    };
+
+    /// \desc generates a track
+    /// \param settings shape of the track
+    /// \param [out] controlPoints 3 * settings.numCurves + 1 control points
+    void generate(const Settings& settings, std::vector<glm::vec3>& controlPoints);
+}
+
+#endif // TRACK_GENERATOR_H
@@ -0,0 +1,209 @@
+#include "TrackGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265f
+#endif
+
+namespace {
+    /// \desc header of a binary .trk track, followed by numControlPoints xyz float triples
+    struct TrackFileHeader {
+        char magic[4];
+        GLuint version;
+        GLuint numControlPoints;
+    };
+    constexpr char TRACK_MAGIC[4] = {'F', 'P', 'T', 'K'};
+    constexpr GLuint TRACK_VERSION = 1;
+
+    /// \desc whole cubic curves need 3n + 1 points
+    bool isWholeCurves(const GLuint numPoints) {
+        return numPoints >= 4 && (numPoints - 1) % 3 == 0;
+    }
+
+    bool hasExtension(const char* FILENAME, const char* EXTENSION) {
+        const size_t nameLength = strlen(FILENAME);
+        const size_t extensionLength = strlen(EXTENSION);
+        return nameLength >= extensionLength && strcmp(FILENAME + nameLength - extensionLength, EXTENSION) == 0;
+    }
+}
+
+bool TrackGeometry::loadControlPoints(const char* FILENAME, std::vector<glm::vec3>& controlPoints) {
+    FILE* file = fopen(FILENAME, "rb");
+    if (!file) {
+        fprintf(stderr, "[ERROR]: Could not open \"%s\"\n", FILENAME);
+        return false;
+    }
+
+    bool valid;
+    TrackFileHeader header;
+    if (fread(&header, sizeof(TrackFileHeader), 1, file) == 1 && memcmp(header.magic, TRACK_MAGIC, sizeof(TRACK_MAGIC)) == 0) {
+        // binary track: every point in one read
+        valid = header.version == TRACK_VERSION && isWholeCurves(header.numControlPoints);
+        controlPoints.resize(valid ? header.numControlPoints : 0);
+        valid = valid && fread(controlPoints.data(), sizeof(glm::vec3), controlPoints.size(), file) == controlPoints.size();
+    } else {
+        // text track: first value is the number of points
+        rewind(file);
+        unsigned int numPoints = 0;
+        valid = fscanf(file, "%u\n", &numPoints) == 1 && isWholeCurves(numPoints);
+
+        controlPoints.resize(valid ? numPoints : 0);
+        for (unsigned int i = 0; valid && i < numPoints; i++) {
+            // each line is formatted as "x,y,z\n" as comma seperated floats
+            valid = fscanf(file, "%f,%f,%f\n", &controlPoints[i].x, &controlPoints[i].y, &controlPoints[i].z) == 3;
+        }
+    }
+    fclose(file);
+
+    if (!valid) {
+        fprintf(stderr, "[ERROR]: \"%s\" does not contain a valid set of control points\n", FILENAME);
+    }
+    return valid;
+}
+
+bool TrackGeometry::saveControlPoints(const char* FILENAME, const std::vector<glm::vec3>& controlPoints) {
+    const bool binary = hasExtension(FILENAME, ".trk");
+    FILE* file = fopen(FILENAME, binary ? "wb" : "w");
+    if (!file) {
+        fprintf(stderr, "[ERROR]: Could not create \"%s\"\n", FILENAME);
+        return false;
+    }
+
+    bool written;
+    if (binary) {
+        TrackFileHeader header = {{TRACK_MAGIC[0], TRACK_MAGIC[1], TRACK_MAGIC[2], TRACK_MAGIC[3]}, TRACK_VERSION, (GLuint)controlPoints.size()};
+        written = fwrite(&header, sizeof(TrackFileHeader), 1, file) == 1
+                  && fwrite(controlPoints.data(), sizeof(glm::vec3), controlPoints.size(), file) == controlPoints.size();
+    } else {
+        written = fprintf(file, "%zu\n", controlPoints.size()) > 0;
+        for (size_t i = 0; written && i < controlPoints.size(); i++) {
+            written = fprintf(file, "%f, %f, %f\n", controlPoints[i].x, controlPoints[i].y, controlPoints[i].z) > 0;
+        }
+    }
+    written = fclose(file) == 0 && written;
+
+    if (!written) {
+        fprintf(stderr, "[ERROR]: Could not write control points to \"%s\"\n", FILENAME);
+    }
+    return written;
+}
+
+glm::vec3 TrackGeometry::evalBezierCurve(const glm::vec3 p0, const glm::vec3 p1, const glm::vec3 p2, const glm::vec3 p3, const GLfloat t) {
+    return float(pow((1-t), 3))*p0 + 3*float(pow((1-t), 2))*t*p1 + 3*(1-t)*float(pow(t, 2))*p2 + float(pow(t,3))*p3;
+}
+
+void TrackGeometry::sampleCurve(const glm::vec3* controlPoints, const GLuint curveIndex, const GLuint resolution, glm::vec3* samples) {
+    const GLuint startIdx = 3 * curveIndex;
+    const glm::vec3 p0 = controlPoints[startIdx];
+    const glm::vec3 p1 = controlPoints[startIdx + 1];
+    const glm::vec3 p2 = controlPoints[startIdx + 2];
+    const glm::vec3 p3 = controlPoints[startIdx + 3];
+
+    for (GLuint j = 0; j <= resolution; j++) {
+        const float t = float(j) / resolution;
+        samples[j] = evalBezierCurve(p0, p1, p2, p3, t);
+    }
+}
+
+glm::vec3 TrackGeometry::ringTangent(const glm::vec3* samples, const GLuint numSamples, const GLuint ring) {
+    for (GLuint r = ring; ; --r) {
+        const glm::vec3 delta = (r + 1 < numSamples) ? samples[r + 1] - samples[r] : samples[r] - samples[r - 1];
+        if (glm::length(delta) > 1e-6f) {
+            return glm::normalize(delta);
+        }
+        if (r == 0) break;
+    }
+    return glm::vec3(1.0f, 0.0f, 0.0f);
+}
+
+glm::vec3 TrackGeometry::ringNormal(const glm::vec3 tangent) {
+    const glm::vec3 up = fabsf(tangent.y) > 0.999f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    return glm::normalize(glm::cross(tangent, up));
+}
+
+glm::vec3 TrackGeometry::carryNormal(const glm::vec3 normal, const glm::vec3 tangent) {
+    const glm::vec3 projected = normal - glm::dot(normal, tangent) * tangent;
+    return glm::length(projected) > 1e-3f ? glm::normalize(projected) : ringNormal(tangent);
+}
+
+glm::vec3 TrackGeometry::ringNormal(const glm::vec3 tangent, const glm::vec3 startNormal, const glm::vec3 endNormal, const GLfloat t) {
+    return carryNormal(glm::mix(startNormal, endNormal, t), tangent);
+}
+
+void TrackGeometry::computeKnotNormals(const glm::vec3* samples, const GLuint numCurves, const GLuint resolution, glm::vec3* knotNormals) {
+    if (numCurves == 0) return;
+    const GLuint numSamples = numCurves * (resolution + 1);
+
+    // small steps between samples keep the carried normal close to a rotation minimising frame
+    glm::vec3 normal = ringNormal(ringTangent(samples, numSamples, 0));
+    knotNormals[0] = normal;
+    for (GLuint i = 0; i < numCurves; i++) {
+        const GLuint curveStart = i * (resolution + 1);
+        for (GLuint j = 1; j <= resolution; j++) {
+            normal = carryNormal(normal, ringTangent(samples, numSamples, curveStart + j));
+        }
+        // the next curve starts on a repeated sample, whose tangent is its own first step
+        normal = carryNormal(normal, ringTangent(samples, numSamples, std::min(curveStart + resolution + 1, numSamples - 1)));
+        knotNormals[3 * (i + 1)] = normal;
+    }
+}
+
+void TrackGeometry::updateKnotNormals(const glm::vec3* samples, const GLuint numCurves, const GLuint resolution,
+                                      const GLuint firstCurve, const GLuint lastCurve, glm::vec3* knotNormals) {
+    const GLuint numSamples = numCurves * (resolution + 1);
+    for (GLuint knot = firstCurve; knot <= lastCurve + 1; knot++) {
+        const GLuint sample = std::min(knot * (resolution + 1), numSamples - 1);
+        knotNormals[3 * knot] = carryNormal(knotNormals[3 * knot], ringTangent(samples, numSamples, sample));
+    }
+}
+
+void TrackGeometry::sweepRings(const glm::vec3* samples, const GLuint numSamples, const glm::vec3* knotNormals, const GLuint resolution,
+                               const GLuint firstRing, const GLuint lastRing,
+                               const GLfloat radius, const GLint segments, glm::vec3* positions, glm::vec3* normals) {
+    for (GLuint i = firstRing; i <= lastRing; ++i) {
+        const glm::vec3 point = samples[i];
+        const glm::vec3 tangent = ringTangent(samples, numSamples, i);
+
+        const GLuint curve = i / (resolution + 1);
+        const GLfloat t = float(i % (resolution + 1)) / resolution;
+        const glm::vec3 normal = ringNormal(tangent, knotNormals[3 * curve], knotNormals[3 * curve + 3], t);
+        const glm::vec3 binormal = glm::cross(tangent, normal);
+
+        // Generate circle vertices at this point
+        for (int j = 0; j < segments; ++j) {
+            const float angle = j * 2.0f * M_PI / segments;
+            const glm::vec3 direction = cosf(angle) * normal + sinf(angle) * binormal;
+            *positions++ = point + radius * direction;
+            *normals++ = direction;
+        }
+    }
+}
+
+void TrackGeometry::sweepBounds(const glm::vec3* samples, const GLuint firstRing, const GLuint lastRing, const GLfloat radius,
+                                glm::vec3& boxMin, glm::vec3& boxMax) {
+    boxMin = samples[firstRing];
+    boxMax = samples[firstRing];
+    for (GLuint i = firstRing + 1; i <= lastRing; ++i) {
+        boxMin = glm::min(boxMin, samples[i]);
+        boxMax = glm::max(boxMax, samples[i]);
+    }
+    // every ring vertex is a unit direction times the radius away from its sample
+    boxMin = boxMin - glm::vec3(radius);
+    boxMax = boxMax + glm::vec3(radius);
+}
+
+void TrackGeometry::computeArcLengths(const glm::vec3* samples, const GLuint numSamples, GLuint firstSample, GLfloat* arcLengths) {
+    if (numSamples == 0) return;
+
+    if (firstSample == 0) {
+        arcLengths[0] = 0.0f;
+        firstSample = 1;
+    }
+    for (GLuint i = firstSample; i < numSamples; i++) {
+        arcLengths[i] = arcLengths[i - 1] + glm::length(samples[i] - samples[i - 1]);
+    }
+}
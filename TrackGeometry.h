@@ -0,0 +1,116 @@
+#ifndef TRACK_GEOMETRY_H
+#define TRACK_GEOMETRY_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \desc CPU side of the track pipeline: parsing control points, evaluating and sampling the
+/// Bezier curves and sweeping the monorail tube.  Nothing here touches OpenGL, so the same
+/// code runs in the engine and in the fp-bench microbenchmarks
+namespace TrackGeometry {
+    /// \desc reads a control point file.  Text files hold a point count on the first line
+    /// followed by one "x, y, z" point per line; binary .trk files start with the magic "FPTK",
+    /// a version and the point count, followed by packed xyz floats.  The format is detected
+    /// from the file contents
+    /// \param FILENAME file to read
+    /// \param [out] controlPoints points read in
+    /// \returns false if the file is missing, truncated or does not describe whole curves
+    bool loadControlPoints(const char* FILENAME, std::vector<glm::vec3>& controlPoints);
+    /// \desc writes a control point file, binary if the name ends in .trk and text otherwise
+    /// \param FILENAME file to create
+    /// \param controlPoints points to write
+    /// \returns false if the file could not be written
+    bool saveControlPoints(const char* FILENAME, const std::vector<glm::vec3>& controlPoints);
+
+    /// \desc solves the cubic Bezier curve equation for four control points at t
+    glm::vec3 evalBezierCurve(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, GLfloat t);
+
+    /// \desc evaluates resolution + 1 evenly spaced samples of one curve
+    /// \param controlPoints control points of the whole track, curve i uses 3i .. 3i + 3
+    /// \param curveIndex curve to sample
+    /// \param resolution number of segments the curve is split into
+    /// \param [out] samples resolution + 1 points along the curve
+    void sampleCurve(const glm::vec3* controlPoints, GLuint curveIndex, GLuint resolution, glm::vec3* samples);
+
+    /// \desc tangent used to orient a tube ring.  Consecutive curves share an end point
+    /// sample, so a ring with a zero length step reuses the tangent of the ring before it
+    /// \param samples curve samples in track order
+    /// \param numSamples number of samples, at least two
+    /// \param ring index of the ring / sample
+    glm::vec3 ringTangent(const glm::vec3* samples, GLuint numSamples, GLuint ring);
+
+    /// \desc normal of a ring frame with no frame to carry on from: at right angles to the
+    /// tangent and +Y, or to +X where the tangent is too close to vertical for +Y to give one
+    glm::vec3 ringNormal(glm::vec3 tangent);
+    /// \desc turns a ring normal onto the plane at right angles to a new tangent as little as
+    /// possible, which is how the frame is carried along the track without twisting.  Falls
+    /// back to ringNormal() if the normal was along the tangent
+    glm::vec3 carryNormal(glm::vec3 normal, glm::vec3 tangent);
+    /// \desc normal of the ring frame at a point on a curve: the normals at the curve's end
+    /// points blended and carried onto the tangent there.  The CPU sweep, the compute sweep and
+    /// the tessellated monorail all orient their rings this way, so a vertical tangent neither
+    /// breaks nor flips the tube
+    /// \param tangent unit tangent at the point
+    /// \param startNormal knot normal at the start of the curve
+    /// \param endNormal knot normal at the end of the curve
+    /// \param t curve parameter of the point
+    glm::vec3 ringNormal(glm::vec3 tangent, glm::vec3 startNormal, glm::vec3 endNormal, GLfloat t);
+
+    /// \desc carries a ring frame sample by sample along the whole track and stores its normal
+    /// at every curve end point
+    /// \param samples curve samples in track order, resolution + 1 for each curve
+    /// \param numCurves number of curves sampled
+    /// \param resolution number of segments each curve is split into
+    /// \param [out] knotNormals one entry per control point, entry 3i getting the normal where
+    /// curve i starts and entry 3 * numCurves where the last one ends.  The handles' entries are
+    /// left alone
+    void computeKnotNormals(const glm::vec3* samples, GLuint numCurves, GLuint resolution, glm::vec3* knotNormals);
+    /// \desc after some curves changed shape, carries the normals at their end points onto the
+    /// new tangents there.  No other curve's rings change, so edits stay local
+    /// \param samples curve samples in track order, resolution + 1 for each curve
+    /// \param numCurves number of curves sampled
+    /// \param resolution number of segments each curve is split into
+    /// \param firstCurve first curve that changed
+    /// \param lastCurve last curve that changed
+    /// \param [in,out] knotNormals one entry per control point, as from computeKnotNormals()
+    void updateKnotNormals(const glm::vec3* samples, GLuint numCurves, GLuint resolution,
+                           GLuint firstCurve, GLuint lastCurve, glm::vec3* knotNormals);
+
+    /// \desc sweeps tube rings around a run of samples
+    /// \param samples curve samples in track order, resolution + 1 for each curve
+    /// \param numSamples number of samples, at least two
+    /// \param knotNormals ring normals at the curve end points, as from computeKnotNormals()
+    /// \param resolution number of segments each curve is split into
+    /// \param firstRing first sample to place a ring at
+    /// \param lastRing last sample to place a ring at
+    /// \param radius tube radius
+    /// \param segments vertices around each ring
+    /// \param [out] positions (lastRing - firstRing + 1) * segments vertex positions
+    /// \param [out] normals matching outward normals
+    void sweepRings(const glm::vec3* samples, GLuint numSamples, const glm::vec3* knotNormals, GLuint resolution,
+                    GLuint firstRing, GLuint lastRing,
+                    GLfloat radius, GLint segments, glm::vec3* positions, glm::vec3* normals);
+    /// \desc box holding every vertex sweepRings() would place around a run of samples, without
+    /// sweeping them: the samples' box grown by the radius
+    /// \param samples curve samples in track order
+    /// \param firstRing first sample of the run
+    /// \param lastRing last sample of the run
+    /// \param radius tube radius
+    /// \param [out] boxMin minimum corner of the box
+    /// \param [out] boxMax maximum corner of the box
+    void sweepBounds(const glm::vec3* samples, GLuint firstRing, GLuint lastRing, GLfloat radius,
+                     glm::vec3& boxMin, glm::vec3& boxMax);
+
+    /// \desc cumulative distance along the samples, arcLengths[i] being the length from the
+    /// first sample to sample i
+    /// \param samples curve samples in track order
+    /// \param numSamples number of samples
+    /// \param firstSample first sample whose position may have changed
+    /// \param [in,out] arcLengths numSamples lengths, entries before firstSample are kept
+    void computeArcLengths(const glm::vec3* samples, GLuint numSamples, GLuint firstSample, GLfloat* arcLengths);
+}
+
+#endif // TRACK_GEOMETRY_H
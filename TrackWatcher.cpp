@@ -0,0 +1,139 @@
+#include "TrackWatcher.h"
+
+#include "AllocationTracker.h"
+#include "TrackGeometry.h"
+
+#include <chrono>
+#include <cstdio>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+TrackWatcher::TrackWatcher(const char* FILENAME)
+    : _filename(FILENAME),
+      _notifyFD(-1),
+      _running(false),
+      _hasPending(false)
+{
+}
+
+TrackWatcher::~TrackWatcher()
+{
+    stop();
+}
+
+bool TrackWatcher::start()
+{
+    if (_running) return true;
+
+#ifdef __linux__
+    // watch the directory rather than the file: saving through a rename replaces the inode
+    const size_t slash = _filename.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : _filename.substr(0, slash));
+
+    _notifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_notifyFD < 0 || inotify_add_watch(_notifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        fprintf(stderr, "[ERROR]: Could not watch \"%s\" for changes\n", directory.c_str());
+        if (_notifyFD >= 0) close(_notifyFD);
+        _notifyFD = -1;
+        return false;
+    }
+#else
+    struct stat info;
+    if (stat(_filename.c_str(), &info) != 0)
+    {
+        fprintf(stderr, "[ERROR]: Could not watch \"%s\" for changes\n", _filename.c_str());
+        return false;
+    }
+#endif
+
+    _running = true;
+    _thread = std::thread(&TrackWatcher::_watch, this);
+    fprintf(stdout, "[INFO]: watching \"%s\" for changes\n", _filename.c_str());
+    return true;
+}
+
+void TrackWatcher::stop()
+{
+    _running = false;
+    if (_thread.joinable()) _thread.join();
+
+#ifdef __linux__
+    if (_notifyFD >= 0) close(_notifyFD);
+#endif
+    _notifyFD = -1;
+}
+
+bool TrackWatcher::poll(std::vector<glm::vec3>& controlPoints)
+{
+    // the render thread never waits on the parser; a busy lock just means try again next frame
+    std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+    if (!lock.owns_lock() || !_hasPending) return false;
+
+    controlPoints.swap(_pendingPoints);
+    _hasPending = false;
+    return true;
+}
+
+void TrackWatcher::_watch()
+{
+    AllocationTracker::Scope scope(AllocationTracker::Subsystem::TRACK);
+#ifdef __linux__
+    const size_t slash = _filename.find_last_of('/');
+    const std::string name = slash == std::string::npos ? _filename : _filename.substr(slash + 1);
+
+    alignas(inotify_event) char buffer[4096];
+    while (_running)
+    {
+        pollfd descriptor = { _notifyFD, POLLIN, 0 };
+        if (::poll(&descriptor, 1, POLL_INTERVAL_MS) <= 0) continue;
+
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(_notifyFD, buffer, sizeof(buffer))) > 0)
+        {
+            for (char* pEvent = buffer; pEvent < buffer + length; )
+            {
+                const auto* event = reinterpret_cast<const inotify_event*>(pEvent);
+                if (event->len > 0 && name == event->name) changed = true;
+                pEvent += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (!changed) continue;
+
+        // let the save finish, then drop the events it raised in the meantime
+        std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_TIME_MS));
+        while (read(_notifyFD, buffer, sizeof(buffer)) > 0) {}
+
+        _reload();
+    }
+#else
+    struct stat info;
+    time_t lastModified = stat(_filename.c_str(), &info) == 0 ? info.st_mtime : 0;
+    while (_running)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+        if (stat(_filename.c_str(), &info) != 0 || info.st_mtime == lastModified) continue;
+        lastModified = info.st_mtime;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(SETTLE_TIME_MS));
+        _reload();
+    }
+#endif
+}
+
+void TrackWatcher::_reload()
+{
+    std::vector<glm::vec3> controlPoints;
+    if (!TrackGeometry::loadControlPoints(_filename.c_str(), controlPoints)) return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _pendingPoints.swap(controlPoints);
+    _hasPending = true;
+}
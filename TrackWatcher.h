@@ -0,0 +1,64 @@
+#ifndef TRACK_WATCHER_H
+#define TRACK_WATCHER_H
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// \class TrackWatcher
+/// \desc Watches a control point file for changes on a background thread.  On Linux the
+/// file's directory is watched with inotify so editors that save by writing a temporary file
+/// and renaming it are caught too; other platforms fall back to polling the modification
+/// time.  Each change is parsed off the render thread and handed over through poll(), which
+/// never blocks
+class TrackWatcher {
+public:
+    /// \desc creates a watcher for the given file, call start() to begin watching
+    /// \param FILENAME control point file to watch
+    explicit TrackWatcher(const char* FILENAME);
+    /// \desc stops the watch thread
+    ~TrackWatcher();
+
+    TrackWatcher(const TrackWatcher&) = delete;
+    TrackWatcher& operator=(const TrackWatcher&) = delete;
+
+    /// \desc starts the background watch thread
+    /// \returns false if the file could not be watched
+    bool start();
+    /// \desc stops the background watch thread and waits for it to exit
+    void stop();
+
+    /// \desc takes the most recently parsed set of control points, if a new one is ready
+    /// \param [out] controlPoints receives the new control points
+    /// \returns true if controlPoints was filled with a new track
+    bool poll(std::vector<glm::vec3>& controlPoints);
+
+private:
+    /// \desc body of the watch thread
+    void _watch();
+    /// \desc parses the file and publishes the result for poll()
+    void _reload();
+
+    /// \desc how long the watch thread waits between checks of the stop flag, in milliseconds
+    static constexpr int POLL_INTERVAL_MS = 100;
+    /// \desc quiet time after a change before the file is parsed, so bursts of writes from
+    /// one save are coalesced, in milliseconds
+    static constexpr int SETTLE_TIME_MS = 30;
+
+    std::string _filename;
+    /// \desc inotify descriptor, -1 when the modification time is polled instead
+    int _notifyFD;
+    std::thread _thread;
+    std::atomic<bool> _running;
+
+    /// \desc guards _pendingPoints and _hasPending
+    std::mutex _mutex;
+    std::vector<glm::vec3> _pendingPoints;
+    bool _hasPending;
+};
+
+#endif // TRACK_WATCHER_H
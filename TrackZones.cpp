@@ -0,0 +1,179 @@
+#include "TrackZones.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+TrackZones::TrackZones()
+    : _trackLength(0.0f),
+      _distance(0.0f),
+      _cursor(0),
+      _numActive{}
+{
+}
+
+bool TrackZones::load(const char* FILENAME)
+{
+    setZones({});
+    FILE* file = fopen(FILENAME, "r");
+    if (!file) {
+        fprintf(stdout, "[INFO]: no track zones, \"%s\" not found\n", FILENAME);
+        return true;
+    }
+
+    std::vector<Zone> zones;
+    bool valid = true;
+    char line[256];
+    for (GLuint lineNumber = 1; valid && fgets(line, sizeof(line), file); lineNumber++) {
+        const char* text = line + strspn(line, " \t");
+        if (*text == '#' || *text == '\n' || *text == '\r' || *text == '\0') continue;
+
+        Zone zone = { 0.0f, 0.0f, Action::GLITCH, glm::vec3(0.0f) };
+        char action[16] = "";
+        int consumed = 0;
+        valid = sscanf(text, "%f , %f , %15[a-z]%n", &zone.begin, &zone.end, action, &consumed) == 3
+                && zone.begin < zone.end;
+        if (valid) {
+            const char* values = text + consumed;
+            if (strcmp(action, "glitch") == 0) {
+                zone.action = Action::GLITCH;
+            } else if (strcmp(action, "hero") == 0) {
+                zone.action = Action::HERO;
+            } else if (strcmp(action, "light") == 0) {
+                zone.action = Action::LIGHTING;
+                valid = sscanf(values, " , %f , %f , %f", &zone.value.x, &zone.value.y, &zone.value.z) == 3;
+            } else if (strcmp(action, "camera") == 0) {
+                zone.action = Action::CAMERA;
+                valid = sscanf(values, " , %f", &zone.value.x) == 1;
+            } else {
+                valid = false;
+            }
+        }
+        if (valid) {
+            zones.push_back(zone);
+        } else {
+            fprintf(stderr, "[ERROR]: line %u of \"%s\" is not a valid zone\n", lineNumber, FILENAME);
+        }
+    }
+    fclose(file);
+
+    if (!valid) return false;
+    setZones(zones);
+    fprintf(stdout, "[INFO]: loaded %zu track zones from \"%s\"\n", zones.size(), FILENAME);
+    return true;
+}
+
+void TrackZones::setZones(const std::vector<Zone>& zones)
+{
+    _zones = zones;
+    _boundaries.clear();
+    _boundaries.reserve(2 * _zones.size());
+    for (GLuint z = 0; z < _zones.size(); z++) {
+        _boundaries.push_back({ _zones[z].begin, z, true });
+        _boundaries.push_back({ _zones[z].end, z, false });
+    }
+    // where one zone ends as another begins, leave the first before entering the second
+    std::stable_sort(_boundaries.begin(), _boundaries.end(), [](const Boundary& a, const Boundary& b) {
+        return a.distance < b.distance || (a.distance == b.distance && !a.begin && b.begin);
+    });
+
+    _distance = 0.0f;
+    _cursor = 0;
+    _inside.assign(_zones.size(), false);
+    _activeZones.clear();
+    std::fill(_numActive, _numActive + NUM_ACTIONS, 0);
+    _events.clear();
+}
+
+void TrackZones::moveTo(const GLfloat distance)
+{
+    _events.clear();
+
+    // a step longer than half a lap is really the other way around, across the start
+    const GLfloat ahead = distance - _distance;
+    bool forward = ahead >= 0.0f;
+    bool wraps = false;
+    if (_trackLength > 0.0f && (ahead > 0.5f * _trackLength || ahead < -0.5f * _trackLength)) {
+        forward = !forward;
+        wraps = true;
+    }
+
+    const GLuint numBoundaries = _boundaries.size();
+    const GLuint target = _boundariesUpTo(distance);
+    if (forward) {
+        if (wraps) {
+            while (_cursor < numBoundaries) _cross(_cursor++, true);
+            _cursor = 0;
+        }
+        while (_cursor < target) _cross(_cursor++, true);
+    } else {
+        if (wraps) {
+            while (_cursor > 0) _cross(--_cursor, false);
+            _cursor = numBoundaries;
+        }
+        while (_cursor > target) _cross(--_cursor, false);
+    }
+    _distance = distance;
+}
+
+void TrackZones::seek(const GLfloat distance)
+{
+    _events.clear();
+    _distance = distance;
+    _cursor = _boundariesUpTo(distance);
+
+    // the net change only, leaving zones before entering others
+    for (GLuint z = 0; z < _zones.size(); z++) {
+        if (_inside[z] && !(_zones[z].begin <= distance && distance < _zones[z].end)) _leave(z);
+    }
+    for (GLuint z = 0; z < _zones.size(); z++) {
+        if (!_inside[z] && _zones[z].begin <= distance && distance < _zones[z].end) _enter(z);
+    }
+}
+
+bool TrackZones::getLatestActive(const Action action, Zone& zone) const
+{
+    for (auto it = _activeZones.rbegin(); it != _activeZones.rend(); ++it) {
+        if (_zones[*it].action == action) {
+            zone = _zones[*it];
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrackZones::_cross(const GLuint boundary, const bool forward)
+{
+    // moving forward over a begin enters, and so does moving backward over an end
+    const Boundary& crossed = _boundaries[boundary];
+    if (crossed.begin == forward) {
+        _enter(crossed.zone);
+    } else {
+        _leave(crossed.zone);
+    }
+}
+
+void TrackZones::_enter(const GLuint zone)
+{
+    if (_inside[zone]) return;
+    _inside[zone] = true;
+    _activeZones.push_back(zone);
+    _numActive[static_cast<GLuint>(_zones[zone].action)]++;
+    _events.push_back({ zone, true });
+}
+
+void TrackZones::_leave(const GLuint zone)
+{
+    if (!_inside[zone]) return;
+    _inside[zone] = false;
+    _activeZones.erase(std::find(_activeZones.begin(), _activeZones.end(), zone));
+    _numActive[static_cast<GLuint>(_zones[zone].action)]--;
+    _events.push_back({ zone, false });
+}
+
+GLuint TrackZones::_boundariesUpTo(const GLfloat distance) const
+{
+    return std::upper_bound(_boundaries.begin(), _boundaries.end(), distance, [](const GLfloat d, const Boundary& b) {
+        return d < b.distance;
+    }) - _boundaries.begin();
+}
@@ -0,0 +1,118 @@
+#ifndef TRACK_ZONES_H
+#define TRACK_ZONES_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/// \class TrackZones
+/// \desc Stretches of the track that trigger an action while the cart is inside them.  Zones are
+/// placed by arc length, the distance along the track from its first sample, so they stay put
+/// when the curves are sampled more or less finely.  Every zone contributes a begin and an end
+/// boundary to one sorted list, and a cursor into that list follows the cart: moving the cart
+/// only visits the boundaries it crosses, so a step costs O(1) amortized however many zones
+/// the track has.  A jump places the cursor by binary search instead
+class TrackZones {
+public:
+    /// \desc what a zone does while the cart is inside it
+    enum class Action : GLuint {
+        /// \desc glitches the frame
+        GLITCH = 0,
+        /// \desc SirByzler flies alongside the cart
+        HERO = 1,
+        /// \desc tints the directional light, value is the light color
+        LIGHTING = 2,
+        /// \desc switches to another camera, value.x is the camera index
+        CAMERA = 3
+    };
+    static constexpr GLuint NUM_ACTIONS = 4;
+
+    /// \desc an interval [begin, end) of arc length and its action
+    struct Zone {
+        GLfloat begin;
+        GLfloat end;
+        Action action;
+        /// \desc argument of the action, unused by GLITCH and HERO
+        glm::vec3 value;
+    };
+
+    /// \desc the cart entering or leaving a zone
+    struct Event {
+        GLuint zone;
+        bool entered;
+    };
+
+    /// \desc creates an empty set of zones
+    TrackZones();
+
+    /// \desc reads zones from a text file, one "begin,end,action[,values]" line per zone where
+    /// action is glitch, hero, light,r,g,b or camera,index.  Lines starting with # are comments.
+    /// A missing file is not an error, the track simply has no zones
+    /// \param FILENAME zone file to read
+    /// \returns false if the file exists but could not be parsed, the zones are then left empty
+    bool load(const char* FILENAME);
+    /// \desc replaces every zone and puts the cart just before the start of the track, outside
+    /// every zone, so the next moveTo() or seek() enters the zones it lands in
+    /// \param zones zones in any order, each with begin < end
+    void setZones(const std::vector<Zone>& zones);
+
+    /// \desc sets the length of one lap, which moveTo() uses to tell a wrap around the end of
+    /// the track from a step backwards.  Zones past the end of a shortened track never trigger
+    void setTrackLength(GLfloat length) { _trackLength = length; }
+
+    /// \desc moves the cart a short way along the track, the shorter way around the lap, and
+    /// records every boundary it crosses in getEvents()
+    /// \param distance new arc length of the cart
+    void moveTo(GLfloat distance);
+    /// \desc jumps the cart to a distance, recording only the net change of zones in getEvents()
+    /// \param distance new arc length of the cart
+    void seek(GLfloat distance);
+
+    /// \desc zones entered and left by the last moveTo() or seek(), in the order they were crossed
+    [[nodiscard]] const std::vector<Event>& getEvents() const { return _events; }
+    /// \desc zones the cart is inside, in the order they were entered
+    [[nodiscard]] const std::vector<GLuint>& getActiveZones() const { return _activeZones; }
+    /// \desc true while the cart is inside any zone with the action
+    [[nodiscard]] bool isActive(Action action) const { return _numActive[static_cast<GLuint>(action)] > 0; }
+    /// \desc most recently entered zone with the action that the cart is inside
+    /// \returns false if the cart is inside no such zone
+    bool getLatestActive(Action action, Zone& zone) const;
+
+    [[nodiscard]] GLuint getNumZones() const { return _zones.size(); }
+    [[nodiscard]] const Zone& getZone(GLuint zone) const { return _zones[zone]; }
+
+private:
+    /// \desc one end of a zone
+    struct Boundary {
+        GLfloat distance;
+        GLuint zone;
+        /// \desc true for the begin of the zone, false for its end
+        bool begin;
+    };
+
+    /// \desc crosses _boundaries[boundary] moving forward or backward
+    void _cross(GLuint boundary, bool forward);
+    void _enter(GLuint zone);
+    void _leave(GLuint zone);
+    /// \desc number of boundaries at or before a distance
+    [[nodiscard]] GLuint _boundariesUpTo(GLfloat distance) const;
+
+    std::vector<Zone> _zones;
+    /// \desc both ends of every zone, sorted by distance
+    std::vector<Boundary> _boundaries;
+    GLfloat _trackLength;
+
+    /// \desc arc length of the cart
+    GLfloat _distance;
+    /// \desc number of boundaries at or before the cart, the next boundary ahead of it
+    GLuint _cursor;
+
+    std::vector<bool> _inside;
+    std::vector<GLuint> _activeZones;
+    GLuint _numActive[NUM_ACTIONS];
+    std::vector<Event> _events;
+};
+
+#endif // TRACK_ZONES_H
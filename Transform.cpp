@@ -0,0 +1,140 @@
+#include "Transform.h"
+
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TRANSFORM_NEON
+#endif
+
+namespace {
+    /// \desc world space eye of a rigid view matrix, in double precision
+    glm::dvec3 eyePosition(const glm::mat4& viewMtx) {
+        // the inverse of a rotation is its transpose, so the eye sits at -R^T * t
+        const glm::dvec3 translation = glm::dvec3(glm::vec3(viewMtx[3]));
+        glm::dvec3 eye;
+        for (int axis = 0; axis < 3; axis++) {
+            eye[axis] = -glm::dot(glm::dvec3(glm::vec3(viewMtx[axis])), translation);
+        }
+        return eye;
+    }
+}
+
+Transform::ViewTransform Transform::makeViewTransform(const glm::mat4& viewMtx, const glm::mat4& projMtx) {
+    return makeViewTransform(viewMtx, projMtx, eyePosition(viewMtx));
+}
+
+Transform::ViewTransform Transform::makeViewTransform(const glm::mat4& viewMtx, const glm::mat4& projMtx, const glm::dvec3& origin) {
+    ViewTransform view;
+    view.origin = origin;
+    // moving the origin to zero adds R * origin to the translation, summed in double so the
+    // large terms cancel before anything is rounded to float
+    glm::dvec3 translation = glm::dvec3(glm::vec3(viewMtx[3]));
+    for (int axis = 0; axis < 3; axis++) {
+        translation = translation + glm::dvec3(glm::vec3(viewMtx[axis])) * origin[axis];
+    }
+    view.viewMtx = viewMtx;
+    view.viewMtx[3] = glm::vec4(glm::vec3(translation), 1.0f);
+    view.projMtx = projMtx;
+    view.viewProjMtx = projMtx * view.viewMtx;
+    view.cameraPosition = glm::vec3(eyePosition(viewMtx) - origin);
+    return view;
+}
+
+glm::vec3 Transform::rebase(const glm::vec3& position, const glm::dvec3& origin) {
+    return glm::vec3(glm::dvec3(position) - origin);
+}
+
+glm::mat4 Transform::rebase(const glm::mat4& modelMtx, const glm::dvec3& origin) {
+    glm::mat4 relativeMtx = modelMtx;
+    relativeMtx[3] = glm::vec4(rebase(glm::vec3(modelMtx[3]), origin), modelMtx[3].w);
+    return relativeMtx;
+}
+
+glm::mat3 Transform::normalMatrix(const glm::mat4& modelMtx) {
+    const glm::vec3 c0(modelMtx[0]);
+    const glm::vec3 c1(modelMtx[1]);
+    const glm::vec3 c2(modelMtx[2]);
+
+    // the rows of the inverse are the cross products of the other two columns over the
+    // determinant, so those cross products are the columns of the inverse transpose
+    const glm::vec3 r0 = glm::cross(c1, c2);
+    const glm::vec3 r1 = glm::cross(c2, c0);
+    const glm::vec3 r2 = glm::cross(c0, c1);
+    const GLfloat determinant = glm::dot(c0, r0);
+    const GLfloat inverseDeterminant = determinant != 0.0f ? 1.0f / determinant : 1.0f;
+    return glm::mat3(r0 * inverseDeterminant, r1 * inverseDeterminant, r2 * inverseDeterminant);
+}
+
+glm::mat3 Transform::normalMatrix(const glm::mat3& rotationMtx, const glm::vec3 scale) {
+    // (R * S)^-T = R * S^-1 for an orthonormal R and diagonal S
+    return glm::mat3(rotationMtx[0] / scale.x, rotationMtx[1] / scale.y, rotationMtx[2] / scale.z);
+}
+
+void Transform::multiply(const glm::mat4& lhsMtx, const glm::mat4* rhsMtx, const size_t count, glm::mat4* outMtx) {
+    // column j of the product is lhs times column j of rhs: a sum of the lhs columns weighted
+    // by the four entries of that column.  Each column is read whole before it is written, so
+    // the output may overwrite the input
+#if defined(TRANSFORM_SSE)
+    const float* lhs = &lhsMtx[0][0];
+    const __m128 l0 = _mm_loadu_ps(lhs);
+    const __m128 l1 = _mm_loadu_ps(lhs + 4);
+    const __m128 l2 = _mm_loadu_ps(lhs + 8);
+    const __m128 l3 = _mm_loadu_ps(lhs + 12);
+    for (size_t i = 0; i < count; i++) {
+        const float* rhs = &rhsMtx[i][0][0];
+        float* out = &outMtx[i][0][0];
+        for (int j = 0; j < 16; j += 4) {
+            __m128 column = _mm_mul_ps(l0, _mm_set1_ps(rhs[j]));
+            column = _mm_add_ps(column, _mm_mul_ps(l1, _mm_set1_ps(rhs[j + 1])));
+            column = _mm_add_ps(column, _mm_mul_ps(l2, _mm_set1_ps(rhs[j + 2])));
+            column = _mm_add_ps(column, _mm_mul_ps(l3, _mm_set1_ps(rhs[j + 3])));
+            _mm_storeu_ps(out + j, column);
+        }
+    }
+#elif defined(TRANSFORM_NEON)
+    const float* lhs = &lhsMtx[0][0];
+    const float32x4_t l0 = vld1q_f32(lhs);
+    const float32x4_t l1 = vld1q_f32(lhs + 4);
+    const float32x4_t l2 = vld1q_f32(lhs + 8);
+    const float32x4_t l3 = vld1q_f32(lhs + 12);
+    for (size_t i = 0; i < count; i++) {
+        const float* rhs = &rhsMtx[i][0][0];
+        float* out = &outMtx[i][0][0];
+        for (int j = 0; j < 16; j += 4) {
+            const float32x4_t r = vld1q_f32(rhs + j);
+            float32x4_t column = vmulq_lane_f32(l0, vget_low_f32(r), 0);
+            column = vmlaq_lane_f32(column, l1, vget_low_f32(r), 1);
+            column = vmlaq_lane_f32(column, l2, vget_high_f32(r), 0);
+            column = vmlaq_lane_f32(column, l3, vget_high_f32(r), 1);
+            vst1q_f32(out + j, column);
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        outMtx[i] = lhsMtx * rhsMtx[i];
+    }
+#endif
+}
+
+void Transform::computeMatrixUniforms(const ViewTransform& view, const glm::mat4& modelMtx, glm::mat4& mvpMtx, glm::mat4& modelViewMtx) {
+    const glm::mat4 relativeMtx = rebase(modelMtx, view.origin);
+    mvpMtx = view.viewProjMtx * relativeMtx;
+    modelViewMtx = view.viewMtx * relativeMtx;
+}
+
+void Transform::computeMatrixUniforms(const ViewTransform& view, const glm::mat4* modelMtx, const size_t count,
+                                      glm::mat4* mvpMtx, glm::mat4* modelViewMtx) {
+    // the rebased models are written to the outputs and multiplied in place
+    for (size_t i = 0; i < count; i++) {
+        mvpMtx[i] = rebase(modelMtx[i], view.origin);
+    }
+    if (modelViewMtx) {
+        std::copy(mvpMtx, mvpMtx + count, modelViewMtx);
+        multiply(view.viewMtx, modelViewMtx, count, modelViewMtx);
+    }
+    multiply(view.viewProjMtx, mvpMtx, count, mvpMtx);
+}
@@ -0,0 +1,79 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/// \desc Per-object matrix math for the shaders.  The view-projection product is formed once
+/// per view pass, normal matrices come from a 3x3 inverse-transpose or straight from a known
+/// rotation and scale instead of a full 4x4 inverse, and batches of objects are multiplied with
+/// SSE or NEON where available.  Each view pass is drawn relative to an origin kept in double
+/// precision, normally the camera itself, so the floats sent to the GPU stay small and precise
+/// however far from the world origin the camera is.  Nothing here touches OpenGL
+namespace Transform {
+    /// \desc matrices shared by every object drawn from one camera
+    struct ViewTransform {
+        /// \desc world position the pass is drawn relative to, the matrices below take
+        /// positions with this origin subtracted
+        glm::dvec3 origin;
+        /// \desc view matrix of positions relative to origin
+        glm::mat4 viewMtx;
+        glm::mat4 projMtx;
+        /// \desc projMtx * viewMtx
+        glm::mat4 viewProjMtx;
+        /// \desc camera position relative to origin, taken from the rigid view matrix
+        glm::vec3 cameraPosition;
+    };
+
+    /// \desc caches the products needed for one view pass, drawn relative to the camera
+    /// \param viewMtx camera view matrix, assumed to be a rotation and translation
+    /// \param projMtx camera projection matrix
+    ViewTransform makeViewTransform(const glm::mat4& viewMtx, const glm::mat4& projMtx);
+    /// \desc caches the products needed for one view pass, drawn relative to a given origin so
+    /// several views can share world space geometry
+    /// \param viewMtx camera view matrix, assumed to be a rotation and translation
+    /// \param projMtx camera projection matrix
+    /// \param origin world position the pass is drawn relative to
+    ViewTransform makeViewTransform(const glm::mat4& viewMtx, const glm::mat4& projMtx, const glm::dvec3& origin);
+
+    /// \desc world position relative to a view origin, subtracted in double precision
+    glm::vec3 rebase(const glm::vec3& position, const glm::dvec3& origin);
+    /// \desc model matrix whose translation is made relative to a view origin
+    glm::mat4 rebase(const glm::mat4& modelMtx, const glm::dvec3& origin);
+
+    /// \desc normal matrix of any affine model matrix, the inverse transpose of its upper 3x3
+    glm::mat3 normalMatrix(const glm::mat4& modelMtx);
+    /// \desc normal matrix of a model matrix built as translate * rotate * scale, which needs no
+    /// inverse at all
+    /// \param rotationMtx rotation part of the model matrix
+    /// \param scale per axis scale applied before the rotation, no component may be zero
+    glm::mat3 normalMatrix(const glm::mat3& rotationMtx, glm::vec3 scale);
+
+    /// \desc multiplies one matrix by a batch, out[i] = lhsMtx * rhsMtx[i]
+    /// \param lhsMtx matrix applied last
+    /// \param rhsMtx count matrices
+    /// \param count number of matrices in the batch
+    /// \param [out] outMtx count results, may be the same array as rhsMtx
+    void multiply(const glm::mat4& lhsMtx, const glm::mat4* rhsMtx, size_t count, glm::mat4* outMtx);
+
+    /// \desc computes the view dependent matrices for one object, rebased onto the view's origin
+    /// \param view cached matrices of the current view pass
+    /// \param modelMtx model transformation matrix
+    /// \param [out] mvpMtx model-view-projection matrix
+    /// \param [out] modelViewMtx model-view matrix
+    void computeMatrixUniforms(const ViewTransform& view, const glm::mat4& modelMtx, glm::mat4& mvpMtx, glm::mat4& modelViewMtx);
+    /// \desc computes the view dependent matrices for a batch of objects, rebased onto the view's
+    /// origin
+    /// \param view cached matrices of the current view pass
+    /// \param modelMtx count model transformation matrices
+    /// \param count number of objects
+    /// \param [out] mvpMtx count model-view-projection matrices
+    /// \param [out] modelViewMtx count model-view matrices, may be null if not needed
+    void computeMatrixUniforms(const ViewTransform& view, const glm::mat4* modelMtx, size_t count,
+                               glm::mat4* mvpMtx, glm::mat4* modelViewMtx);
+}
+
+#endif // TRANSFORM_H
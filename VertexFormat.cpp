@@ -0,0 +1,97 @@
+#include "VertexFormat.h"
+
+#include <cmath>
+#include <cstring>
+
+PositionBounds VertexFormat::computeBounds(const glm::vec3* positions, const size_t count, const size_t stride) {
+    PositionBounds bounds;
+    if (count == 0) return bounds;
+
+    const auto* bytes = reinterpret_cast<const unsigned char*>(positions);
+    glm::vec3 minCorner = positions[0];
+    glm::vec3 maxCorner = positions[0];
+    for (size_t i = 1; i < count; i++) {
+        const glm::vec3& position = *reinterpret_cast<const glm::vec3*>(bytes + i * stride);
+        minCorner = glm::min(minCorner, position);
+        maxCorner = glm::max(maxCorner, position);
+    }
+
+    bounds.origin = minCorner;
+    bounds.extent = maxCorner - minCorner;
+    return bounds;
+}
+
+GLushort VertexFormat::packUnorm16(const GLfloat value) {
+    const GLfloat clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return (GLushort)(clamped * 65535.0f + 0.5f);
+}
+
+GLuint VertexFormat::packNormal(const glm::vec3 normal) {
+    // signed 10-bit components stored in two's complement, x in the low bits
+    auto packComponent = [](const GLfloat value) -> GLuint {
+        const GLfloat clamped = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+        const GLint quantized = (GLint)lroundf(clamped * 511.0f);
+        return (GLuint)quantized & 0x3FFu;
+    };
+    return packComponent(normal.x) | (packComponent(normal.y) << 10) | (packComponent(normal.z) << 20);
+}
+
+GLushort VertexFormat::packHalf(const GLfloat value) {
+    GLuint bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    const GLuint sign = (bits >> 16) & 0x8000u;
+    const GLint exponent = (GLint)((bits >> 23) & 0xFFu) - 127 + 15;
+    GLuint mantissa = bits & 0x7FFFFFu;
+
+    if (exponent <= 0) {
+        // too small for a normal half: flush tiny values, otherwise build a subnormal
+        if (exponent < -10) return (GLushort)sign;
+        mantissa |= 0x800000u;
+        const GLuint shift = (GLuint)(14 - exponent);
+        GLuint half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1u) half++;
+        return (GLushort)(sign | half);
+    }
+    if (exponent >= 31) {
+        // overflow, infinity and NaN all saturate to infinity; none of our data should get here
+        return (GLushort)(sign | 0x7C00u);
+    }
+
+    GLuint half = sign | ((GLuint)exponent << 10) | (mantissa >> 13);
+    // round to nearest; a carry out of the mantissa correctly bumps the exponent
+    if (mantissa & 0x1000u) half++;
+    return (GLushort)half;
+}
+
+PackedVertex VertexFormat::pack(const glm::vec3 position, const glm::vec3 normal, const glm::vec2 texCoord, const PositionBounds& bounds) {
+    PackedVertex vertex{};
+    for (int i = 0; i < 3; i++) {
+        // a flat axis stores 0 and decodes to the origin
+        const GLfloat normalized = bounds.extent[i] > 0.0f ? (position[i] - bounds.origin[i]) / bounds.extent[i] : 0.0f;
+        vertex.position[i] = packUnorm16(normalized);
+    }
+    vertex.position[3] = 0;
+    vertex.normal = packNormal(normal);
+    vertex.texCoord[0] = packHalf(texCoord.x);
+    vertex.texCoord[1] = packHalf(texCoord.y);
+    return vertex;
+}
+
+void VertexFormat::setAttributeLocations(const GLint positionLocation, const GLint normalLocation, const GLint texCoordLocation, const size_t baseOffset) {
+    if (positionLocation >= 0) {
+        glEnableVertexAttribArray(positionLocation);
+        glVertexAttribPointer(positionLocation, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex),
+                              (void*)(baseOffset + offsetof(PackedVertex, position)));
+    }
+    if (normalLocation >= 0) {
+        glEnableVertexAttribArray(normalLocation);
+        glVertexAttribPointer(normalLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex),
+                              (void*)(baseOffset + offsetof(PackedVertex, normal)));
+    }
+    if (texCoordLocation >= 0) {
+        glEnableVertexAttribArray(texCoordLocation);
+        glVertexAttribPointer(texCoordLocation, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex),
+                              (void*)(baseOffset + offsetof(PackedVertex, texCoord)));
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/gl.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/// \desc box that quantized positions are expressed relative to.  A stored position q in [0,1]^3
+/// decodes to origin + extent * q, which the vertex shaders apply through the
+/// positionOffset/positionScale uniforms
+struct PositionBounds {
+    /// \desc minimum corner of the box
+    glm::vec3 origin = glm::vec3(0.0f);
+    /// \desc size of the box along each axis
+    glm::vec3 extent = glm::vec3(1.0f);
+};
+
+/// \desc compact 16 byte vertex: normalized 16-bit position relative to a PositionBounds,
+/// GL_INT_2_10_10_10_REV normal and half-float texture coordinate
+struct PackedVertex {
+    /// \desc unorm16 xyz, the fourth component pads the position to 8 bytes
+    GLushort position[4];
+    /// \desc signed normalized 10-10-10-2 normal
+    GLuint normal;
+    /// \desc half-float s, t
+    GLushort texCoord[2];
+};
+
+namespace VertexFormat {
+    /// \desc identity decode used by everything still stored as full floats
+    const PositionBounds IDENTITY_BOUNDS;
+
+    /// \desc computes the bounding box of a set of positions
+    /// \param positions array of positions
+    /// \param stride distance in bytes between consecutive positions
+    /// \param count number of positions
+    PositionBounds computeBounds(const glm::vec3* positions, size_t count, size_t stride = sizeof(glm::vec3));
+
+    /// \desc quantizes a value in [0,1] to an unsigned normalized 16-bit integer
+    GLushort packUnorm16(GLfloat value);
+    /// \desc packs a unit vector into GL_INT_2_10_10_10_REV layout (w = 0)
+    GLuint packNormal(glm::vec3 normal);
+    /// \desc converts a float to IEEE 754 half precision, rounding to nearest
+    GLushort packHalf(GLfloat value);
+
+    /// \desc packs a full precision vertex relative to the given bounds
+    PackedVertex pack(glm::vec3 position, glm::vec3 normal, glm::vec2 texCoord, const PositionBounds& bounds);
+
+    /// \desc points the bound VAO at PackedVertex data in the bound GL_ARRAY_BUFFER
+    /// \param positionLocation attribute location for the vertex position
+    /// \param normalLocation attribute location for the vertex normal (-1 to skip)
+    /// \param texCoordLocation attribute location for the texture coordinate (-1 to skip)
+    /// \param baseOffset byte offset of the first vertex in the buffer
+    void setAttributeLocations(GLint positionLocation, GLint normalLocation, GLint texCoordLocation, size_t baseOffset = 0);
+}
+
+#endif // VERTEX_FORMAT_H
@@ -13,6 +13,9 @@
  */
 
 #include "FPEngine.h"
+#include "TrackGenerator.h"
+
+#include <cstring>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
@@ -20,9 +23,148 @@
 ///*****************************************************************************
 //
 // Our main function
-int main() {
+int main(int argc, char* argv[]) {
+
+    // optional arguments:
+    //   fp --track tracks/big.trk                     load a different track, CSV or binary
+    //   fp --record session.fpi --frame-times a.csv   record input and frame times
+    //   fp --replay session.fpi --frame-times b.csv   replay recorded input
+    //   fp --frame-budget 16.7                        scale the render resolution to fit a GPU budget in ms
+    //   fp --glitch-scale 0.25                        compute the glitch zone's post-process at a quarter resolution
+    //   fp --swap adaptive|vsync|off --queued-frames 1  pace buffer swaps and bound frames in flight
+    //   fp --replay session.fpi --capture ride.y4m    record the ride as a Y4M video, or frames/ride_%05u.png
+    //   fp --check-allocations on                     report frames that allocate from the heap once settled
+    //   fp --occlusion off                            draw everything the terrain hides as well
+    //   fp --indirect off                             submit static geometry through the GL 4.1 path
+    //   fp --track-builder gpu                        sample the curve and sweep the monorail with compute shaders
+    //   fp --render lap.y4m [--width 3840 --height 2160] [--frames N] [--fps 60] [--workers N]
+    //                                                 render a lap offline across worker processes, or frames/lap_%05u.png
+    //   fp --generate tracks/big.trk --curves 1000000 --seed 7 [--loops P] [--drops P] [--extent E]
+    //                                                 write a procedural track and exit
+    const char* trackFile = nullptr;
+    const char* recordFile = nullptr;
+    const char* replayFile = nullptr;
+    const char* frameTimeFile = nullptr;
+    const char* generateFile = nullptr;
+    float frameBudget = 0.0f;
+    float glitchScale = 0.0f;
+    const char* swapMode = nullptr;
+    const char* captureFile = nullptr;
+    unsigned long maxQueuedFrames = 0;
+    bool checkAllocations = false;
+    bool occlusionCulling = true;
+    bool multiDrawIndirect = true;
+    bool gpuTrackBuilder = false;
+    TrackGenerator::Settings generatorSettings;
+    OfflineRender::Settings renderSettings;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "[ERROR]: option \"%s\" is missing its value\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+
+        if (strcmp(argv[i], "--track") == 0)            trackFile = value;
+        else if (strcmp(argv[i], "--record") == 0)      recordFile = value;
+        else if (strcmp(argv[i], "--replay") == 0)      replayFile = value;
+        else if (strcmp(argv[i], "--frame-times") == 0) frameTimeFile = value;
+        else if (strcmp(argv[i], "--frame-budget") == 0) frameBudget = strtof(value, nullptr);
+        else if (strcmp(argv[i], "--glitch-scale") == 0) glitchScale = strtof(value, nullptr);
+        else if (strcmp(argv[i], "--swap") == 0)        swapMode = value;
+        else if (strcmp(argv[i], "--queued-frames") == 0) maxQueuedFrames = strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "--capture") == 0)     captureFile = value;
+        else if (strcmp(argv[i], "--check-allocations") == 0) checkAllocations = strcmp(value, "on") == 0;
+        else if (strcmp(argv[i], "--occlusion") == 0)   occlusionCulling = strcmp(value, "off") != 0;
+        else if (strcmp(argv[i], "--indirect") == 0)    multiDrawIndirect = strcmp(value, "off") != 0;
+        else if (strcmp(argv[i], "--track-builder") == 0) gpuTrackBuilder = strcmp(value, "gpu") == 0;
+        else if (strcmp(argv[i], "--render") == 0)     renderSettings.output = value;
+        else if (strcmp(argv[i], "--width") == 0)      renderSettings.width = strtol(value, nullptr, 10);
+        else if (strcmp(argv[i], "--height") == 0)     renderSettings.height = strtol(value, nullptr, 10);
+        else if (strcmp(argv[i], "--frames") == 0)     renderSettings.numFrames = strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "--fps") == 0)        renderSettings.framesPerSecond = strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "--workers") == 0)    renderSettings.numWorkers = strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "--generate") == 0)    generateFile = value;
+        else if (strcmp(argv[i], "--curves") == 0)      generatorSettings.numCurves = strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "--seed") == 0)        generatorSettings.seed = strtoul(value, nullptr, 10);
+        else if (strcmp(argv[i], "--loops") == 0)       generatorSettings.loopChance = strtof(value, nullptr);
+        else if (strcmp(argv[i], "--drops") == 0)       generatorSettings.dropChance = strtof(value, nullptr);
+        else if (strcmp(argv[i], "--extent") == 0)      generatorSettings.extent = strtof(value, nullptr);
+        else {
+            fprintf(stderr, "[ERROR]: unrecognized option \"%s\"\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+        i++;
+    }
+
+    // generator mode never opens a window
+    if (generateFile) {
+        std::vector<glm::vec3> controlPoints;
+        TrackGenerator::generate(generatorSettings, controlPoints);
+        if (!TrackGeometry::saveControlPoints(generateFile, controlPoints)) return EXIT_FAILURE;
+        fprintf(stdout, "[INFO]: wrote %zu control points (%u curves, seed %u) to \"%s\"\n",
+                controlPoints.size(), generatorSettings.numCurves, generatorSettings.seed, generateFile);
+        return EXIT_SUCCESS;
+    }
+
+    // offline mode renders in worker processes, each with its own hidden window
+    if (!renderSettings.output.empty()) {
+        if (renderSettings.width <= 0 || renderSettings.height <= 0 || renderSettings.framesPerSecond == 0) {
+            fprintf(stderr, "[ERROR]: offline renders need a positive --width, --height and --fps\n");
+            return EXIT_FAILURE;
+        }
+        // a lap's frame count comes from its track, and with fewer frames than cores some
+        // workers would have nothing to render
+        if (renderSettings.numFrames == 0) {
+            renderSettings.numFrames = FPEngine::getLapFrames(trackFile, renderSettings.framesPerSecond);
+            if (renderSettings.numFrames == 0) return EXIT_FAILURE;
+        }
+        const bool rendered = OfflineRender::render(renderSettings, [trackFile, glitchScale, checkAllocations, occlusionCulling,
+                                                                     multiDrawIndirect, gpuTrackBuilder](const OfflineRender::Job& job) {
+            auto workerEngine = new FPEngine();
+            if (trackFile) workerEngine->setTrackFile(trackFile);
+            if (glitchScale > 0.0f) workerEngine->setGlitchScale(glitchScale);
+            if (checkAllocations) workerEngine->checkAllocations(true);
+            if (!occlusionCulling) workerEngine->setOcclusionCulling(false);
+            if (!multiDrawIndirect) workerEngine->setMultiDrawIndirect(false);
+            if (gpuTrackBuilder) workerEngine->setGPUTrackBuilder(true);
+            workerEngine->renderOffline(job);
+            workerEngine->initialize();
+            if (workerEngine->getError() == CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
+                workerEngine->run();
+            }
+            workerEngine->shutdown();
+            const bool succeeded = workerEngine->offlineRenderSucceeded();
+            delete workerEngine;
+            return succeeded;
+        });
+        return rendered ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
     auto labEngine = new FPEngine();
+    if (trackFile) labEngine->setTrackFile(trackFile);
+    if (recordFile) labEngine->recordInput(recordFile);
+    if (replayFile) labEngine->replayInput(replayFile);
+    if (frameTimeFile) labEngine->logFrameTimes(frameTimeFile);
+    if (frameBudget > 0.0f) labEngine->setFrameBudget(frameBudget);
+    if (glitchScale > 0.0f) labEngine->setGlitchScale(glitchScale);
+    if (maxQueuedFrames > 0) labEngine->setMaxQueuedFrames(maxQueuedFrames);
+    if (captureFile) labEngine->captureFrames(captureFile);
+    if (checkAllocations) labEngine->checkAllocations(true);
+    if (!occlusionCulling) labEngine->setOcclusionCulling(false);
+    if (!multiDrawIndirect) labEngine->setMultiDrawIndirect(false);
+    if (gpuTrackBuilder) labEngine->setGPUTrackBuilder(true);
+    if (swapMode) {
+        if (strcmp(swapMode, "adaptive") == 0)   labEngine->setSwapMode(FramePacer::SwapMode::ADAPTIVE);
+        else if (strcmp(swapMode, "vsync") == 0) labEngine->setSwapMode(FramePacer::SwapMode::VSYNC);
+        else if (strcmp(swapMode, "off") == 0)   labEngine->setSwapMode(FramePacer::SwapMode::IMMEDIATE);
+        else {
+            fprintf(stderr, "[ERROR]: unrecognized swap mode \"%s\", expected adaptive, vsync or off\n", swapMode);
+            delete labEngine;
+            return EXIT_FAILURE;
+        }
+    }
+
     labEngine->initialize();
     if (labEngine->getError() == CSCI441::OpenGLEngine::OPENGL_ENGINE_ERROR_NO_ERROR) {
         labEngine->run();
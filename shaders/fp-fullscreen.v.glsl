@@ -0,0 +1,12 @@
+#version 410 core
+
+// one triangle covering the window, generated from the vertex index so no buffers are needed
+
+// varying outputs
+layout(location = 0) out vec2 windowCoord;  // 0 to 1 across the window
+
+void main() {
+    vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    windowCoord = corner;
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
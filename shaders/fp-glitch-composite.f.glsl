@@ -0,0 +1,16 @@
+#version 410 core
+
+// upsamples the reduced resolution glitch over the frame, blended as premultiplied alpha
+
+// uniform inputs
+uniform sampler2D glitchTexture;
+
+// varying inputs
+layout(location = 0) in vec2 windowCoord;
+
+// fragment outputs
+out vec4 fragColorOut;
+
+void main() {
+    fragColorOut = texture(glitchTexture, windowCoord);
+}
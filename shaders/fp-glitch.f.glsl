@@ -0,0 +1,38 @@
+#version 410 core
+
+// glitch of the finished frame at reduced resolution, composited over the frame afterwards
+
+// uniform inputs
+uniform sampler2D sceneTexture;     // reduced resolution copy of the frame
+uniform sampler2D noiseTexture;     // tiling white noise, sampled nearest
+uniform vec2 grainScale;            // grain texels across the frame
+uniform float bandScale;            // torn bands up the frame
+uniform vec2 noiseOffset;           // where this glitch step reads the noise from
+
+// varying inputs
+layout(location = 0) in vec2 windowCoord;
+
+// fragment outputs
+out vec4 fragColorOut;
+
+void main() {
+    // one noise texel per band, so a whole band tears together
+    vec4 band = texture(noiseTexture, vec2(noiseOffset.x, windowCoord.y * bandScale + noiseOffset.y));
+    vec3 grain = texture(noiseTexture, windowCoord * grainScale + noiseOffset.yx).rgb;
+
+    // roughly a quarter of the bands tear
+    float torn = step(0.75, band.a);
+    if (torn == 0.0) {
+        // no coverage, the grain is added to the full resolution frame
+        fragColorOut = vec4(grain * 0.1, 0.0);
+        return;
+    }
+
+    // shift the band sideways and pull its channels apart
+    vec2 coord = windowCoord + vec2((band.r - 0.5) * 0.08, 0.0);
+    float split = band.g * 0.01;
+    vec3 color = vec3(texture(sceneTexture, coord + vec2(split, 0.0)).r,
+                      texture(sceneTexture, coord).g,
+                      texture(sceneTexture, coord - vec2(split, 0.0)).b);
+    fragColorOut = vec4(color + grain * 0.1, 1.0);
+}
@@ -0,0 +1,53 @@
+#version 410 core
+
+// one patch per cubic Bezier segment of the track
+layout(vertices = 4) out;
+
+// uniform inputs
+uniform vec3 cameraPos;                 // camera position relative to the view's origin
+uniform float ringDensity;              // tube rings per world unit at or inside lodDistance
+uniform float lodDistance;              // distance where level of detail starts to fall off
+uniform int tubeSegments;               // vertices around the tube at full detail
+
+// varying inputs
+in vec3 controlPoint[];
+in vec3 knotNormal[];
+
+// varying outputs
+out vec3 patchControlPoint[];
+out vec3 patchKnotNormal[];
+
+// detail falls off inversely with distance beyond lodDistance
+float distanceFalloff(vec3 point) {
+    return lodDistance / max(distance(cameraPos, point), lodDistance);
+}
+
+void main() {
+    patchControlPoint[gl_InvocationID] = controlPoint[gl_InvocationID];
+    patchKnotNormal[gl_InvocationID] = knotNormal[gl_InvocationID];
+
+    if (gl_InvocationID == 0) {
+        vec3 p0 = controlPoint[0];
+        vec3 p1 = controlPoint[1];
+        vec3 p2 = controlPoint[2];
+        vec3 p3 = controlPoint[3];
+
+        // rings along the curve: the control polygon bounds the arc length from above
+        float polygonLength = distance(p0, p1) + distance(p1, p2) + distance(p2, p3);
+        float centerFalloff = distanceFalloff(0.125 * (p0 + 3.0 * p1 + 3.0 * p2 + p3));
+        float alongLevel = clamp(polygonLength * ringDensity * centerFalloff, 1.0, 64.0);
+
+        // segments around the tube: each end only depends on its shared endpoint so
+        // neighbouring patches agree and the tube stays crack free
+        float aroundStart = clamp(float(tubeSegments) * distanceFalloff(p0), 3.0, float(tubeSegments));
+        float aroundEnd = clamp(float(tubeSegments) * distanceFalloff(p3), 3.0, float(tubeSegments));
+
+        // u runs along the curve, v around the tube.  the v = 0 and v = 1 edges are the same seam
+        gl_TessLevelOuter[0] = aroundStart;
+        gl_TessLevelOuter[1] = alongLevel;
+        gl_TessLevelOuter[2] = aroundEnd;
+        gl_TessLevelOuter[3] = alongLevel;
+        gl_TessLevelInner[0] = alongLevel;
+        gl_TessLevelInner[1] = max(aroundStart, aroundEnd);
+    }
+}
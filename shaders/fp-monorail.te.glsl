@@ -0,0 +1,79 @@
+#version 410 core
+
+layout(quads, equal_spacing, ccw) in;
+
+// uniform inputs
+uniform mat4 mvpMatrix;                 // precomputed Model-View-Projection Matrix
+uniform mat3 normalMatrix;              // normal matrix for transforming normals
+uniform vec3 cameraPos;
+uniform vec3 materialColor;             // material color for the object
+uniform float tubeRadius;               // radius of the extruded tube
+// spotlight uniforms
+uniform vec3 spotlightPos;
+
+// varying inputs
+in vec3 patchControlPoint[];
+in vec3 patchKnotNormal[];
+
+// varying outputs, matching fp-std.v.glsl so fp-std.f.glsl can shade the tube
+layout(location = 0) out vec3 matColor;
+layout(location = 1) out vec2 textCoordinate;
+
+layout(location = 2) out vec3 transNormalVector;
+layout(location = 3) out vec3 viewVector;
+
+layout(location = 4) out vec3 fspotDir;
+layout(location = 5) out float spotlightDist;
+
+const float PI = 3.14159265;
+
+// ring normal with no frame to carry on from, matching TrackGeometry::ringNormal
+vec3 ringNormal(vec3 tangent) {
+    vec3 up = abs(tangent.y) > 0.999 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+    return normalize(cross(tangent, up));
+}
+
+// knot normals blended and carried onto the tangent, matching TrackGeometry::ringNormal
+vec3 ringNormal(vec3 tangent, vec3 startNormal, vec3 endNormal, float t) {
+    vec3 normal = mix(startNormal, endNormal, t);
+    vec3 projected = normal - dot(normal, tangent) * tangent;
+    return length(projected) > 1e-3 ? normalize(projected) : ringNormal(tangent);
+}
+
+void main() {
+    float t = gl_TessCoord.x;
+    float s = 1.0 - t;
+
+    vec3 p0 = patchControlPoint[0];
+    vec3 p1 = patchControlPoint[1];
+    vec3 p2 = patchControlPoint[2];
+    vec3 p3 = patchControlPoint[3];
+
+    // evaluate the curve and its derivative
+    vec3 point = s*s*s*p0 + 3.0*s*s*t*p1 + 3.0*s*t*t*p2 + t*t*t*p3;
+    vec3 derivative = 3.0*s*s*(p1 - p0) + 6.0*s*t*(p2 - p1) + 3.0*t*t*(p3 - p2);
+
+    // same frame the CPU sweep uses.  A handle of zero length leaves no derivative at its end
+    // point, where the chord gives the direction instead, and a fully collapsed patch falls back
+    // to +X like TrackGeometry::ringTangent
+    vec3 heading = length(derivative) > 1e-6 ? derivative : p3 - p0;
+    vec3 tangent = length(heading) > 1e-6 ? normalize(heading) : vec3(1.0, 0.0, 0.0);
+    vec3 normal = ringNormal(tangent, patchKnotNormal[0], patchKnotNormal[3], t);
+    vec3 binormal = cross(tangent, normal);
+
+    float angle = gl_TessCoord.y * 2.0 * PI;
+    vec3 direction = cos(angle) * normal + sin(angle) * binormal;
+    vec3 pos = point + tubeRadius * direction;
+
+    // transform & output the vertex in clip space
+    gl_Position = mvpMatrix * vec4(pos, 1.0);
+
+    transNormalVector = normalize(normalMatrix * direction);
+    viewVector = normalize(cameraPos - pos);
+
+    fspotDir = normalize(spotlightPos - pos);
+    spotlightDist = distance(pos, spotlightPos);
+
+    matColor = materialColor;
+    textCoordinate = gl_TessCoord.xy;
+}
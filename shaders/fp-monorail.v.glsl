@@ -0,0 +1,18 @@
+#version 410 core
+
+// attribute inputs
+layout(location = 0) in vec3 vPos;      // Bezier control point in world space
+layout(location = 1) in vec3 vKnotNormal;   // ring frame normal at the control point, if it ends a curve
+
+// uniform inputs
+uniform vec3 positionOffset = vec3(0.0);    // moves world space to the view's origin
+
+// varying outputs
+out vec3 controlPoint;
+out vec3 knotNormal;
+
+void main() {
+    // control points only move to the view's origin, the tessellation stages do the work
+    controlPoint = vPos + positionOffset;
+    knotNormal = vKnotNormal;
+}
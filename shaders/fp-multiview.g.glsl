@@ -0,0 +1,51 @@
+#version 410 core
+
+// replicates each triangle into every view in one pass: one invocation per view, each
+// projecting the triangle with its view's matrices and routing it to its own viewport
+#define MAX_VIEWS 4                     // must match FPEngine::MAX_VIEWS
+layout(triangles, invocations = MAX_VIEWS) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+// uniform inputs
+uniform mat4 viewProjMatrices[MAX_VIEWS];   // per view projection * view matrix
+uniform vec3 cameraPositions[MAX_VIEWS];    // per view camera position relative to the shared origin
+uniform int numViews;                       // views in use, extra invocations emit nothing
+
+// varying inputs, gl_Position holds the position relative to the shared view origin in multi-view mode
+layout(location = 0) in vec3 vertexMatColor[];
+layout(location = 1) in vec2 vertexTextCoordinate[];
+
+layout(location = 2) in vec3 vertexTransNormalVector[];
+
+layout(location = 4) in vec3 vertexFspotDir[];
+layout(location = 5) in float vertexSpotlightDist[];
+
+// varying outputs, matching fp-std.f.glsl
+layout(location = 0) out vec3 matColor;
+layout(location = 1) out vec2 textCoordinate;
+
+layout(location = 2) out vec3 transNormalVector;
+layout(location = 3) out vec3 viewVector;
+
+layout(location = 4) out vec3 fspotDir;
+layout(location = 5) out float spotlightDist;
+
+void main() {
+    if (gl_InvocationID >= numViews) return;
+
+    for (int i = 0; i < 3; i++) {
+        vec3 worldPos = gl_in[i].gl_Position.xyz;
+        gl_Position = viewProjMatrices[gl_InvocationID] * gl_in[i].gl_Position;
+        gl_ViewportIndex = gl_InvocationID;
+
+        matColor = vertexMatColor[i];
+        textCoordinate = vertexTextCoordinate[i];
+        transNormalVector = vertexTransNormalVector[i];
+        // the eye differs per view, so the view vector is recomputed here
+        viewVector = normalize(cameraPositions[gl_InvocationID] - worldPos);
+        fspotDir = vertexFspotDir[i];
+        spotlightDist = vertexSpotlightDist[i];
+        EmitVertex();
+    }
+    EndPrimitive();
+}
@@ -6,6 +6,9 @@ uniform mat4 modelViewMtx;
 uniform mat3 normalMatrix;              // normal matrix for transforming normals
 uniform vec3 cameraPos;
 uniform vec3 materialColor;             // material color for the object
+// position decode for quantized vertices, identity for full float positions
+uniform vec3 positionOffset = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
 // direction light uniforms
 // spotlight uniforms
 uniform vec3 spotlightPos;
@@ -26,16 +29,19 @@ layout(location = 5) out float spotlightDist;
 
 
 void main() {
+    // decode the object space position
+    vec3 pos = positionOffset + positionScale * vPos;
+
     // transform & output the vertex in clip space
-    gl_Position = mvpMatrix * vec4(vPos, 1.0);
+    gl_Position = mvpMatrix * vec4(pos, 1.0);
 
     transNormalVector = normalize(normalMatrix * vNormal);
-    viewVector = normalize(cameraPos - vPos);
+    viewVector = normalize(cameraPos - pos);
 
-    vec3 worldPos = vec3(modelViewMtx * vec4(vPos, 1.0));
+    vec3 worldPos = vec3(modelViewMtx * vec4(pos, 1.0));
     vec3 spotlightWorldPos = vec3(modelViewMtx * vec4(spotlightPos, 1.0));
-    fspotDir = normalize(spotlightPos - vPos);
-    spotlightDist = distance(vPos, spotlightPos);
+    fspotDir = normalize(spotlightPos - pos);
+    spotlightDist = distance(pos, spotlightPos);
 
     matColor = materialColor;
     // Pass texture coordinate to fragment shader
@@ -0,0 +1,41 @@
+#version 430 core
+
+// samples every cubic Bezier curve of the track at evenly spaced parameters, one invocation
+// per sample, matching TrackGeometry::sampleCurve
+#define WORK_GROUP_SIZE 64              // must match TrackBuilder::WORK_GROUP_SIZE
+layout(local_size_x = WORK_GROUP_SIZE) in;
+
+// uniform inputs
+uniform int invocationOffset;           // invocations run by earlier dispatches of this pass
+uniform int firstCurve;                 // first curve to sample
+uniform int numSamples;                 // samples to write, a whole number of curves
+uniform int resolution;                 // segments per curve, each curve has resolution + 1 samples
+
+// tightly packed vec3 arrays, read and written a float at a time
+layout(std430, binding = 0) readonly buffer ControlPoints { float controlPoints[]; };
+layout(std430, binding = 1) writeonly buffer Samples { float samples[]; };
+
+vec3 controlPoint(int i) {
+    return vec3(controlPoints[3 * i], controlPoints[3 * i + 1], controlPoints[3 * i + 2]);
+}
+
+void main() {
+    int invocation = invocationOffset + int(gl_GlobalInvocationID.x);
+    if (invocation >= numSamples) return;
+
+    int curve = firstCurve + invocation / (resolution + 1);
+    int j = invocation % (resolution + 1);
+    float t = float(j) / float(resolution);
+    float s = 1.0 - t;
+
+    // consecutive curves share their end point, so curve i starts at control point 3i
+    vec3 point = s * s * s * controlPoint(3 * curve)
+               + 3.0 * s * s * t * controlPoint(3 * curve + 1)
+               + 3.0 * s * t * t * controlPoint(3 * curve + 2)
+               + t * t * t * controlPoint(3 * curve + 3);
+
+    int sampleIndex = curve * (resolution + 1) + j;
+    samples[3 * sampleIndex] = point.x;
+    samples[3 * sampleIndex + 1] = point.y;
+    samples[3 * sampleIndex + 2] = point.z;
+}
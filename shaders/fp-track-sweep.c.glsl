@@ -0,0 +1,96 @@
+#version 430 core
+
+// sweeps the monorail tube around the curve samples and packs it, one invocation per vertex,
+// matching TrackGeometry::sweepRings followed by VertexFormat::pack
+#define WORK_GROUP_SIZE 64              // must match TrackBuilder::WORK_GROUP_SIZE
+#define PI 3.14159265358979
+layout(local_size_x = WORK_GROUP_SIZE) in;
+
+// uniform inputs
+uniform int invocationOffset;           // invocations run by earlier dispatches of this pass
+uniform int firstChunk;                 // first chunk to build
+uniform int numVertices;                // vertices to write, a whole number of full chunks
+uniform int numRings;                   // curve samples, one ring at each
+uniform int chunkRings;                 // rings per chunk, each chunk stores chunkRings + 1 rings
+uniform int segments;                   // vertices around each ring
+uniform int resolution;                 // segments each curve is sampled into
+uniform float radius;                   // tube radius
+
+// tightly packed vec3 samples, PackedVertex as four words, the decode box of each chunk, and the
+// tightly packed vec3 knot normal beside every control point
+layout(std430, binding = 0) readonly buffer Samples { float samples[]; };
+layout(std430, binding = 1) writeonly buffer Vertices { uint vertices[]; };
+layout(std430, binding = 2) readonly buffer ChunkBounds { vec4 chunkBounds[]; };
+layout(std430, binding = 3) readonly buffer KnotNormals { float knotNormals[]; };
+
+vec3 curveSample(int i) {
+    return vec3(samples[3 * i], samples[3 * i + 1], samples[3 * i + 2]);
+}
+
+// direction to the next sample, stepping back past repeated samples like TrackGeometry::ringTangent
+vec3 ringTangent(int ring) {
+    for (int r = ring; r >= 0; r--) {
+        vec3 delta = r + 1 < numRings ? curveSample(r + 1) - curveSample(r) : curveSample(r) - curveSample(r - 1);
+        if (length(delta) > 1e-6) return normalize(delta);
+    }
+    return vec3(1.0, 0.0, 0.0);
+}
+
+vec3 knotNormal(int knot) {
+    return vec3(knotNormals[9 * knot], knotNormals[9 * knot + 1], knotNormals[9 * knot + 2]);
+}
+
+// ring normal with no frame to carry on from, matching TrackGeometry::ringNormal
+vec3 ringNormal(vec3 tangent) {
+    vec3 up = abs(tangent.y) > 0.999 ? vec3(1.0, 0.0, 0.0) : vec3(0.0, 1.0, 0.0);
+    return normalize(cross(tangent, up));
+}
+
+// knot normals blended and carried onto the tangent, matching TrackGeometry::ringNormal
+vec3 ringNormal(vec3 tangent, vec3 startNormal, vec3 endNormal, float t) {
+    vec3 normal = mix(startNormal, endNormal, t);
+    vec3 projected = normal - dot(normal, tangent) * tangent;
+    return length(projected) > 1e-3 ? normalize(projected) : ringNormal(tangent);
+}
+
+// signed 10-bit components of a GL_INT_2_10_10_10_REV normal, x in the low bits
+uint packNormal(vec3 normal) {
+    ivec3 quantized = ivec3(round(clamp(normal, -1.0, 1.0) * 511.0));
+    return (uint(quantized.x) & 0x3FFu) | ((uint(quantized.y) & 0x3FFu) << 10) | ((uint(quantized.z) & 0x3FFu) << 20);
+}
+
+void main() {
+    int invocation = invocationOffset + int(gl_GlobalInvocationID.x);
+    if (invocation >= numVertices) return;
+
+    int chunkVertices = (chunkRings + 1) * segments;
+    int chunk = invocation / chunkVertices;
+    int local = invocation % chunkVertices;
+    int ring = (firstChunk + chunk) * chunkRings + local / segments;
+    // the last chunk is usually short
+    if (ring >= numRings) return;
+    int segment = local % segments;
+
+    vec3 tangent = ringTangent(ring);
+    int curve = ring / (resolution + 1);
+    float t = float(ring % (resolution + 1)) / float(resolution);
+    vec3 normal = ringNormal(tangent, knotNormal(curve), knotNormal(curve + 1), t);
+    vec3 binormal = cross(tangent, normal);
+    float angle = float(segment) * 2.0 * PI / float(segments);
+    vec3 direction = cos(angle) * normal + sin(angle) * binormal;
+    vec3 position = curveSample(ring) + radius * direction;
+
+    // a flat axis stores 0 and decodes to the origin
+    vec3 origin = chunkBounds[2 * chunk].xyz;
+    vec3 extent = chunkBounds[2 * chunk + 1].xyz;
+    vec3 normalized = vec3(0.0);
+    for (int axis = 0; axis < 3; axis++) {
+        if (extent[axis] > 0.0) normalized[axis] = (position[axis] - origin[axis]) / extent[axis];
+    }
+
+    int vertex = 4 * ((firstChunk + chunk) * chunkVertices + local);
+    vertices[vertex] = packUnorm2x16(normalized.xy);
+    vertices[vertex + 1] = packUnorm2x16(vec2(normalized.z, 0.0));
+    vertices[vertex + 2] = packNormal(direction);
+    vertices[vertex + 3] = 0u;              // both half-float texture coordinates are 0
+}
@@ -0,0 +1,51 @@
+#version 410 core
+
+// edge-aware upscale of the dynamically scaled scene into the window
+
+// uniform inputs
+uniform sampler2D sceneTexture;
+uniform vec2 texelSize;         // one scene texel in texture coordinates
+uniform vec2 renderedSize;      // part of the texture the scene was rendered into, in texture coordinates
+uniform float sharpness;        // 0 keeps the filtered color, 1 restores the full local contrast
+
+// varying inputs
+layout(location = 0) in vec2 windowCoord;
+
+// fragment outputs
+out vec4 fragColorOut;
+
+vec3 fetch(vec2 coord) {
+    // never filter in texels outside the rendered region
+    return texture(sceneTexture, clamp(coord, 0.5 * texelSize, renderedSize - 0.5 * texelSize)).rgb;
+}
+
+float luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main() {
+    vec2 coord = windowCoord * renderedSize;
+    vec3 center = fetch(coord);
+    vec3 north = fetch(coord + vec2(0.0, texelSize.y));
+    vec3 south = fetch(coord - vec2(0.0, texelSize.y));
+    vec3 east = fetch(coord + vec2(texelSize.x, 0.0));
+    vec3 west = fetch(coord - vec2(texelSize.x, 0.0));
+
+    // an edge runs perpendicular to the luma gradient.  Blending only along it smooths the
+    // stair steps of the low resolution edge without blurring the two sides together
+    vec3 color = center;
+    vec2 gradient = vec2(luma(east) - luma(west), luma(north) - luma(south));
+    float edgeStrength = length(gradient);
+    if (edgeStrength > 1.0 / 64.0) {
+        vec2 along = vec2(-gradient.y, gradient.x) / edgeStrength * texelSize;
+        vec3 alongEdge = 0.5 * (fetch(coord + along) + fetch(coord - along));
+        color = mix(center, alongEdge, clamp(edgeStrength * 4.0, 0.0, 0.5));
+    }
+
+    // restore the contrast lost to bilinear filtering, limited to the neighbourhood's range
+    // so edges cannot ring
+    vec3 minColor = min(center, min(min(north, south), min(east, west)));
+    vec3 maxColor = max(center, max(max(north, south), max(east, west)));
+    vec3 blurred = 0.25 * (north + south + east + west);
+    fragColorOut = vec4(clamp(color + sharpness * (color - blurred), minColor, maxColor), 1.0);
+}